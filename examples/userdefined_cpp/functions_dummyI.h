@@ -0,0 +1,37 @@
+#ifndef dummyI_integral_distsrc_functions_h_included
+#define dummyI_integral_distsrc_functions_h_included
+
+/*
+ * The `functions` of the dummyI example for the distributed
+ * evaluator (see 'distsrc/functions.h' in the generated
+ * package for the instructions). The scalar definitions are
+ * required; "dum1" also has a vector version, which the CPU
+ * kernels use instead of evaluating the scalar version lane
+ * by lane whenever all four arguments are vectors.
+ */
+
+mathfn result_t dum1(const real_t &arg0, const real_t &arg1, const real_t &arg2, const real_t &arg3)
+{
+    return arg0*arg0 + pow(arg1,3) + pow(arg2,4) + pow(arg3,5) + 4*arg0*arg1*arg2*arg3 + 2 - arg0*arg0*pow(arg1,3)*pow(arg2,4)*pow(arg3,5);
+}
+
+mathfn result_t dum2(const real_t &arg0, const real_t &arg1, const real_t &arg2)
+{
+    return arg0*arg0 + arg1*arg1 + arg2*arg2 + 4*arg0*arg1 + 3*arg0*arg0*arg1*arg1 - sqrt(arg0*arg1*arg2);
+}
+
+#ifndef __CUDACC__
+mathfn realvec_t dum1(const realvec_t &arg0, const realvec_t &arg1, const realvec_t &arg2, const realvec_t &arg3)
+{
+    realvec_t arg00 = arg0*arg0, arg111 = arg1*arg1*arg1, arg2222 = (arg2*arg2)*(arg2*arg2), arg33333 = (arg3*arg3)*(arg3*arg3)*arg3;
+    return arg00 + arg111 + arg2222 + arg33333 + 4*arg0*arg1*arg2*arg3 + 2 - arg00*arg111*arg2222*arg33333;
+}
+#endif
+
+// Lane-by-lane fallbacks; these must follow the scalar definitions.
+DEF_LANEWISE_FUNCTION(ddum1d0)
+DEF_LANEWISE_FUNCTION(ddum2d0)
+DEF_LANEWISE_FUNCTION(dum1)
+DEF_LANEWISE_FUNCTION(dum2)
+
+#endif
@@ -33,3 +33,5 @@ if __name__ == "__main__":
 
     # copy 'functions.hpp' (predefined for this example) to required directory
     shutil.copy('functions_dummyI.hpp','dummyI/dummyI_integral/src/functions.hpp')
+    # and its counterpart for the distributed evaluator
+    shutil.copy('functions_dummyI.h','dummyI/dummyI_integral/distsrc/functions.h')
@@ -96,6 +96,19 @@ class CheckLib(unittest.TestCase):
         self.check_result(str_integral_with_prefactor_1, self.target_result_with_prefactor_1, self.epsrel, self.epsabs, self.order_min_1, self.order_max_1)
         self.check_result(str_integral_with_prefactor_2, self.target_result_with_prefactor_2, self.epsrel, self.epsabs, self.order_min_2, self.order_max_2)
         
+    def test_Qmc_workers(self):
+        # choose integrator
+        self.lib.use_Qmc(epsrel=self.epsrel, maxeval=self.maxeval, epsabs=self.epsabs, verbosity=0, seed=143, transform='korobov3')
+
+        # integrate in worker processes
+        str_integral_without_prefactor, str_prefactor, str_integral_with_prefactor = self.lib(self.real_parameters, self.complex_parameters, workers=['../easy_sum/worker_easy_sum']*2)
+
+        str_integral_with_prefactor_1, str_integral_with_prefactor_2 = str_integral_with_prefactor.strip().split('\n')
+
+        # check integral
+        self.check_result(str_integral_with_prefactor_1, self.target_result_with_prefactor_1, self.epsrel, self.epsabs, self.order_min_1, self.order_max_1)
+        self.check_result(str_integral_with_prefactor_2, self.target_result_with_prefactor_2, self.epsrel, self.epsabs, self.order_min_2, self.order_max_2)
+
     def test_disteval(self):
         # integrate
         result = self.distlib(parameters={'s':self.real_parameters[0]}, epsrel=self.epsrel, epsabs=self.epsabs, format='json', verbose=False)
@@ -7,25 +7,28 @@ This module implements the main program - the function
 from ..metadata import git_id
 from ..misc import sympify_symbols, rangecomb, make_cpp_list, chunks, version
 from ..algebra import _Expression, Expression, Polynomial, \
-                      ExponentiatedPolynomial, Pow, Product, \
+                      ExponentiatedPolynomial, LogOfPolynomial, Pow, Product, \
                       ProductRule, Function, Sum, sympify_expression
 from .. import decomposition
 from ..matrix_sort import iterative_sort, Pak_sort, light_Pak_sort
 from ..subtraction import integrate_pole_part, integrate_by_parts, pole_structure as compute_pole_structure
 from ..expansion import expand_singular, expand_Taylor, expand_ginac, OrderError
 from ..misc import lowest_order, parallel_det, det
-from .template_parser import validate_pylink_qmc_transforms, generate_pylink_qmc_macro_dict, parse_template_file, parse_template_tree
+from .template_parser import validate_pylink_qmc_transforms, generate_pylink_qmc_macro_dict, generate_pylink_qmc_transform_selection, \
+                             parse_template_file, parse_template_tree
 from itertools import chain, repeat
 from multiprocessing import Pool
 from time import strftime
-from re import match
+from re import match, findall, MULTILINE
 from .. import formset
-from collections import namedtuple
+from collections import namedtuple, Counter
+import hashlib
 import inspect
 import numpy as np
 import sympy as sp
 import json
 import os
+import shutil
 import sys
 import pySecDecContrib
 
@@ -46,6 +49,7 @@ internal_prefix = 'SecDecInternal'
 FORM_names = dict(
     cal_I=internal_prefix+'CalI',
     real_part=internal_prefix+'RealPart',
+    taylor_switch=internal_prefix+'TaylorSwitch',
     cast_polynomial=internal_prefix+'DecoPoly',
     other_polynomial=internal_prefix+'OtherPoly',
     remainder_expression=internal_prefix+'Remainder',
@@ -329,13 +333,203 @@ def get_decomposition_routines(name, normaliz, workdir):
                                     )
     return _decomposition_strategies[name]
 
+# the candidates tried by the automatic choice of the decomposition method
+automatic_decomposition_methods = dict(
+                                          auto=('iterative', 'geometric', 'geometric_ku'),
+                                          auto_no_primary=('iterative_no_primary', 'geometric_no_primary')
+                                      )
+
+def _splitting_strategy(strategy, split, use_symmetries, use_iterative_sort, use_light_Pak, use_Pak, dreadnaut_executable, name):
+    '''
+    Return the decomposition routines `strategy`
+    modified to split the integration region where
+    the polynomials vanish at the upper boundary,
+    implemented as additional primary decomposition.
+
+    '''
+    def primary_decomposition_with_splitting(sector, indices):
+        # investigate symmetries before the split
+        if use_symmetries:
+            primary_sectors = _reduce_sectors_by_symmetries\
+            (
+                list(  strategy['primary'](sector, indices)  ),
+                'number of primary sectors',
+                indices[:-1], # primary decomposition removes one integration variable
+                use_iterative_sort,
+                use_light_Pak,
+                use_Pak,
+                dreadnaut_executable,
+                name
+            )
+        else:
+            primary_sectors = strategy['primary'](sector, indices)
+        for output_sector in primary_sectors:
+            yield output_sector
+
+    def secondary_decomposition_with_splitting(sector, indices, split_sectors=None):
+        if split_sectors is None:
+            # split and decompose the `sector`
+            split_sectors = decomposition.splitting.split_singular(sector, split, indices)
+        for split_sector in split_sectors:
+            for decomposed_sector in strategy['secondary'](split_sector, indices):
+                # check if another split is necessary
+                split_decomposed_sector = list( decomposition.splitting.split_singular(decomposed_sector, split, indices) )
+                if len(split_decomposed_sector) == 1:
+                    yield decomposed_sector
+                else:
+                    for deeper_sector in secondary_decomposition_with_splitting(decomposed_sector, indices, split_decomposed_sector):
+                        yield deeper_sector
+
+    return dict(primary=primary_decomposition_with_splitting, secondary=secondary_decomposition_with_splitting)
+
+def _unify_primary_sector_symbols(primary_sectors):
+    '''
+    Rename the `integration_variables` in all
+    `primary_sectors` to those of the first one.
+
+    '''
+    symbols_primary_sectors = primary_sectors[0].Jacobian.polysymbols
+    for sector in primary_sectors:
+        sector.Jacobian.polysymbols = list(symbols_primary_sectors) # copy
+        for prod in sector.cast:
+            for factor in prod.factors:
+                factor.polysymbols = list(symbols_primary_sectors) # copy
+        for poly in sector.other:
+            poly.polysymbols = list(symbols_primary_sectors) # copy
+
+def _estimate_decomposition_cost(sectors, number_of_other_symbols):
+    '''
+    Estimate the cost of the code generated for the
+    `sectors` from the number of terms in their
+    polynomials and the number of integration variables.
+    The subtraction, the expansion, and the evaluation of
+    the integrand all grow with the number of terms times
+    the number of variables that can be differentiated by.
+
+    '''
+    cost = 0
+    for sector in sectors:
+        dimension = len(sector.Jacobian.polysymbols) - number_of_other_symbols
+        terms = len(sector.Jacobian.coeffs)
+        for prod in sector.cast:
+            terms += sum(len(factor.coeffs) for factor in prod.factors)
+        for poly in sector.other:
+            terms += len(poly.coeffs)
+        cost += terms * dimension
+    return cost
+
+def _decompose_for_cost_estimate(args):
+    '''
+    Run the decomposition `method` on the `initial_sector`
+    up to the symmetry reduction, and return the number of
+    sectors, the estimated cost, and the sectors of the
+    result, or the error message if the decomposition fails.
+    The sectors are returned as the list of primary sectors
+    and the list of secondary sectors to process for each
+    of them; with symmetries, all secondary sectors are
+    processed together with the first primary sector.
+    Called by :func:`._select_decomposition_method`
+    (possibly in a separate process).
+
+    '''
+    method, initial_sector, number_of_other_symbols, split, use_symmetries, \
+    use_iterative_sort, use_light_Pak, use_Pak, dreadnaut_executable, normaliz_executable, name = args
+
+    workdir = os.path.join(name, 'normaliz_workdir_' + method)
+    strategy = get_decomposition_routines(method, normaliz_executable, workdir)
+    number_of_integration_variables = len(initial_sector.Jacobian.polysymbols) - number_of_other_symbols
+    if method == 'geometric' and number_of_integration_variables == 1:
+        strategy = get_decomposition_routines('iterative', normaliz_executable, workdir)
+    if split:
+        strategy = _splitting_strategy(strategy, split, use_symmetries, use_iterative_sort, use_light_Pak, use_Pak, dreadnaut_executable, name)
+
+    # same steps as in :func:`.make_package`
+    try:
+        primary_sectors = list(  strategy['primary'](initial_sector, range(number_of_integration_variables))  )
+        if use_symmetries and not split:
+            if len(primary_sectors) > 1:
+                primary_sectors = _reduce_sectors_by_symmetries(primary_sectors, method + ': number of primary sectors', range(number_of_integration_variables-1),
+                                                                use_iterative_sort, use_light_Pak, use_Pak, dreadnaut_executable, name)
+            _unify_primary_sector_symbols(primary_sectors)
+        secondary_sectors = []
+        for primary_sector in primary_sectors:
+            indices = range(len(primary_sector.Jacobian.polysymbols) - number_of_other_symbols)
+            secondary_sectors.append( list(strategy['secondary'](primary_sector, indices)) )
+        if use_symmetries and not split:
+            secondary_sectors = [
+                                    _reduce_sectors_by_symmetries(list(chain(*secondary_sectors)), method + ': total number sectors', indices,
+                                                                  use_iterative_sort, use_light_Pak, use_Pak, dreadnaut_executable, name)
+                                ]
+    except Exception as error:
+        return None, None, '%s: %s' % (type(error).__name__, error), None
+
+    all_secondary_sectors = list(chain(*secondary_sectors))
+    return len(all_secondary_sectors), _estimate_decomposition_cost(all_secondary_sectors, number_of_other_symbols), None, (primary_sectors, secondary_sectors)
+
+def _select_decomposition_method(candidates, initial_sector, number_of_other_symbols, split, use_symmetries,
+                                 use_iterative_sort, use_light_Pak, use_Pak, dreadnaut_executable,
+                                 normaliz_executable, name, processes):
+    '''
+    Run the decomposition methods `candidates` in parallel
+    up to the symmetry reduction and return the name of
+    the one with the lowest estimated cost together with
+    its sectors as returned by
+    :func:`._decompose_for_cost_estimate`. If there is
+    only one candidate, it is not run and ``None`` is
+    returned in place of the sectors.
+
+    '''
+    candidates = list(candidates)
+    for method in candidates:
+        if method not in automatic_decomposition_methods['auto'] + automatic_decomposition_methods['auto_no_primary'] + ('geometric_infinity_no_primary',):
+            raise ValueError('Unknown `decomposition_method` "%s".' % method)
+    if split and 'geometric' in candidates:
+        # ``split=True`` and ``decomposition_method="geometric"`` are incompatible
+        candidates.remove('geometric')
+    if len(candidates) == 1:
+        return candidates[0], None
+
+    args = [
+               (method, initial_sector.copy(), number_of_other_symbols, split, use_symmetries,
+                use_iterative_sort, use_light_Pak, use_Pak, dreadnaut_executable, normaliz_executable, name)
+               for method in candidates
+           ]
+    if processes is None:
+        try:
+            processes = len(os.sched_getaffinity(0))
+        except AttributeError:
+            processes = os.cpu_count()
+    processes = min(processes, len(candidates))
+    try:
+        if processes > 1:
+            with Pool(processes) as pool:
+                results = pool.map(_decompose_for_cost_estimate, args)
+        else:
+            results = list(map(_decompose_for_cost_estimate, args))
+    finally:
+        # the workdirs of failed `normaliz` runs are left behind
+        for method in candidates:
+            shutil.rmtree(os.path.join(name, 'normaliz_workdir_' + method), ignore_errors=True)
+
+    for method, (number_of_sectors, cost, error, sectors) in zip(candidates, results):
+        if error is None:
+            print('decomposition method "%s": %i sectors, estimated cost %i' % (method, number_of_sectors, cost))
+        else:
+            print('decomposition method "%s" failed:' % method, error)
+    succeeded = [i for i in range(len(candidates)) if results[i][2] is None]
+    if not succeeded:
+        raise RuntimeError('All candidate decomposition methods failed: ' + '; '.join('"%s": %s' % (method, result[2]) for method, result in zip(candidates, results)))
+    best = min(succeeded, key=lambda i: results[i][1])
+    print('choosing decomposition method "%s"' % candidates[best])
+    return candidates[best], results[best][3]
+
 
 # -------------------------------- template parsing ---------------------------------
 def _parse_global_templates(name, regulators, polynomial_names,
                             real_parameters, complex_parameters, form_optimization_level,
                             form_setup, form_insertion_depth, requested_orders,
                             contour_deformation_polynomial, nested_series_type,
-                            enforce_complex):
+                            enforce_complex, update=False):
     '''
     Create the `target_directory` (given by `name`) and return the two
     optional arguments passed to :func:`parse_template_tree`.
@@ -395,6 +589,7 @@ def _parse_global_templates(name, regulators, polynomial_names,
                           'prefactor.cpp' : None,
                           'pole_structures.cpp' : None,
                           'functions.hpp' : None,
+                          'functions.h' : None,
                           'pylink.cpp' : None
                      }
     # needs `number_of_sectors` --> can only be written after the decomposition is completed
@@ -412,7 +607,7 @@ def _parse_global_templates(name, regulators, polynomial_names,
     template_sources = os.path.join(os.path.split(os.path.abspath(__file__))[0],'templates','make_package')
 
     # initialize the target directory with the sector independent files
-    parse_template_tree(template_sources, name, template_replacements, file_renamings)
+    parse_template_tree(template_sources, name, template_replacements, file_renamings, update)
 
     # return parser options
     return template_sources, template_replacements, file_renamings
@@ -577,6 +772,77 @@ def _make_sector_order_names(sector_index, regulator_powers, highest_poles):
         (tuple(p-highest_poles), (sector_index, "_".join(str(pol-hi) for pol, hi in zip(p, highest_poles)).replace("-", "n")))
         for p in regulator_powers))
 
+# the number of terms of a job is zero padded to this many digits in "sector<N>.d"
+_max_codegen_terms = 10**10 - 1
+
+def _estimate_number_of_terms(expression):
+    """
+    Estimate the number of terms of `expression` after
+    expanding it in FORM, counting powers and function
+    calls as single symbols.
+    """
+    if type(expression) in (Polynomial, LogOfPolynomial) or \
+            (isinstance(expression, ExponentiatedPolynomial) and expression.exponent == 1):
+        return sum(_estimate_number_of_terms(coeff) for coeff in expression.coeffs)
+    if isinstance(expression, Sum):
+        return sum(_estimate_number_of_terms(summand) for summand in expression.summands)
+    if isinstance(expression, Product):
+        terms = 1
+        for factor in expression.factors:
+            terms *= _estimate_number_of_terms(factor)
+        return terms
+    if isinstance(expression, ProductRule):
+        return len(expression.coeffs)
+    return 1
+
+def _make_sector_codegen_jobs(sector_index, regulator_powers, highest_poles, order_terms):
+    """
+    Return the FORM jobs generating the orders of a sector,
+    one per order in `regulator_powers` (numbered like
+    in :func:`._make_FORM_shifted_orders`), as a list of
+    (estimated number of terms, target) pairs.
+    """
+    return [
+        (order_terms[tuple(p - highest_poles)], f"codegen/sector{sector_index}.order{k}.info")
+        for k, p in enumerate(regulator_powers, 1)
+    ]
+
+def _read_generated_order_names(info_filename):
+    """
+    Return the set of the order names listed in a
+    `sector<N>.info` file written by FORM, or None if there is
+    no such file.
+    """
+    if not os.path.exists(info_filename):
+        return None
+    with open(info_filename, "r") as f:
+        return set(findall(r"^@order[0-9]+_name=([a-zA-Z0-9_]*)", f.read(), flags=MULTILINE))
+
+def _make_sector_fingerprint(*definitions):
+    """
+    Return a hash of the expressions defining a sector.
+    The items of each list are hashed in sorted order,
+    because their order may differ between runs of python.
+    """
+    hash = hashlib.sha1()
+    for definition in definitions:
+        for item in sorted(map(str, definition)):
+            hash.update(item.encode())
+            hash.update(b"\n")
+        hash.update(b"\0")
+    return hash.hexdigest()
+
+def _read_sector_fingerprint(filename):
+    """
+    Return the fingerprint defined in a `sector<N>.h` file,
+    or None if there is none.
+    """
+    if not os.path.exists(filename):
+        return None
+    with open(filename, "r") as f:
+        fingerprint = findall(r'^#define sectorFingerprint "([0-9a-f]*)"', f.read(), flags=MULTILINE)
+    return fingerprint[0] if fingerprint else None
+
 def _make_sector_cpp_files(sector_index, sector_order_names, contour_deformation):
     """
     Produce a Makefile-formatted list of .cpp files that
@@ -602,7 +868,8 @@ def _make_sector_distsrc_files(sector_order_names):
     """
     orders = sector_order_names.values()
     files = [f"distsrc/sector_{s}_{o}.cpp" for s, o in orders] + \
-            [f"distsrc/sector_{s}_{o}.cu" for s, o in orders]
+            [f"distsrc/sector_{s}_{o}.cu" for s, o in orders] + \
+            [f"distsrc/sector_{s}_{o}.cost.json" for s, o in orders]
     return " \\\n\t".join(files)
 
 def _derivative_muliindex_to_name(basename, multiindex):
@@ -677,6 +944,19 @@ def _make_CXX_function_declaration(function_name, number_of_arguments):
     arguments = ', '.join('T%i arg%i' % (i,i) for i in range(number_of_arguments))
     return '    template<' + template_arguments + '>\n    integrand_return_t ' + function_name + '(' + arguments + ');\n'
 
+def _make_distsrc_function_declaration(function_name, number_of_arguments):
+    '''
+    Write the declaration of the scalar function
+    with name `function_name` and `number_of_arguments`
+    arguments that the distributed evaluator
+    expects in "distsrc/functions.h". The function's
+    return type is set to "result_t". The argument
+    types are left to the user.
+
+    '''
+    arguments = ', '.join('arg%i' % i for i in range(number_of_arguments))
+    return 'mathfn result_t ' + function_name + '(' + arguments + ');'
+
 
 # --------------------------------- algebra helper ---------------------------------
 class RealPartFunction(Function):
@@ -693,6 +973,21 @@ class RealPartFunction(Function):
     def derive(self, index):
         return RealPartFunction(self.symbol, self.arguments[0].derive(index), copy=False)
 
+class TaylorSwitchFunction(Function):
+    '''
+    Symbolic step function that is zero if its first
+    argument is below the threshold given as second
+    argument, and one otherwise. It is treated as a
+    constant; i.e. its derivatives vanish.
+
+    '''
+    def __init__(self, symbol, *arguments, **kwargs):
+        assert len(arguments) == 2, 'A `TaylorSwitchFunction` takes exactly two arguments'
+        super(TaylorSwitchFunction, self).__init__(symbol, *arguments, **kwargs)
+
+    def derive(self, index):
+        return Polynomial(np.zeros([1,self.number_of_variables], dtype=int), np.array([0]), self.symbols, copy=False)
+
 class MaxDegreeFunction(Function):
     '''
     Symbolic function where derivatives
@@ -806,6 +1101,8 @@ def _make_environment(original_environment):
     original_environment.pop('original_decomposition_strategies', None)
     original_environment.pop('primary_sectors', None)
     original_environment.pop('primary_sectors_to_consider', None)
+    original_environment.pop('decomposed_sectors', None)
+    original_environment.pop('precomputed_secondary_sectors', None)
     original_environment.pop('primary_decomposition_with_splitting', None)
     original_environment.pop('secondary_decomposition_with_splitting', None)
 
@@ -888,6 +1185,8 @@ def _process_secondary_sector(environment):
     template_replacements = environment['template_replacements']
     prefactor = environment['prefactor']
     pylink_qmc_transforms = environment['pylink_qmc_transforms']
+    subtraction_taylor_threshold = environment['subtraction_taylor_threshold']
+    extend = environment['extend']
     if contour_deformation_polynomial is not None:
         contourdef_Jacobian_determinant = environment['contourdef_Jacobian_determinant']
         contourdef_Jacobian = environment['contourdef_Jacobian']
@@ -905,6 +1204,10 @@ def _process_secondary_sector(environment):
 
     print('writing FORM files for sector', sector_index)
 
+    # identify the sector by its decomposed polynomials, which do
+    # not depend on the `requested_orders`
+    sector_fingerprint = _make_sector_fingerprint([sector.Jacobian], sector.cast, sector.other)
+
     def parse_exponents(sector, symbols_polynomials_to_decompose, symbols_other_polynomials):
         #  - in ``sector.cast``
         for product in sector.cast:
@@ -1131,9 +1434,16 @@ def _process_secondary_sector(environment):
     # Integrate by parts until the `ibp_power_goal` is reached,
     # then do the original subtraction (`integrate_pole_part`).
     after_ibp = integrate_by_parts(subtraction_initializer, ibp_power_goal_this_primary_sector, integration_variable_indices)
+    if subtraction_taylor_threshold is None:
+        taylor_switch = None
+    else:
+        # evaluate the subtracted remainder by its Taylor expansion
+        # where the integration variable is below the threshold
+        symbolic_taylor_threshold = Polynomial(np.zeros([1,len(symbols_polynomials_to_decompose)], dtype=int), np.array([sp.Rational(str(subtraction_taylor_threshold))]), symbols_polynomials_to_decompose, copy=False)
+        taylor_switch = lambda index: TaylorSwitchFunction(FORM_names['taylor_switch'], elementary_monomials[index].copy(), symbolic_taylor_threshold.copy(), copy=False)
     subtracted = []
     for item in after_ibp:
-        subtracted.extend(  integrate_pole_part(item, *integration_variable_indices)  )
+        subtracted.extend(  integrate_pole_part(item, *integration_variable_indices, taylor_switch=taylor_switch)  )
 
     # intialize expansion
     pole_parts = [s.factors[1].simplify() for s in subtracted]
@@ -1141,6 +1451,7 @@ def _process_secondary_sector(environment):
 
     # expand poles
     integrand_summands = []
+    order_terms = Counter() # estimated number of terms per regulator order, for scheduling FORM
     for i,(regular,singular) in enumerate(zip(regular_parts, pole_parts)):
         # must expand every term to the requested order plus the highest pole it multiplies
         # We calculated the highest pole order of the prefactor (variable ``highest_prefactor_pole_orders``) above.
@@ -1172,6 +1483,16 @@ def _process_secondary_sector(environment):
 
         integrand_summands.append( Product(singular_expanded,regular_expanded,copy=False) )
 
+        singular_orders = Counter()
+        for expolist, coeff in zip(singular_expanded.expolist[:,regulator_indices], singular_expanded.coeffs):
+            singular_orders[tuple(expolist)] += _estimate_number_of_terms(coeff)
+        regular_orders = Counter()
+        for expolist, coeff in zip(regular_expanded.expolist[:,regulator_indices], regular_expanded.coeffs):
+            regular_orders[tuple(expolist)] += _estimate_number_of_terms(coeff)
+        for singular_order, singular_terms in singular_orders.items():
+            for regular_order, regular_terms in regular_orders.items():
+                order_terms[tuple(np.add(singular_order, regular_order))] += singular_terms * regular_terms
+
     integrand = Sum(*integrand_summands, copy=False)
 
     # update the `lowest_orders`
@@ -1306,9 +1627,14 @@ def _process_secondary_sector(environment):
         derivative_symbols = call.derivative_symbols
         functions.update(derivative_symbols)
         for derivative_symbol in derivative_symbols:
-            function_declarations.add( _make_CXX_function_declaration(derivative_symbol, number_of_arguments) )
+            function_declarations.add( (derivative_symbol, number_of_arguments) )
     other_functions.extend(functions)
 
+    # the switch between the subtracted integrand and its Taylor expansion
+    # is defined in "SecDecInternalFunctions.hpp"
+    if subtraction_taylor_threshold is not None:
+        other_functions.append(FORM_names['taylor_switch'])
+
     # remove repetitions in `decomposed_polynomial_derivatives`
     decomposed_polynomial_derivatives = set(decomposed_polynomial_derivatives)
     ordered_decomposed_derivative_names = set(ordered_decomposed_derivative_names)
@@ -1350,16 +1676,40 @@ def _process_secondary_sector(environment):
 
     # generate list over all occuring orders in the regulators
     regulator_powers = list( rangecomb(np.zeros_like(required_orders), required_orders + highest_poles_current_sector) )
-    number_of_orders = len(regulator_powers)
 
     # generate the definitions of the FORM preprocessor variables "shiftedRegulator`regulatorIndex'PowerOrder`shiftedOrderIndex'"
     sector_order_names = _make_sector_order_names(sector_index, regulator_powers, highest_poles_current_sector)
     sector_cpp_files = _make_sector_cpp_files(sector_index, sector_order_names, contour_deformation_polynomial is not None)
     sector_distsrc_files = _make_sector_distsrc_files(sector_order_names)
+
+    # When extending an existing package, FORM only generates the
+    # orders that the sector does not have yet; export_sector then
+    # merges in the previous ones from "sector<N>.prev.info". The
+    # sectors may be enumerated differently than in the last run,
+    # so all orders are generated again if the fingerprint of the
+    # sector has changed.
+    write_codegen_sources = True
+    if extend:
+        info_filename = os.path.join(name, 'codegen', 'sector%i.info' % sector_index)
+        prev_info_filename = os.path.join(name, 'codegen', 'sector%i.prev.info' % sector_index)
+        generated_order_names = _read_generated_order_names(info_filename)
+        if generated_order_names is not None and \
+                _read_sector_fingerprint(os.path.join(name, 'codegen', 'sector%i.h' % sector_index)) == sector_fingerprint:
+            regulator_powers = [p for p in regulator_powers
+                                if sector_order_names[tuple(p-highest_poles_current_sector)][1] not in generated_order_names]
+            if regulator_powers:
+                os.replace(info_filename, prev_info_filename)
+            else:
+                write_codegen_sources = False
+        elif os.path.exists(prev_info_filename):
+            os.remove(prev_info_filename)
+    number_of_orders = len(regulator_powers)
+    sector_codegen_jobs = _make_sector_codegen_jobs(sector_index, regulator_powers, highest_poles_current_sector, order_terms)
     regulator_powers = _make_FORM_shifted_orders(regulator_powers)
 
     # parse template file "sector.h"
     template_replacements['sector_index'] = sector_index
+    template_replacements['sector_fingerprint'] = sector_fingerprint
     template_replacements['functions'] = _make_FORM_list(other_functions)
     template_replacements['cal_I_derivatives'] = _make_FORM_list(cal_I_derivative_functions)
     template_replacements['decomposed_polynomial_derivatives'] = _make_FORM_list(decomposed_polynomial_derivatives)
@@ -1374,22 +1724,26 @@ def _process_secondary_sector(environment):
     template_replacements['sector_cpp_files'] = sector_cpp_files
     template_replacements['sector_hpp_files'] = sector_cpp_files.replace(".cpp", ".hpp")
     template_replacements['sector_distsrc_files'] = sector_distsrc_files
+    template_replacements['sector_codegen_jobs'] = ' \\\n\t'.join(job for terms, job in sector_codegen_jobs)
+    template_replacements['sector_codegen_priorities'] = ' '.join('%010i:%s' % (_max_codegen_terms - min(terms, _max_codegen_terms), job) for terms, job in sector_codegen_jobs)
     template_replacements['sector_codegen_sources'] = \
             "codegen/sector%i.h" % sector_index if contour_deformation_polynomial is None else \
             "codegen/sector%i.h codegen/contour_deformation_sector%i.h" % (sector_index, sector_index)
     template_replacements['default_qmc_transform'] = pylink_qmc_transforms[0]
-    parse_template_file(os.path.join(template_sources, 'codegen', 'sector.h'), # source
-                        os.path.join(name,             'codegen', 'sector%i.h' % sector_index), # dest
-                        template_replacements)
-    parse_template_file(os.path.join(template_sources, 'codegen', 'sector.d'), # source
-                        os.path.join(name,             'codegen', 'sector%i.d' % sector_index), # dest
-                        template_replacements)
+    if write_codegen_sources:
+        parse_template_file(os.path.join(template_sources, 'codegen', 'sector.h'), # source
+                            os.path.join(name,             'codegen', 'sector%i.h' % sector_index), # dest
+                            template_replacements)
+        parse_template_file(os.path.join(template_sources, 'codegen', 'sector.d'), # source
+                            os.path.join(name,             'codegen', 'sector%i.d' % sector_index), # dest
+                            template_replacements, extend)
     for key in 'functions', 'cal_I_derivatives', 'decomposed_polynomial_derivatives','insert_cal_I_procedure','insert_other_procedure','insert_decomposed_procedure', \
             'integrand_definition_procedure','highest_regulator_poles','required_orders','regulator_powers','number_of_orders', \
-            'sector_index', 'sector_cpp_files', 'sector_hpp_files', 'sector_distsrc_files', 'sector_codegen_sources':
+            'sector_index', 'sector_cpp_files', 'sector_hpp_files', 'sector_distsrc_files', 'sector_codegen_sources', \
+            'sector_codegen_jobs', 'sector_codegen_priorities', 'sector_fingerprint':
         del template_replacements[key]
 
-    if contour_deformation_polynomial is not None:
+    if contour_deformation_polynomial is not None and write_codegen_sources:
         # parse template file "contour_deformation.h"
         template_replacements['contourdef_Jacobian_derivative_functions'] = _make_FORM_list(contourdef_Jacobian_derivative_functions)
         template_replacements['deformed_integration_variable_derivative_functions'] = _make_FORM_list(deformed_integration_variable_derivative_functions)
@@ -1440,7 +1794,8 @@ def make_package(name, integration_variables, regulators, requested_orders,
                  form_insertion_depth=5, contour_deformation_polynomial=None, positive_polynomials=[],
                  decomposition_method='geometric_no_primary', normaliz_executable=None,
                  enforce_complex=False, split=False, ibp_power_goal=-1, use_iterative_sort=True,
-                 use_light_Pak=True, use_dreadnaut=False, use_Pak=True, processes=None, pylink_qmc_transforms=['korobov3x3']):
+                 use_light_Pak=True, use_dreadnaut=False, use_Pak=True, processes=None, pylink_qmc_transforms=['korobov3x3'],
+                 subtraction_taylor_threshold=None, extend=False):
     r'''
     Decompose, subtract and expand an expression.
     Return it as c++ package.
@@ -1640,6 +1995,21 @@ def make_package(name, integration_variables, regulators, requested_orders,
         In order to compute loop integrals, please use the
         function :func:`pySecDec.loop_integral.loop_package`.
 
+        Alternatively, the cheapest of several strategies can
+        be chosen automatically:
+
+        * 'auto': choose from 'iterative', 'geometric', and
+          'geometric_ku'.
+        * 'auto_no_primary': choose from 'iterative_no_primary'
+          and 'geometric_no_primary'.
+        * a list of strategy names: choose from these.
+
+        The candidates are run in parallel up to the symmetry
+        reduction of the sectors; the one with the smallest
+        sum over the sectors of the number of terms in their
+        polynomials times the number of integration variables
+        is used for the rest of the computation.
+
     :param normaliz_executable:
         string, optional;
         The command to run `normaliz`. `normaliz` is only
@@ -1749,6 +2119,47 @@ def make_package(name, integration_variables, regulators, requested_orders,
 
         `New in version 1.5`.
         Default: ``['korobov3x3']``
+
+    :param subtraction_taylor_threshold:
+        float or None, optional;
+        Close to the boundary of a sector, the subtracted
+        integrand is the difference of almost equal numbers,
+        which may lose all significant digits in floating
+        point arithmetic. If a threshold is given, the
+        subtracted integrand is replaced by the next two
+        orders of its Taylor expansion in each subtracted
+        integration variable that is below the threshold.
+        The choice between the two forms is made per point
+        without branching.
+        The Taylor form has a relative truncation error of
+        order ``subtraction_taylor_threshold**2`` (in units of
+        the scale on which the integrand varies, usually of
+        order one), while the subtracted form loses about
+        ``n*log10(1/t)`` digits at a distance ``t`` from
+        the boundary, where ``n`` is the number of subtracted
+        orders. For a single subtraction in double precision
+        the two errors balance at a threshold of about
+        ``1e-5``; larger values trade rounding for truncation
+        error.
+        Default: ``None``
+
+    :param extend:
+        bool, optional;
+        Extend the existing package `name`, generated
+        by a previous call with the same arguments but
+        lower `requested_orders`, instead of creating
+        a new one. The decomposition, subtraction and
+        expansion are redone, but FORM is only run for
+        the orders that a sector does not have yet, and
+        only the files that change are rewritten, so
+        that ``make`` compiles only the new order
+        kernels. Requires that the existing package was
+        built (its ``codegen/sector<N>.info`` files are
+        used to find the existing orders). Sectors
+        that are decomposed differently than in the
+        previous call, e.g. because of a different
+        ``PYTHONHASHSEED``, are generated completely.
+        Default: ``False``
     '''
     print('running "make_package" for "' + name + '"')
 
@@ -1780,7 +2191,7 @@ def make_package(name, integration_variables, regulators, requested_orders,
         real_parameters, complex_parameters, form_optimization_level,
         form_setup, form_insertion_depth, requested_orders,
         contour_deformation_polynomial, nested_series_type,
-        enforce_complex
+        enforce_complex, extend
     )
 
     # get the highest poles from the ``prefactor``
@@ -1793,9 +2204,6 @@ def make_package(name, integration_variables, regulators, requested_orders,
     if normaliz_executable is None:
         normaliz_executable = os.path.join(pySecDecContrib.dirname, 'bin', 'normaliz')
 
-    # get the decomposition routines
-    strategy = get_decomposition_routines(decomposition_method, normaliz_executable, os.path.join(name,'normaliz_workdir'))
-
     # get dreadnaut command if desired
     if use_dreadnaut:
         if isinstance(use_dreadnaut, str):
@@ -1826,6 +2234,40 @@ def make_package(name, integration_variables, regulators, requested_orders,
     # initialize the decomposition
     initial_sector = decomposition.Sector(polynomials_to_decompose, other_polynomials + transformations)
 
+    # investigate if we can take advantage of sector symmetries
+    # We can simplify due to symmetries if the `remainder_expression`
+    # does explicitly not depend on any integration variable and if
+    # we do not split the integration region.
+    remainder_expression_is_trivial = True
+    for i in range(len(integration_variables)):
+        str_replaced_remainder_expression = str(  remainder_expression.replace(i, error_token)  )
+        if str_error_token in str_replaced_remainder_expression:
+            remainder_expression_is_trivial = False
+            break
+    use_symmetries = remainder_expression_is_trivial
+
+    if use_symmetries:
+        # can investigate sector symmetries
+        # we do not need `transformations` in that case --> remove from `initial_sector`
+        for i in range(len(integration_variables)):
+            initial_sector.other.pop()
+
+    # choose the cheapest of several decomposition methods
+    # The primary decomposition is only implemented for loop integrals (see below).
+    if decomposition_method == 'auto' and not remainder_expression_is_trivial:
+        decomposition_method = 'auto_no_primary'
+    decomposed_sectors = None
+    if not isinstance(decomposition_method, str) or decomposition_method in automatic_decomposition_methods:
+        decomposition_method, decomposed_sectors = _select_decomposition_method(
+            automatic_decomposition_methods[decomposition_method] if isinstance(decomposition_method, str) else decomposition_method,
+            initial_sector, len(regulators) + len(polynomial_names), split, use_symmetries,
+            use_iterative_sort, use_light_Pak, use_Pak, dreadnaut_executable if use_dreadnaut else False,
+            normaliz_executable, name, processes
+        )
+
+    # get the decomposition routines
+    strategy = get_decomposition_routines(decomposition_method, normaliz_executable, os.path.join(name,'normaliz_workdir'))
+
     # use iterative method for 1D integrals with Cheng-Wu (avoids problem with 1L tadpole and geometric decomposition)
     if decomposition_method == 'geometric' and len(all_integration_variables) == 1:
         strategy = get_decomposition_routines('iterative', normaliz_executable, os.path.join(name,'normaliz_workdir'))
@@ -1835,44 +2277,8 @@ def make_package(name, integration_variables, regulators, requested_orders,
         # cannot split when using the geometric decomposition method because the integration interval is [0,inf] after the primary decomposition
         if decomposition_method == 'geometric':
             raise ValueError('Cannot have ``split=True`` and ``decomposition_method="geometric"``. You probably want to try ``split=True`` and ``decomposition_method="geometric_ku"``')
-
-        original_decomposition_strategies = strategy
-
-        def primary_decomposition_with_splitting(sector, indices):
-            # investigate symmetries before the split
-            if use_symmetries:
-                primary_sectors = _reduce_sectors_by_symmetries\
-                (
-                    list(  original_decomposition_strategies['primary'](sector, indices)  ),
-                    'number of primary sectors',
-                    indices[:-1], # primary decomposition removes one integration variable
-                    use_iterative_sort,
-                    use_light_Pak,
-                    use_Pak,
-                    dreadnaut_executable if use_dreadnaut else False,
-                    name
-                )
-            else:
-                primary_sectors = original_decomposition_strategies['primary'](sector, indices)
-            for output_sector in primary_sectors:
-                yield output_sector
-
-        def secondary_decomposition_with_splitting(sector, indices, split_sectors=None):
-            if split_sectors is None:
-                # split and decompose the `sector`
-                split_sectors = decomposition.splitting.split_singular(sector, split, indices)
-            for split_sector in split_sectors:
-                for decomposed_sector in original_decomposition_strategies['secondary'](split_sector, indices):
-                    # check if another split is necessary
-                    split_decomposed_sector = list( decomposition.splitting.split_singular(decomposed_sector, split, indices) )
-                    if len(split_decomposed_sector) == 1:
-                        yield decomposed_sector
-                    else:
-                        for deeper_sector in secondary_decomposition_with_splitting(decomposed_sector, indices, split_decomposed_sector):
-                            yield deeper_sector
-
-        # apply modifications to the decomposition strategy
-        strategy = dict(primary=primary_decomposition_with_splitting, secondary=secondary_decomposition_with_splitting)
+        strategy = _splitting_strategy(strategy, split, use_symmetries, use_iterative_sort, use_light_Pak, use_Pak,
+                                       dreadnaut_executable if use_dreadnaut else False, name)
 
     # initialize the counter
     sector_index = 0
@@ -1903,31 +2309,18 @@ def make_package(name, integration_variables, regulators, requested_orders,
             if len(polynomial_names) <= contour_deformation_polynomial_index:
                 raise IndexError('Could not find the `contour_deformation_polynomial` "%s" in `polynomial_names`.' % str_contour_deformation_polynomial)
 
-    # investigate if we can take advantage of sector symmetries
-    # We can simplify due to symmetries if the `remainder_expression`
-    # does explicitly not depend on any integration variable and if
-    # we do not split the integration region.
-    remainder_expression_is_trivial = True
-    for i in range(len(integration_variables)):
-        str_replaced_remainder_expression = str(  remainder_expression.replace(i, error_token)  )
-        if str_error_token in str_replaced_remainder_expression:
-            remainder_expression_is_trivial = False
-            break
-    use_symmetries = remainder_expression_is_trivial
-
     # Check that either the primary decomposition or the `remainder_expression` is trivial.
     # Note that the primary decomposition is specialized for loop integrals.
     if not remainder_expression_is_trivial and decomposition_method not in ('iterative_no_primary', 'geometric_no_primary'):
         raise NotImplementedError('The primary decomposition is only implemented for loop integrals. Please perform the primary decomposition yourself and choose ``decomposition_method="iterative_no_primary"`` or ``decomposition_method="geometric_no_primary"``.')
 
-    if use_symmetries:
-        # can investigate sector symmetries
-        # we do not need `transformations` in that case --> remove from `initial_sector`
-        for i in range(len(integration_variables)):
-            initial_sector.other.pop()
+    # reuse the sectors of the automatic choice of the decomposition method
+    if decomposed_sectors is not None:
+        primary_sectors, precomputed_secondary_sectors = decomposed_sectors
+        primary_sectors_to_consider = [primary_sectors[0]] if use_symmetries and not split else primary_sectors
 
     # symmetries are applied elsewhere if we split
-    if use_symmetries and not split:
+    elif use_symmetries and not split:
         # run primary decomposition and squash symmetry-equal sectors (using both implemented strategies)
         indices = range(len(integration_variables))
         primary_sectors = list(  strategy['primary'](initial_sector, indices)  )
@@ -1945,14 +2338,7 @@ def make_package(name, integration_variables, regulators, requested_orders,
             )
 
         # rename the `integration_variables` in all `primary_sectors` --> must have the same names in all primary sectors
-        symbols_primary_sectors = primary_sectors[0].Jacobian.polysymbols
-        for sector in primary_sectors:
-            sector.Jacobian.polysymbols = list(symbols_primary_sectors) # copy
-            for prod in sector.cast:
-                for factor in prod.factors:
-                    factor.polysymbols = list(symbols_primary_sectors) # copy
-            for poly in sector.other:
-                poly.polysymbols = list(symbols_primary_sectors) # copy
+        _unify_primary_sector_symbols(primary_sectors)
 
         # give one primary sector as representative for the global initialization
         primary_sectors_to_consider = [primary_sectors[0]]
@@ -2083,7 +2469,9 @@ def make_package(name, integration_variables, regulators, requested_orders,
                 if var not in integration_variables:
                     this_primary_sector_remainder_expression = this_primary_sector_remainder_expression.replace(i,1,remove=True)
                     break
-            if use_symmetries and not split:
+            if decomposed_sectors is not None:
+                secondary_sectors = precomputed_secondary_sectors[primary_sector_index]
+            elif use_symmetries and not split:
                 # search for symmetries throughout the secondary decomposition
                 indices = range(len(integration_variables))
                 secondary_sectors = []
@@ -2179,7 +2567,10 @@ def make_package(name, integration_variables, regulators, requested_orders,
         )
 
     # parse the template files "integrands.cpp", "name.hpp", "pole_structures.cpp", "prefactor.cpp", and "functions.hpp"
-    template_replacements['function_declarations'] = '\n'.join(function_declarations)
+    function_declarations = sorted(function_declarations)
+    template_replacements['function_declarations'] = '\n'.join(_make_CXX_function_declaration(*f) for f in function_declarations)
+    template_replacements['distsrc_function_declarations'] = '\n'.join(_make_distsrc_function_declaration(*f) for f in function_declarations)
+    template_replacements['distsrc_lanewise_functions'] = '\n'.join('DEF_LANEWISE_FUNCTION(%s)' % f for f, _ in function_declarations)
     template_replacements['make_integrands_return_t'] = make_integrands_return_t
     template_replacements['prefactor'] = str(expanded_prefactor)
     template_replacements['prefactor_type'] = prefactor_type
@@ -2194,17 +2585,21 @@ def make_package(name, integration_variables, regulators, requested_orders,
     template_replacements['pole_structures_initializer'] = str(pole_structures).replace(' ','').replace("'","").replace('[','{').replace(']','}')
     template_replacements['pylink_qmc_externs'] = ' '.join(pylink_qmc_extern_rules)
     template_replacements['pylink_qmc_cases'] = ' '.join(pylink_qmc_case_rules)
+    template_replacements.update(generate_pylink_qmc_transform_selection(pylink_qmc_transforms))
     parse_template_file(os.path.join(template_sources, 'name.hpp'), # source
                         os.path.join(name,            name + '.hpp'), # dest
-                        template_replacements)
+                        template_replacements, extend)
     for filename in ['integrands.cpp', 'prefactor.cpp', 'pole_structures.cpp', 'functions.hpp']:
         parse_template_file(os.path.join(template_sources, 'src', filename),
                             os.path.join(name,             'src', filename),
-                            template_replacements)
+                            template_replacements, extend)
+    parse_template_file(os.path.join(template_sources, 'distsrc', 'functions.h'),
+                        os.path.join(name,             'distsrc', 'functions.h'),
+                        template_replacements, extend)
     for filename in ['pylink.cpp']:
         parse_template_file(os.path.join(template_sources, 'pylink', filename),
                             os.path.join(name,             'pylink', filename),
-                            template_replacements)
+                            template_replacements, extend)
     for pylink_qmc_transform in pylink_qmc_transform_instantiation_rules:
         #shared_keys = set(pylink_qmc_transform['replacements']).intersection(set(template_replacements))
         #if shared_keys:
@@ -2213,10 +2608,10 @@ def make_package(name, integration_variables, regulators, requested_orders,
         pylink_qmc_transform_replacements.update(pylink_qmc_transform['replacements'])
         parse_template_file(os.path.join(template_sources, 'pylink', pylink_qmc_transform['src']),
                             os.path.join(name,             'pylink', pylink_qmc_transform['dest']),
-                            pylink_qmc_transform_replacements)
+                            pylink_qmc_transform_replacements, extend)
 
     expanded_prefactor = expanded_prefactor.denest()
-    os.mkdir(os.path.join(name, "disteval"))
+    os.makedirs(os.path.join(name, "disteval"), exist_ok=extend)
     descr = {
             "name": name,
             "type": "integral",
@@ -2262,7 +2657,8 @@ def make_package(name, integration_variables, regulators, requested_orders,
     if have_dummy_functions:
         print(
                  "Declarations of the `functions` and their required derivatives are provided\n" + \
-                 "in the file 'src/functions.hpp'. Please refer to that file for further\n" + \
+                 "in the file 'src/functions.hpp', and for the distributed evaluator in\n" + \
+                 "'distsrc/functions.h'. Please refer to these files for further\n" + \
                  "instructions."
              )
 
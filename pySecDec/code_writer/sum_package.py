@@ -1,5 +1,6 @@
 from ..metadata import git_id
-from .template_parser import validate_pylink_qmc_transforms, generate_pylink_qmc_macro_dict, parse_template_file, parse_template_tree
+from .template_parser import validate_pylink_qmc_transforms, generate_pylink_qmc_macro_dict, generate_pylink_qmc_transform_selection, \
+                             parse_template_file, parse_template_tree
 from ..misc import sympify_symbols, make_cpp_list, chunks, version
 from .make_package import make_package
 import pySecDecContrib
@@ -127,14 +128,15 @@ class Coefficient(object):
         parameters = sorted(list(set(re.findall("[a-zA-Z_][a-zA-Z_0-9]*", expression)) - set(exclude_parameters) - ginsh_constant_names))
         return Coefficient(expression, parameters=parameters)
 
-def _generate_one_term(gen_index, sums, complex_parameters, name, package_generator, pylink_qmc_transforms, real_parameters, regulators, replacements_in_files, requested_orders, template_sources):
+def _generate_one_term(gen_index, sums, complex_parameters, name, package_generator, pylink_qmc_transforms, real_parameters, regulators, replacements_in_files, requested_orders, template_sources, extend):
 
     sub_name = package_generator.name
     replacements_in_files['sub_integral_name'] = sub_name
 
     package_generator = package_generator._replace(real_parameters = real_parameters,
                                                    complex_parameters = complex_parameters,
-                                                   pylink_qmc_transforms = pylink_qmc_transforms)
+                                                   pylink_qmc_transforms = pylink_qmc_transforms,
+                                                   extend = extend)
 
     # process coefficients
     lowest_coefficient_orders = {}
@@ -150,6 +152,8 @@ def _generate_one_term(gen_index, sums, complex_parameters, name, package_genera
             filename2 = os.path.join("disteval", "coefficients", f"{sub_name}_coefficient{sumidx}.txt")
             with open(filename,'w') as coeffile:
                 coefficient.write(coeffile)
+            if extend and os.path.exists(filename2):
+                os.remove(filename2)
             os.link(filename, filename2)
     replacements_in_files['lowest_coefficient_orders'] = '{' + '},{'.join(
             ','.join(map(str,lowest_coefficient_orders.get(i, "999999")))
@@ -165,7 +169,7 @@ def _generate_one_term(gen_index, sums, complex_parameters, name, package_genera
         suffix = '_weighted_integral.%spp' % ch
         parse_template_file(os.path.join(template_sources, 'src', 'name' + suffix), # source
                             os.path.join('src', sub_name + suffix), # dest
-                            replacements_in_files)
+                            replacements_in_files, extend)
 
     # Call make_package with its arguments
     mp = make_package(**package_generator._asdict())
@@ -176,7 +180,7 @@ def _generate_one_term(gen_index, sums, complex_parameters, name, package_genera
 def sum_package(name, package_generators, regulators, requested_orders,
                 real_parameters=[], complex_parameters=[], coefficients=None,
                 form_executable=None, pylink_qmc_transforms=['korobov3x3'],
-                processes=1):
+                processes=1, extend=False, combine_integrals=False):
     r'''
     Decompose, subtract and expand a list of expressions
     of the form
@@ -259,6 +263,32 @@ def sum_package(name, package_generators, regulators, requested_orders,
 
         Default: ``1``
 
+    :param extend:
+        bool, optional;
+        Extend the existing package `name`, generated by
+        a previous call with the same arguments but lower
+        `requested_orders`, instead of creating a new one.
+        Only the files that change are rewritten, and only
+        the new orders of the integrals are generated by
+        FORM; see the `extend` argument of
+        :func:`pySecDec.code_writer.make_package`.
+
+        Default: ``False``
+
+    :param combine_integrals:
+        bool, optional;
+        Integrate the integrands of the same dimension in
+        every sum together, i.e. sum them with their
+        coefficients point by point and run a single
+        numerical integration over the result. This is
+        useful if large cancellations between the terms
+        are expected, e.g. between the spurious poles of
+        the regions of an expansion by regions. Only
+        applies to integrations on the CPU, and not to
+        the `disteval` integrator.
+
+        Default: ``False``
+
     '''
     print('running "sum_package" for ' + name)
 
@@ -429,10 +459,13 @@ def sum_package(name, package_generators, regulators, requested_orders,
                                 'need_complex': int(bool(need_complex)),
                                 'enforce_complex': int(bool(enforce_complex)),
                                 'enforce_complex_return_type': int(bool(enforce_complex)),  # make sure that this is either ``0`` or ``1``
-                                'contour_deformation': int(bool(contour_deformation))
+                                'contour_deformation': int(bool(contour_deformation)),
+                                'combine_integrals': int(bool(combine_integrals))
     }
+    replacements_in_files.update(generate_pylink_qmc_transform_selection(pylink_qmc_transforms))
     filesystem_replacements = {
                                   'integrate_name.cpp' : 'integrate_' + name + '.cpp',
+                                  'worker_name.cpp' : 'worker_' + name + '.cpp',
 
                                   # the following files are integral specific
                                   'name_weighted_integral.cpp' : None,
@@ -445,7 +478,7 @@ def sum_package(name, package_generators, regulators, requested_orders,
 
     # get path to the directory with the template files (path relative to directory with this file: "./templates/")
     template_sources = os.path.join(os.path.split(os.path.abspath(__file__))[0],'templates','sum_package')
-    parse_template_tree(template_sources, name, replacements_in_files, filesystem_replacements)
+    parse_template_tree(template_sources, name, replacements_in_files, filesystem_replacements, extend)
 
     # Parse pylink files
     for pylink_qmc_transform in pylink_qmc_transform_instantiation_rules:
@@ -453,12 +486,12 @@ def sum_package(name, package_generators, regulators, requested_orders,
         pylink_qmc_transform_replacements.update(pylink_qmc_transform['replacements'])
         parse_template_file(os.path.join(template_sources, 'pylink', pylink_qmc_transform['src']),
                             os.path.join(name,             'pylink', pylink_qmc_transform['dest']),
-                            pylink_qmc_transform_replacements)
+                            pylink_qmc_transform_replacements, extend)
 
     original_working_directory = os.getcwd()
 
-    os.mkdir(os.path.join(name, "disteval"))
-    os.mkdir(os.path.join(name, "disteval", "coefficients"))
+    os.makedirs(os.path.join(name, "disteval"), exist_ok=extend)
+    os.makedirs(os.path.join(name, "disteval", "coefficients"), exist_ok=extend)
     try:
         os.chdir(name)
         with open("integral_names.txt","w") as f:
@@ -472,7 +505,7 @@ def sum_package(name, package_generators, regulators, requested_orders,
                         name, package_generator._replace(processes=1),
                         pylink_qmc_transforms, real_parameters, regulators,
                         replacements_in_files, requested_orders,
-                        template_sources
+                        template_sources, extend
                     )
                     for j, package_generator in enumerate(package_generators)
                 ])
@@ -482,7 +515,7 @@ def sum_package(name, package_generators, regulators, requested_orders,
                     name, package_generator,
                     pylink_qmc_transforms, real_parameters, regulators,
                     replacements_in_files, requested_orders,
-                    template_sources
+                    template_sources, extend
                 )
                 for j, package_generator in enumerate(package_generators)
             ]
@@ -498,7 +531,7 @@ def sum_package(name, package_generators, regulators, requested_orders,
     # Parse sum_package header file
     parse_template_file(os.path.join(template_sources, 'name.hpp'),  # source
                         os.path.join(name, name + '.hpp'),  # dest
-                        replacements_in_files)
+                        replacements_in_files, extend)
 
     with open(os.path.join(name, "disteval", name + ".json"), "w") as f:
         json.dump({
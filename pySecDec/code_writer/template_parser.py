@@ -3,6 +3,7 @@ Functions to generate c++ sources from template files.
 
 """
 
+import filecmp
 import os
 import re
 
@@ -70,7 +71,29 @@ def generate_pylink_qmc_macro_dict(macro_function_name):
         pylink_qmc_translation['sidi' + str(i)] = macro_function_name + '_SIDI_QMC(%i)' % i
     return pylink_qmc_translation
 
-def parse_template_file(src, dest, replacements={}):
+def generate_pylink_qmc_transform_selection(pylink_qmc_transforms):
+    '''
+
+    Generate the C++ lists of the transform ids and names that the
+    pylink interface tries with ``transform='auto'``
+
+    :param pylink_qmc_transforms:
+        list;
+        The validated transform short names, see
+        :func:`validate_pylink_qmc_transforms`
+
+    :return:
+        dict;
+        The replacements ``pylink_qmc_transform_ids`` and
+        ``pylink_qmc_transform_names``
+
+    '''
+    return {
+        'pylink_qmc_transform_ids': ', '.join('no_transform' if x == 'none' else x for x in pylink_qmc_transforms),
+        'pylink_qmc_transform_names': ', '.join('"%s"' % x for x in pylink_qmc_transforms)
+    }
+
+def parse_template_file(src, dest, replacements={}, update=False):
     '''
     Copy a file from `src` to `dest` replacing
     ``%(...)`` instructions in the standard python
@@ -102,7 +125,22 @@ def parse_template_file(src, dest, replacements={}):
             ...     value = 5)
             'my_variable = 5'
 
+    :param update:
+        bool;
+        If ``True`` and `dest` exists with the same
+        content as the parsed file, leave it untouched,
+        so that its modification time does not trigger
+        a rebuild by ``make``.
+
     '''
+    if update and os.path.exists(dest):
+        parse_template_file(src, dest + '.new', replacements)
+        if filecmp.cmp(dest, dest + '.new', shallow=False):
+            os.remove(dest + '.new')
+        else:
+            os.replace(dest + '.new', dest)
+        return
+
     # read template file
     with open(src, 'r') as src_file:
         string = src_file.read()
@@ -138,7 +176,7 @@ def parse_template_file(src, dest, replacements={}):
             recursive_write(dest_file, bigtext)
             dest_file.write(dest_file_parts[n+1] % replacements)
 
-def parse_template_tree(src, dest, replacements_in_files={}, filesystem_replacements={}):
+def parse_template_tree(src, dest, replacements_in_files={}, filesystem_replacements={}, update=False):
     '''
     Copy a directory tree from `src` to `dest` using
     :func:`.parse_template_file` for each file and
@@ -176,6 +214,12 @@ def parse_template_tree(src, dest, replacements_in_files={}, filesystem_replacem
         value. If the value is ``None``, the
         corresponding file is ignored.
 
+    :param update:
+        bool;
+        If ``True``, `dest` may already exist; files
+        whose content does not change are left
+        untouched (see :func:`.parse_template_file`).
+
     '''
     # walk through tree
     for dirpath, dirnames, filenames in os.walk(src):
@@ -206,7 +250,8 @@ def parse_template_tree(src, dest, replacements_in_files={}, filesystem_replacem
         else:
             this_target_directory = dest
 
-        os.mkdir(this_target_directory)
+        if not (update and os.path.isdir(this_target_directory)):
+            os.mkdir(this_target_directory)
 
         # parse files
         for source_filename in filenames:
@@ -220,7 +265,7 @@ def parse_template_tree(src, dest, replacements_in_files={}, filesystem_replacem
             target_file_path = os.path.join(this_target_directory, target_filename)
 
             try:
-                parse_template_file(source_file_path, target_file_path, replacements_in_files)
+                parse_template_file(source_file_path, target_file_path, replacements_in_files, update)
             except Exception as error:
                 error.args = tuple([arg for arg in error.args] + ['while parsing "' + source_file_path + '"'])
                 raise
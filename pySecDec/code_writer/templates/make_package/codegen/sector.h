@@ -1,3 +1,7 @@
+* A hash of the definitions of this sector, which
+* make_package compares when extending the package
+#define sectorFingerprint "%(sector_fingerprint)s"
+
 * The name of the loop integral
 #define name "%(name)s"
 
@@ -1,5 +1,6 @@
 #include <cinttypes>
 #include <complex>
+#include <type_traits>
 
 typedef int64_t int_t;
 typedef double real_t;
@@ -44,6 +45,24 @@ typedef std::complex<real_t> complex_t;
 
 #define mathfn static inline
 
+// The real fast path replaces the lane-by-lane calls to the
+// scalar log/exp/pow by branch-free vectorised versions. It is
+// requested by the generated code of purely real integrands
+// (no complex parameters, no contour deformation), and can be
+// switched off with -DSECDEC_REAL_FAST_PATH=0. It only pays off
+// if 256-bit integer vectors are native, i.e. with -mavx2 (see
+// DIST_ARCHFLAGS in the Makefile); otherwise the scalar libm
+// calls are faster.
+
+#ifndef SECDEC_REAL_FAST_PATH
+    #define SECDEC_REAL_FAST_PATH 0
+#endif
+#if defined(__AVX2__)
+    #define USE_REAL_FAST_PATH (SECDEC_REAL_FAST_PATH && !SECDEC_RESULT_IS_COMPLEX && HAVE_GNU_VECTOR_TERNARY)
+#else
+    #define USE_REAL_FAST_PATH 0
+#endif
+
 // Misc
 
 mathfn int_t warponce_i(const int_t a, const int_t b)
@@ -58,6 +77,7 @@ mathfn real_t SecDecInternalAbs(const real_t &a) { return std::abs(a); }
 mathfn real_t SecDecInternalAbs(const complex_t &a) { return std::abs(a); }
 mathfn complex_t SecDecInternalI(const real_t &a) { return complex_t{0, a}; }
 mathfn complex_t SecDecInternalI(const complex_t &a) { return complex_t{-a.imag(), a.real()}; }
+mathfn real_t SecDecInternalTaylorSwitch(const real_t &a, const real_t &t) { return a < t ? 0 : 1; }
 
 static uint64_t mulmod(uint64_t a, uint64_t b, uint64_t k) {
     // assume 0 <= a,b <= k < 2^53
@@ -139,6 +159,9 @@ DEF_SCALAR_OPERATOR(realvec_t, operator /, realvec_t, real_t, /)
     { realvec_t ab = realvec_t{a.x - b};
       return realvec_t{ab.x >= 0 ? ab.x : a.x}; }
 
+    mathfn realvec_t SecDecInternalTaylorSwitch(const realvec_t &a, const real_t &t)
+    { return realvec_t{a.x < t ? REALVEC_ZERO.x : REALVEC_CONST(1).x}; }
+
 #else
 
     mathfn realvec_t vec_max(const realvec_t &a, const realvec_t &b)
@@ -160,6 +183,12 @@ DEF_SCALAR_OPERATOR(realvec_t, operator /, realvec_t, real_t, /)
                          ab.x[2] >= 0 ? ab.x[2] : a.x[2],
                          ab.x[3] >= 0 ? ab.x[3] : a.x[3] }}; }
 
+    mathfn realvec_t SecDecInternalTaylorSwitch(const realvec_t &a, const real_t &t)
+    { return realvec_t{{ a.x[0] < t ? 0.0 : 1.0,
+                         a.x[1] < t ? 0.0 : 1.0,
+                         a.x[2] < t ? 0.0 : 1.0,
+                         a.x[3] < t ? 0.0 : 1.0 }}; }
+
 #endif
 
 mathfn realvec_t vec_max(const realvec_t &a, const real_t &b)
@@ -318,6 +347,8 @@ mathfn real_t SecDecInternalRealPart(const complex_t &a) { return a.real(); }
 mathfn real_t SecDecInternalImagPart(const complex_t &a) { return a.imag(); }
 mathfn realvec_t SecDecInternalRealPart(const complexvec_t &a) { return a.re; }
 mathfn realvec_t SecDecInternalImagPart(const complexvec_t &a) { return a.im; }
+mathfn real_t SecDecInternalTaylorSwitch(const complex_t &a, const real_t &t) { return a.real() < t ? 0 : 1; }
+mathfn realvec_t SecDecInternalTaylorSwitch(const complexvec_t &a, const real_t &t) { return SecDecInternalTaylorSwitch(a.re, t); }
 
 #define DEF_CC_FUNCTION(fname, fn) \
     static inline complexvec_t fname(const complexvec_t &a) { \
@@ -372,9 +403,138 @@ mathfn complexvec_t SecDecInternalI(const complexvec_t &a)
 mathfn complex_t componentsum(const complexvec_t &a)
 { return complex_t{ componentsum(a.re), componentsum(a.im) }; }
 
+// Lane-by-lane evaluation of scalar functions
+//
+// DEF_LANEWISE_FUNCTION(f) lets a scalar function f, such as
+// a user-defined function from "functions.h", be called with
+// vector arguments: f is then evaluated once per lane, with
+// the scalar arguments passed through unchanged. The fallback
+// only applies if at least one argument is a vector, and a
+// (non-template) vector overload of f with the exact argument
+// types of the call takes precedence over it.
+
+mathfn real_t lane(const realvec_t &a, const int k) { return a.x[k]; }
+mathfn complex_t lane(const complexvec_t &a, const int k) { return complex_t{a.re.x[k], a.im.x[k]}; }
+template<typename T> mathfn const T &lane(const T &a, const int k) { return a; }
+
+mathfn realvec_t lanes_to_vec(const real_t c0, const real_t c1, const real_t c2, const real_t c3)
+{ return realvec_t{{c0, c1, c2, c3}}; }
+mathfn complexvec_t lanes_to_vec(const complex_t &c0, const complex_t &c1, const complex_t &c2, const complex_t &c3)
+{ return complexvec_t{
+      {{c0.real(), c1.real(), c2.real(), c3.real()}},
+      {{c0.imag(), c1.imag(), c2.imag(), c3.imag()}}
+  }; }
+
+template<typename... T> struct any_vec : std::false_type {};
+template<typename T, typename... Ts> struct any_vec<T, Ts...> : std::integral_constant<bool,
+    std::is_same<T, realvec_t>::value || std::is_same<T, complexvec_t>::value || any_vec<Ts...>::value> {};
+
+#define DEF_LANEWISE_FUNCTION(fname) \
+    template<typename... T, typename std::enable_if<any_vec<T...>::value, int>::type = 0> \
+    static inline auto fname(const T &...a) \
+    { return lanes_to_vec(fname(lane(a, 0)...), fname(lane(a, 1)...), fname(lane(a, 2)...), fname(lane(a, 3)...)); }
+
+// Branch-free real vector functions
+//
+// The usual range reduction is done on the bit representation:
+// log(x) = e*log(2) + log(m), with m in [sqrt(1/2), sqrt(2)), and
+// exp(x) = 2^k*exp(r), with |r| <= log(2)/2. The remaining
+// series are truncated at double precision. Integer to double
+// conversions go through the 2^52 trick instead of rounding
+// with floating point additions, because the latter would be
+// undone by -funsafe-math-optimizations. The same flag would
+// merge the two halves of log(2) in the reduction of exp(x),
+// raising its relative error to about |x|*1e-16; an empty asm
+// statement between the two steps prevents that.
+
+#if USE_REAL_FAST_PATH
+
+    typedef int64_t intvec_t __attribute__((vector_size(32)));
+    typedef uint64_t uintvec_t __attribute__((vector_size(32)));
+
+    #define INTVEC_CONST(c) (intvec_t{c,c,c,c})
+
+    mathfn realvec_t intvec_to_realvec(const intvec_t &k)
+    { // assume -2048 <= k < 2^52 - 2048
+      return realvec_t{(decltype(realvec_t::x))(k + INTVEC_CONST(0x4330000000000000 + 2048))}
+          - REALVEC_CONST(4503599627372544.0); }
+
+    mathfn realvec_t vec_exp(const realvec_t &a)
+    {
+        const realvec_t ln2hi = REALVEC_CONST(6.93147180369123816490e-01);
+        const realvec_t ln2lo = REALVEC_CONST(1.90821492927058770002e-10);
+        const realvec_t magic = REALVEC_CONST(6755399441055744.0);
+        // Outside of [-746, 710] the result is 0 or infinity; NaN
+        // passes through the clamping unchanged.
+        auto x = a.x < REALVEC_CONST(-746.0).x ? REALVEC_CONST(-746.0).x : a.x;
+        x = x > REALVEC_CONST(710.0).x ? REALVEC_CONST(710.0).x : x;
+        auto k = (intvec_t)(x*1.4426950408889634 + magic.x) - (intvec_t)magic.x;
+        auto kd = intvec_to_realvec(k);
+        auto r = realvec_t{x} - kd*ln2hi;
+        __asm__("" : "+x"(r.x));
+        r = r - kd*ln2lo;
+        auto p = (((((((((((((1.0/6227020800)*r + 1.0/479001600)*r + 1.0/39916800)*r +
+            1.0/3628800)*r + 1.0/362880)*r + 1.0/40320)*r + 1.0/5040)*r + 1.0/720)*r +
+            1.0/120)*r + 1.0/24)*r + 1.0/6)*r + 0.5)*r + 1.0)*r + 1.0;
+        // Scale by 2^k in two steps, so that neither factor
+        // overflows nor becomes subnormal.
+        auto k1 = (intvec_t)((uintvec_t)(k + 2048) >> 1) - 1024;
+        auto k2 = k - k1;
+        auto s1 = realvec_t{(decltype(realvec_t::x))((k1 + 1023) << 52)};
+        auto s2 = realvec_t{(decltype(realvec_t::x))((k2 + 1023) << 52)};
+        return p*s1*s2;
+    }
+
+    mathfn realvec_t vec_log(const realvec_t &a)
+    {
+        const realvec_t ln2hi = REALVEC_CONST(6.93147180369123816490e-01);
+        const realvec_t ln2lo = REALVEC_CONST(1.90821492927058770002e-10);
+        // Bring subnormal numbers into the normal range first.
+        auto issub = a.x < REALVEC_CONST(2.2250738585072014e-308).x;
+        auto x = issub ? a.x*18014398509481984.0 : a.x;
+        auto bits = (intvec_t)x;
+        auto e = (intvec_t)((uintvec_t)bits >> 52 & 0x7ff) - 1023 + ((intvec_t)issub & -54);
+        auto m = realvec_t{(decltype(realvec_t::x))((bits & 0x000fffffffffffff) | 0x3ff0000000000000)};
+        auto big = m.x > REALVEC_CONST(1.4142135623730951).x;
+        m = realvec_t{big ? m.x*0.5 : m.x};
+        e = e - (intvec_t)big;
+        auto s = (m - 1)/(m + 1);
+        auto z = s*s;
+        auto p = ((((((((((((2.0/23)*z + 2.0/21)*z + 2.0/19)*z + 2.0/17)*z + 2.0/15)*z +
+            2.0/13)*z + 2.0/11)*z + 2.0/9)*z + 2.0/7)*z + 2.0/5)*z + 2.0/3)*z + 2.0)*s;
+        auto ed = intvec_to_realvec(e);
+        auto r = ed*ln2hi + (ed*ln2lo + p);
+        // log(0) = -inf, log(inf) = inf, log(<negative>) = log(NaN) = NaN.
+        auto inf = REALVEC_CONST(INFINITY).x;
+        auto nan = REALVEC_CONST(NAN).x;
+        auto res = a.x > 0 ? r.x : (a.x == 0 ? -inf : nan);
+        return realvec_t{a.x == inf ? inf : res};
+    }
+
+    mathfn realvec_t vec_pow(const realvec_t &x, const real_t n)
+    {
+        // The exponent is the same for all points, so branching on
+        // it is cheap. Integer powers are exact and valid for
+        // negative bases too.
+        if ((std::abs(n) <= 1024) && (n == (int)n)) {
+            int k = std::abs((int)n);
+            realvec_t base = x, res = REALVEC_CONST(1);
+            for (; k; k >>= 1, base = base*base)
+                if (k & 1) res = res*base;
+            return n < 0 ? 1/res : res;
+        }
+        return vec_exp(n*vec_log(x));
+    }
+
+#endif
+
 // Misc functions
 
+#if USE_REAL_FAST_PATH
+mathfn realvec_t exp(const realvec_t &a) { return vec_exp(a); }
+#else
 DEF_RR_FUNCTION(exp, exp)
+#endif
 DEF_CC_FUNCTION(exp, exp)
 
 // Result vectors
@@ -413,16 +573,24 @@ DEF_CC_FUNCTION(exp, exp)
     static inline real_t SecDecInternalLog(real_t x)
     { return std::log(x); };
 
-    DEF_RR_FUNCTION(SecDecInternalLog, SecDecInternalLog)
-
     static inline real_t SecDecInternalExp(real_t x)
     { return std::exp(x); };
 
-    DEF_RR_FUNCTION(SecDecInternalExp, SecDecInternalExp)
-
     static inline real_t SecDecInternalPow(const real_t x, const real_t n)
     { return std::pow(x, n); }
 
+  #if USE_REAL_FAST_PATH
+
+    mathfn realvec_t SecDecInternalLog(const realvec_t &a) { return vec_log(a); }
+    mathfn realvec_t SecDecInternalExp(const realvec_t &a) { return vec_exp(a); }
+    mathfn realvec_t SecDecInternalPow(const realvec_t &a, const real_t n) { return vec_pow(a, n); }
+
+  #else
+
+    DEF_RR_FUNCTION(SecDecInternalLog, SecDecInternalLog)
+    DEF_RR_FUNCTION(SecDecInternalExp, SecDecInternalExp)
     DEF_RR_FUNCTION_1(SecDecInternalPow, SecDecInternalPow, real_t, n)
 
+  #endif
+
 #endif
@@ -37,12 +37,18 @@ mathfn real_t SecDecInternalImagPart(const real_t x) { return 0; }
 mathfn real_t SecDecInternalImagPart(const complex_t x) { return x.imag(); }
 mathfn complex_t SecDecInternalI(const real_t x) { return complex_t{0, x}; }
 mathfn complex_t SecDecInternalI(const complex_t x) { return complex_t{-x.imag(), x.real()}; }
+mathfn real_t SecDecInternalTaylorSwitch(const real_t x, const real_t threshold) { return x < threshold ? 0 : 1; }
+mathfn real_t SecDecInternalTaylorSwitch(const complex_t x, const real_t threshold) { return x.real() < threshold ? 0 : 1; }
 
 mathfn real_t exp(int n) { return exp(real_t(n)); }
 
 #define SecDecInternalDenominator(x) (1.0/(x))
 #define i_ (complex_t{0,1})
 
+// Each thread evaluates a single point, so the scalar
+// user-defined functions are called directly.
+#define DEF_LANEWISE_FUNCTION(fname)
+
 #define likely(x) __builtin_expect((x), 1)
 #define unlikely(x) __builtin_expect((x), 0)
 
@@ -0,0 +1,49 @@
+#ifndef %(name)s_distsrc_functions_h_included
+#define %(name)s_distsrc_functions_h_included
+
+/*
+ * The `functions` and their required derivatives for the
+ * distributed evaluator. The kernels in this directory do not
+ * use 'src/functions.hpp'; the functions listed below must be
+ * defined here once more, in terms of the types of
+ * "common_cpu.h" and "common_cuda.h": "real_t" and "complex_t"
+ * for a single point, "realvec_t" and "complexvec_t" for the
+ * four points that the CPU kernels evaluate at once, and
+ * "result_t" for the result. Define all of them as "mathfn",
+ * so that they can be used in both the CPU and the CUDA
+ * kernels.
+ *
+ * A scalar definition, for example
+ *
+ *     mathfn result_t f(const real_t &arg0, const real_t &arg1)
+ *     { return arg0*arg1; }
+ *
+ * is sufficient: the CPU kernels then evaluate it lane by lane
+ * (see the "DEF_LANEWISE_FUNCTION" lines at the end of this
+ * file). Note that the arguments can be complex if the contour
+ * is deformed. To speed up the CPU kernels, you can add vector
+ * overloads, for example
+ *
+ *     #ifndef __CUDACC__
+ *     mathfn realvec_t f(const realvec_t &arg0, const real_t &arg1)
+ *     { return arg0*arg1; }
+ *     #endif
+ *
+ * which are used instead of the lane-by-lane fallback whenever
+ * they match the argument types of a call exactly.
+ *
+ * Note: Not all functions listed here may actually be needed.
+ *       This file lists all derivatives that occurred in the
+ *       calculation. It is possible that some dropped out due
+ *       to algebraic simplifications after this list was
+ *       generated.
+ */
+
+/*
+%(distsrc_function_declarations)s
+*/
+
+// Lane-by-lane fallbacks; these must follow the scalar definitions.
+%(distsrc_lanewise_functions)s
+
+#endif
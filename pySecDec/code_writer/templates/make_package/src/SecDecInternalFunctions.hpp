@@ -269,6 +269,8 @@ namespace %(name)s
     SecDecFn real_t SecDecInternalImagPart(const complex_t x) { return x.imag(); }
     SecDecFn complex_t SecDecInternalI(const real_t x) { return complex_t{0, x}; }
     SecDecFn complex_t SecDecInternalI(const complex_t x) { return complex_t{-x.imag(), x.real()}; }
+    SecDecFn real_t SecDecInternalTaylorSwitch(const real_t x, const real_t threshold) { return x < threshold ? 0 : 1; }
+    SecDecFn real_t SecDecInternalTaylorSwitch(const complex_t x, const real_t threshold) { return x.real() < threshold ? 0 : 1; }
 
     #undef %(name)s_contour_deformation
     #undef %(name)s_has_complex_parameters
@@ -295,6 +297,16 @@ namespace %(name)s
 #define likely(x) (x)
 #define unlikely(x) (x)
 
+// Used for the parts of split integrand functions, which would
+// otherwise be inlined back into one giant function.
+#if defined(SECDEC_WITH_CUDA)
+#define SecDecInternalNoInline __noinline__
+#elif defined(__GNUC__)
+#define SecDecInternalNoInline __attribute__((noinline))
+#else
+#define SecDecInternalNoInline
+#endif
+
 #define SecDecInternalOutputDeformationParameters(i, v) output_deformation_parameters[i] = (v);
 #define SecDecInternalSignCheckErrorPositivePolynomial(id) \
     { \
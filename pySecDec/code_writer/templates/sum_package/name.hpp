@@ -20,6 +20,9 @@ namespace %(name)s
     // whether or not to use contour deformation
     #define %(name)s_contour_deformation %(contour_deformation)i
 
+    // whether or not to integrate the integrands of the same dimension in a sum together
+    #define %(name)s_combine_integrals %(combine_integrals)i
+
     // some information about the integral
     // --{
     const unsigned long long number_of_integrals = %(number_of_integrals)i;
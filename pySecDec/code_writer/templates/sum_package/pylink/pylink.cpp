@@ -332,7 +332,10 @@
     int generatingvectors_id, \
     unsigned long long int lattice_candidates, \
     bool standard_lattices, \
-    bool keep_lattices
+    bool keep_lattices, \
+    unsigned long long int subdivision_depth, \
+    unsigned long long int subdivision_minn, \
+    double subdivision_threshold
 #define SET_COMMON_QMC_ARGS \
     /* If an argument is set to 0 then use the default of the Qmc library */ \
     if ( epsrel != 0 ) \
@@ -375,23 +378,56 @@
         integrator->generatingvectors = ::integrators::generatingvectors::none(); \
     integrator->logger = std::cerr; \
     integrator->keeplattices = keep_lattices; \
-    integrator->latticecandidates = lattice_candidates;
-#define SET_QMC_ARGS_WITH_DEVICES_AND_RETURN \
-        SET_COMMON_QMC_ARGS \
+    integrator->latticecandidates = lattice_candidates; \
+    if ( subdivision_minn != 0 ) \
+        integrator->subdivisionminn = subdivision_minn; \
+    if ( subdivision_threshold != 0 ) \
+        integrator->subdivisionthreshold = subdivision_threshold; \
+    integrator->subdivisiondepth = subdivision_depth;
+#define SET_QMC_DEVICES \
         if (number_of_devices > 0) \
         { \
             integrator->devices.clear(); \
             for (int i = 0; i < number_of_devices; ++i) \
                 integrator->devices.insert( devices[i] ); \
-        } \
+        }
+#define SET_QMC_ARGS_WITH_DEVICES_AND_RETURN \
+        SET_COMMON_QMC_ARGS \
+        SET_QMC_DEVICES \
         return integrator;
 #define SET_QMC_ARGS_AND_RETURN \
         SET_COMMON_QMC_ARGS \
         return integrator;
+// with transform='auto', every compiled transform becomes a candidate of a "QmcTransformSelection"
+#define SET_QMC_ARGS_WITH_DEVICES_AND_ADD_CANDIDATE \
+        SET_COMMON_QMC_ARGS \
+        SET_QMC_DEVICES \
+        selection->add_candidate(candidate_transform_names[candidate], integrator); \
+        continue;
+#define SET_QMC_ARGS_AND_ADD_CANDIDATE \
+        SET_COMMON_QMC_ARGS \
+        selection->add_candidate(candidate_transform_names[candidate], integrator); \
+        continue;
+#define ALLOCATE_QMC_TRANSFORM_SELECTION \
+    if (transform_id == auto_transform) \
+    { \
+        auto selection = new secdecutil::integrators::QmcTransformSelection<INTEGRAL_NAME::integrand_return_t,INTEGRAL_NAME::real_t,INTEGRAL_NAME::QMC_INTEGRAND_TYPENAME>; \
+        selection->verbosity = verbosity; \
+        const int candidate_transform_ids[] = { %(pylink_qmc_transform_ids)s }; \
+        const char* candidate_transform_names[] = { %(pylink_qmc_transform_names)s }; \
+        for (size_t candidate = 0; candidate < sizeof(candidate_transform_ids)/sizeof(int); ++candidate) \
+        { \
+            transform_id = candidate_transform_ids[candidate]; \
+            %(pylink_qmc_cases)s \
+        } \
+        return selection; \
+    }
 
 // all known qmc options
 enum qmc_transform_t : int
 {
+    auto_transform = 0,
+
     no_transform = -1,
 
     baker = -2,
@@ -537,8 +573,12 @@ enum qmc_generatingvectors_t : int
     {
             
         #define QMC_INTEGRAND_TYPENAME cuda_together_integrand_t
+        #define QMC_RETURN_STATEMENT SET_QMC_ARGS_WITH_DEVICES_AND_ADD_CANDIDATE
+        ALLOCATE_QMC_TRANSFORM_SELECTION
+        #undef QMC_RETURN_STATEMENT
         #define QMC_RETURN_STATEMENT SET_QMC_ARGS_WITH_DEVICES_AND_RETURN
         %(pylink_qmc_cases)s
+        #undef QMC_RETURN_STATEMENT
         #undef QMC_INTEGRAND_TYPENAME
             
         throw std::invalid_argument("Trying to allocate \"secdecutil::Qmc\" with unregistered \"transform_id\" (" + std::to_string(transform_id) + "). The transform you requested in the call to IntegralLibrary (transform='...') must match a transform requested in the generate script (pylink_qmc_transforms=['...']). You may wish to regenerate the library with pylink_qmc_transforms set.");
@@ -553,8 +593,12 @@ enum qmc_generatingvectors_t : int
     {
 
         #define QMC_INTEGRAND_TYPENAME cuda_integrand_t
+        #define QMC_RETURN_STATEMENT SET_QMC_ARGS_WITH_DEVICES_AND_ADD_CANDIDATE
+        ALLOCATE_QMC_TRANSFORM_SELECTION
+        #undef QMC_RETURN_STATEMENT
         #define QMC_RETURN_STATEMENT SET_QMC_ARGS_WITH_DEVICES_AND_RETURN
         %(pylink_qmc_cases)s
+        #undef QMC_RETURN_STATEMENT
         #undef QMC_INTEGRAND_TYPENAME
 
         throw std::invalid_argument("Trying to allocate \"secdecutil::Qmc\" with unregistered \"transform_id\" (" + std::to_string(transform_id) + "). The transform you requested in the call to IntegralLibrary (transform='...') must match a transform requested in the generate script (pylink_qmc_transforms=['...']). You may wish to regenerate the library with pylink_qmc_transforms set.");
@@ -566,8 +610,12 @@ enum qmc_generatingvectors_t : int
     {
             
         #define QMC_INTEGRAND_TYPENAME integrand_t
+        #define QMC_RETURN_STATEMENT SET_QMC_ARGS_AND_ADD_CANDIDATE
+        ALLOCATE_QMC_TRANSFORM_SELECTION
+        #undef QMC_RETURN_STATEMENT
         #define QMC_RETURN_STATEMENT SET_QMC_ARGS_AND_RETURN
         %(pylink_qmc_cases)s
+        #undef QMC_RETURN_STATEMENT
         #undef QMC_INTEGRAND_TYPENAME
 
         throw std::invalid_argument("Trying to allocate \"secdecutil::Qmc\" with unregistered \"transform_id\" (" + std::to_string(transform_id) + "). The transform you requested in the call to IntegralLibrary (transform='...') must match a transform requested in the generate script (pylink_qmc_transforms=['...']). You may wish to regenerate the library with pylink_qmc_transforms set.");
@@ -577,6 +625,11 @@ enum qmc_generatingvectors_t : int
 #undef COMMON_ALLOCATE_QMC_ARGS
 #undef SET_COMMON_QMC_ARGS
 #undef SET_QMC_ARGS_WITH_DEVICES_AND_RETURN
+#undef SET_QMC_ARGS_AND_RETURN
+#undef SET_QMC_ARGS_WITH_DEVICES_AND_ADD_CANDIDATE
+#undef SET_QMC_ARGS_AND_ADD_CANDIDATE
+#undef SET_QMC_DEVICES
+#undef ALLOCATE_QMC_TRANSFORM_SELECTION
 
 #undef integral_contour_deformation
 #undef integral_has_complex_parameters
@@ -1,4 +1,6 @@
 #include <vector> // std::vector
+#include <functional> // std::function
+#include <memory> // std::make_shared, std::shared_ptr
 #include <stdexcept> // std::invalid_argument
 #include <string> // std::string
 #include <typeinfo> // typeid
@@ -25,6 +27,37 @@ namespace %(name)s
 {
     typedef secdecutil::MultiIntegrator<INTEGRAL_NAME::integrand_return_t,INTEGRAL_NAME::real_t,INTEGRAL_NAME::integrand_t> multiintegrator_t;
     
+    #if %(name)s_combine_integrals && !defined(SECDEC_WITH_CUDA)
+        // the integral of the summed integrands of a sum (see "secdecutil::amplitude::combine_integrals")
+        // secdecutil::cuba::Vegas, secdecutil::cuba::Suave, secdecutil::cuba::Cuhre, secdecutil::cuba::Divonne
+        template<typename integrator_t>
+        struct CombinedAmplitudeIntegral
+        {
+            using type = secdecutil::amplitude::CubaIntegral<integrand_return_t,real_t,integrator_t,integrand_t>;
+        };
+        
+        // secdecutil::gsl::CQuad
+        template<>
+        struct CombinedAmplitudeIntegral<secdecutil::gsl::CQuad<integrand_return_t>>
+        {
+            using type = secdecutil::amplitude::CQuadIntegral<integrand_return_t,real_t,secdecutil::gsl::CQuad<integrand_return_t>,integrand_t>;
+        };
+        
+        // secdecutil::MultiIntegrator
+        template<>
+        struct CombinedAmplitudeIntegral<multiintegrator_t>
+        {
+            using type = secdecutil::amplitude::MultiIntegratorIntegral<integrand_return_t,real_t,multiintegrator_t,integrand_t>;
+        };
+        
+        // secdecutil::integrators::Qmc
+        template<::integrators::U maxdim, template<typename,typename,::integrators::U> class transform_t, template<typename,typename,::integrators::U> class fitfunction_t>
+        struct CombinedAmplitudeIntegral<secdecutil::integrators::Qmc<integrand_return_t,maxdim,transform_t,integrand_t,fitfunction_t>>
+        {
+            using type = secdecutil::amplitude::QmcIntegral<integrand_return_t,real_t,secdecutil::integrators::Qmc<integrand_return_t,maxdim,transform_t,integrand_t,fitfunction_t>,integrand_t>;
+        };
+    #endif
+    
     template<typename integrator_t>
     std::vector<nested_series_t<sum_t>> make_amplitudes
     (
@@ -58,6 +91,19 @@ namespace %(name)s
             amplitudes.push_back(amplitude);
         }
 
+        #if %(name)s_combine_integrals && !defined(SECDEC_WITH_CUDA)
+            // Integrate the integrands of the same dimension in every sum together
+            const std::shared_ptr<integrator_t> integrator_ptr = std::make_shared<integrator_t>(integrator);
+            amplitudes = secdecutil::amplitude::combine_integrals<sum_t>
+            (
+                amplitudes,
+                [ integrator_ptr ] (int number_of_integration_variables, const std::function<integrand_return_t(real_t const * const, secdecutil::ResultInfo*)>& integrand)
+                {
+                    return std::make_shared<typename CombinedAmplitudeIntegral<integrator_t>::type>(integrator_ptr, integrand_t(number_of_integration_variables, integrand));
+                }
+            );
+        #endif
+
         return amplitudes;
     };
     
@@ -687,6 +733,31 @@ namespace %(name)s
         // secdecutil::MultiIntegrator
         DYNAMIC_CAST_INTEGRATOR(multiintegrator_t)
         
+        // secdecutil::integrators::QmcTransformSelection: build the amplitudes once per candidate transform
+        if(auto selection = dynamic_cast<const secdecutil::integrators::QmcTransformSelection<integrand_return_t,real_t,integrand_t>*>(integrator))
+        {
+            std::vector<std::vector<nested_series_t<sum_t>>> candidates;
+            for(const auto& candidate : selection->integrators)
+            {
+                const secdecutil::Integrator<integrand_return_t,real_t,integrand_t> * candidate_integrator = candidate.get();
+                candidates.push_back(
+                    make_amplitudes(
+                        real_parameters,
+                        complex_parameters,
+                        lib_path,
+                        candidate_integrator
+                        #if %(name)s_contour_deformation
+                            ,number_of_presamples,
+                            deformation_parameters_maximum,
+                            deformation_parameters_minimum,
+                            deformation_parameters_decrease_factor
+                        #endif
+                    )
+                );
+            }
+            return secdecutil::amplitude::make_transform_selecting_amplitudes<sum_t>(candidates, selection->names);
+        }
+
         // secdecutil::integrators::Qmc
         %(pylink_qmc_dynamic_cast_integrator)s
         
@@ -709,6 +780,31 @@ namespace %(name)s
             #endif
         )
         {
+            // secdecutil::integrators::QmcTransformSelection: build the amplitudes once per candidate transform
+            if(auto selection = dynamic_cast<const secdecutil::integrators::QmcTransformSelection<integrand_return_t,real_t,cuda_integrand_t>*>(integrator))
+            {
+                std::vector<std::vector<nested_series_t<sum_t>>> candidates;
+                for(const auto& candidate : selection->integrators)
+                {
+                    const secdecutil::Integrator<integrand_return_t,real_t,cuda_integrand_t> * candidate_integrator = candidate.get();
+                    candidates.push_back(
+                        make_amplitudes(
+                            real_parameters,
+                            complex_parameters,
+                            lib_path,
+                            candidate_integrator
+                            #if %(name)s_contour_deformation
+                                ,number_of_presamples,
+                                deformation_parameters_maximum,
+                                deformation_parameters_minimum,
+                                deformation_parameters_decrease_factor
+                            #endif
+                        )
+                    );
+                }
+                return secdecutil::amplitude::make_transform_selecting_amplitudes<sum_t>(candidates, selection->names);
+            }
+
             // secdecutil::integrators::Qmc
             %(pylink_qmc_dynamic_cast_integrator)s
             
@@ -0,0 +1,71 @@
+#include <iostream> // std::cin, std::cout, std::cerr
+#include <sstream> // std::istringstream
+#include <string> // std::string, std::getline
+#include <vector> // std::vector
+
+#include "%(name)s.hpp"
+
+// implemented in pylink/pylink.cpp (see secdecutil/pylink.hpp)
+extern "C" secdecutil::Integrator<%(name)s::integrand_return_t,%(name)s::real_t> * allocate_integrator(const char * description);
+
+/*
+ * Worker for the "workers" option of the python interface
+ * (pySecDec.integral_interface.IntegralLibrary).
+ *
+ * It reads the setup written by "add_workers" (see secdecutil/pylink_amplitude.hpp)
+ * from the standard input, rebuilds the amplitudes of the coordinating process,
+ * and then computes the integrals requested by it until the input ends.
+ */
+int main()
+{
+    std::string integrator_description, parameters, deformation_parameters, lib_path;
+    if ( !std::getline(std::cin, integrator_description) || !std::getline(std::cin, parameters) ||
+         !std::getline(std::cin, deformation_parameters) || !std::getline(std::cin, lib_path) ) {
+        std::cerr << "worker_%(name)s: incomplete setup" << std::endl;
+        return 1;
+    }
+
+    // Set up the integrator of the coordinating process
+    const secdecutil::Integrator<%(name)s::integrand_return_t,%(name)s::real_t> * integrator = allocate_integrator(integrator_description.c_str());
+    if ( !integrator )
+        return 1;
+
+    // Read the parameters
+    std::istringstream parameters_stream(parameters);
+    std::vector<%(name)s::real_t> real_parameters(%(name)s::number_of_real_parameters);
+    std::vector<%(name)s::complex_t> complex_parameters(%(name)s::number_of_complex_parameters);
+    for ( auto& parameter : real_parameters )
+        parameters_stream >> parameter;
+    for ( auto& parameter : complex_parameters ) {
+        %(name)s::real_t re, im;
+        parameters_stream >> re >> im;
+        parameter = %(name)s::complex_t(re, im);
+    }
+    std::istringstream deformation_parameters_stream(deformation_parameters);
+    %(name)s::real_t deformation_parameters_maximum, deformation_parameters_minimum, deformation_parameters_decrease_factor;
+    deformation_parameters_stream >> deformation_parameters_maximum >> deformation_parameters_minimum >> deformation_parameters_decrease_factor;
+    if ( !parameters_stream || !deformation_parameters_stream ) {
+        std::cerr << "worker_%(name)s: malformed setup" << std::endl;
+        return 1;
+    }
+
+    // Construct the amplitudes
+    // Note: The deformation parameters are sent with every request, no presampling needed.
+    std::vector<%(name)s::nested_series_t<%(name)s::sum_t>> unwrapped_amplitudes =
+        %(name)s::make_amplitudes(
+                                     real_parameters,
+                                     complex_parameters,
+                                     lib_path,
+                                     integrator
+                                     #if %(name)s_contour_deformation
+                                         , 0,
+                                         deformation_parameters_maximum,
+                                         deformation_parameters_minimum,
+                                         deformation_parameters_decrease_factor
+                                     #endif
+                                 );
+
+    // Pack amplitudes into handler and serve the integrals
+    %(name)s::handler_t<%(name)s::amplitudes_t> amplitudes(unwrapped_amplitudes);
+    amplitudes.serve(std::cin, std::cout);
+}
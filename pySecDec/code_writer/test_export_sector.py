@@ -0,0 +1,207 @@
+from ..disteval import DEFAULT_COST_MODEL, predict_kernel_cost
+import functools
+import importlib.machinery
+import importlib.util
+import os
+import random
+import shutil
+import subprocess
+import tempfile
+import unittest
+import pySecDecContrib
+import pytest
+
+def load_export_sector():
+    # `export_sector` is a script without the `.py` suffix
+    filename = os.path.join(pySecDecContrib.dirname, 'bin', 'export_sector')
+    loader = importlib.machinery.SourceFileLoader('export_sector', filename)
+    module = importlib.util.module_from_spec(importlib.util.spec_from_loader('export_sector', loader))
+    loader.exec_module(module)
+    return module
+
+export_sector = load_export_sector()
+
+def have_avx2():
+    try:
+        with open('/proc/cpuinfo') as f:
+            return ' avx2' in f.read()
+    except OSError:
+        return False
+
+#@pytest.mark.active
+class TestKernelCost(unittest.TestCase):
+    def operations(self, code):
+        return export_sector.kernel_cost(code, 1)['operations']
+
+    #@pytest.mark.active
+    def test_operations(self):
+        self.assertEqual(self.operations('auto tmp1_1 = x0*x1;'), 1)
+        self.assertEqual(self.operations('auto tmp1_1 = x0/x1 + x2 - 1;'), 3)
+        self.assertEqual(self.operations('auto tmp1_1 = x0-x1;'), 1)
+        self.assertEqual(self.operations('auto tmp1_1 = x[0]-y[1];'), 1)
+        self.assertEqual(self.operations('auto tmp1_1 = f(x0)-(x1+x2);'), 2)
+
+    #@pytest.mark.active
+    def test_signs_are_no_operations(self):
+        self.assertEqual(self.operations('auto tmp1_1 = -x0;'), 0)
+        self.assertEqual(self.operations('auto tmp1_1 = x0*-x1;'), 1)
+        self.assertEqual(self.operations('auto tmp1_1 = -1 + x0;'), 1)
+        self.assertEqual(self.operations('auto tmp1_1 = f(-x0, +x1);'), 0)
+
+    #@pytest.mark.active
+    def test_exponents_are_no_operations(self):
+        self.assertEqual(self.operations('auto tmp1_1 = 1.5e-3*x0;'), 1)
+        self.assertEqual(self.operations('auto tmp1_1 = 2.E+1 + x0;'), 1)
+
+    #@pytest.mark.active
+    def test_calls(self):
+        cost = export_sector.kernel_cost('auto tmp1_1 = SecDecInternalLog(x0);\n' +
+                                         'auto tmp1_2 = SecDecInternalRealPart(tmp1_1);\n' +
+                                         'auto tmp1_3 = myfunction(tmp1_2, x1);', 2)
+        self.assertEqual(cost['dimension'], 2)
+        self.assertEqual(cost['transcendental'], 1)
+        self.assertEqual(cost['calls'], 1)
+        self.assertEqual(cost['lines'], 3)
+
+    #@pytest.mark.active
+    def test_gauge_kernel(self):
+        # The default cost model is normalized to the builtin gauge kernel.
+        with open(os.path.join(os.path.dirname(__file__), 'templates', 'make_package', 'distsrc', 'builtin.cpp')) as f:
+            source = f.read()
+        start = source.index('x1 = korobov3x3_f(x1);') + len('x1 = korobov3x3_f(x1);')
+        end = source.index('acc = acc + w*', start)
+        code = '\n'.join(line.strip() for line in source[start:end].strip().splitlines())
+        cost = export_sector.kernel_cost(code, 2)
+        self.assertEqual(cost['operations'], 104)
+        self.assertAlmostEqual(predict_kernel_cost(DEFAULT_COST_MODEL, cost), 1, delta=0.05)
+
+#@pytest.mark.active
+class TestSplitCode(unittest.TestCase):
+    def make_body(self, length):
+        # an integrand body as written by FORM, with dependencies
+        # between the abbreviations across the whole body
+        rng = random.Random(1)
+        lines = ['SecDecInternalAbbreviation[1]=x0 + s;', 'SecDecInternalAbbreviation[2]=x1*s;']
+        for k in range(3, length + 1):
+            a, b = rng.randrange(1, k), rng.randrange(1, k)
+            lines.append('SecDecInternalAbbreviation[%i]=(x0*SecDecInternalAbbreviation[%i] - x1*SecDecInternalAbbreviation[%i] + s)/2;' % (k, a, b))
+        lines.append('return(SecDecInternalAbbreviation[%i] + 3*SecDecInternalAbbreviation[%i]);' % (length, length//2))
+        return '\n'.join(lines)
+
+    def write_sector(self, filename, namespace, body, maxlines):
+        info = export_sector.DictionaryWrapper(dict(
+            sector='1', order_name='0', namespace=namespace, contourDeformation='0',
+            order_integrationVariables='x0,x1', realParameters='s', complexParameters='',
+            order_deformationParameters='', order_integrandBody=body
+        ))
+        split_code = export_sector.split_code
+        export_sector.split_code = functools.partial(split_code, maxlines=maxlines)
+        try:
+            with open(filename, 'w') as f:
+                export_sector.SECTOR_ORDER_CPP(f, info)
+        finally:
+            export_sector.split_code = split_code
+
+    #@pytest.mark.active
+    def test_parts(self):
+        code = export_sector.cleanup_code(self.make_body(100))
+        parts = export_sector.split_code(code, 30)
+        self.assertGreater(len(parts), 3)
+        self.assertEqual(sum(len(part.lines) for part in parts), len(code.splitlines()))
+        defined = set()
+        for part in parts:
+            self.assertLessEqual(len(part.lines), 30)
+            self.assertTrue(set(part.inputs) <= defined)
+            self.assertTrue(set(part.outputs) <= defined | part.local)
+            defined |= part.local
+
+    #@pytest.mark.active
+    @unittest.skipIf(shutil.which('c++') is None, 'no C++ compiler')
+    def test_compile_split(self):
+        # the split integrand must compute the same as the unsplit one
+        body = self.make_body(400)
+        with tempfile.TemporaryDirectory() as tmpdir:
+            with open(os.path.join(tmpdir, 'sector_1_0.hpp'), 'w') as f:
+                f.write(
+                    '#pragma once\n'
+                    '#define restrict __restrict__\n'
+                    '#define SecDecInternalNoInline __attribute__((noinline))\n'
+                    'typedef double real_t;\n'
+                    'typedef double complex_t;\n'
+                    'typedef double integrand_return_t;\n'
+                    'namespace secdecutil { struct ResultInfo {}; }\n'
+                )
+            self.write_sector(os.path.join(tmpdir, 'whole.cpp'), 'whole', body, 0)
+            self.write_sector(os.path.join(tmpdir, 'split.cpp'), 'split', body, 50)
+            with open(os.path.join(tmpdir, 'split.cpp')) as f:
+                self.assertIn('sector_1_order_0_integrand_part8', f.read())
+            with open(os.path.join(tmpdir, 'main.cpp'), 'w') as f:
+                f.write(
+                    '#include <cstdio>\n'
+                    '#include "sector_1_0.hpp"\n'
+                    'namespace whole { integrand_return_t sector_1_order_0_integrand(const real_t *, const real_t *, const complex_t *, secdecutil::ResultInfo *); }\n'
+                    'namespace split { integrand_return_t sector_1_order_0_integrand(const real_t *, const real_t *, const complex_t *, secdecutil::ResultInfo *); }\n'
+                    'int main() {\n'
+                    '    secdecutil::ResultInfo info;\n'
+                    '    const real_t s[] = {0.7};\n'
+                    '    for (int i = 0; i < 5; i++) {\n'
+                    '        const real_t x[] = {0.1 + 0.2*i, 0.9 - 0.15*i};\n'
+                    '        std::printf("%.17g %.17g\\n", whole::sector_1_order_0_integrand(x, s, nullptr, &info), split::sector_1_order_0_integrand(x, s, nullptr, &info));\n'
+                    '    }\n'
+                    '}\n'
+                )
+            executable = os.path.join(tmpdir, 'main')
+            subprocess.check_call(['c++', '-std=c++14', '-O1', '-o', executable] +
+                                  [os.path.join(tmpdir, name) for name in ('whole.cpp', 'split.cpp', 'main.cpp')])
+            output = subprocess.check_output([executable], encoding='utf8')
+        values = [[float(v) for v in line.split()] for line in output.splitlines()]
+        self.assertEqual(len(values), 5)
+        for whole, split in values:
+            self.assertNotEqual(whole, 0)
+            self.assertAlmostEqual(split/whole, 1, places=12)
+
+#@pytest.mark.active
+class TestRealFastPath(unittest.TestCase):
+    #@pytest.mark.active
+    @unittest.skipIf(shutil.which('c++') is None, 'no C++ compiler')
+    @unittest.skipIf(not have_avx2(), 'no AVX2')
+    def test_accuracy(self):
+        # with the flags of the Makefile, which allow reassociation
+        with open(os.path.join(os.path.dirname(__file__), 'templates', 'make_package', 'distsrc', 'common_cpu.h')) as f:
+            header = f.read().replace('%%', '%')
+        with tempfile.TemporaryDirectory() as tmpdir:
+            with open(os.path.join(tmpdir, 'common_cpu.h'), 'w') as f:
+                f.write(header)
+            with open(os.path.join(tmpdir, 'main.cpp'), 'w') as f:
+                f.write(
+                    '#define SECDEC_RESULT_IS_COMPLEX 0\n'
+                    '#define SECDEC_REAL_FAST_PATH 1\n'
+                    '#include "common_cpu.h"\n'
+                    '#include <cmath>\n'
+                    '#include <cstdio>\n'
+                    '#if !USE_REAL_FAST_PATH\n'
+                    '#error no real fast path\n'
+                    '#endif\n'
+                    'int main() {\n'
+                    '    double exp_error = 0, log_error = 0, pow_error = 0;\n'
+                    '    for (int i = 0; i < 100000; i++) {\n'
+                    '        const double x = -700 + 1409*(i + 0.5)/100000;\n'
+                    '        const double y = std::exp(x);\n'
+                    '        const long double e = expl(x), l = logl(y), p = powl(y, 0.3L);\n'
+                    '        const realvec_t v = REALVEC_CONST(x), ev = REALVEC_CONST(y);\n'
+                    '        exp_error = std::fmax(exp_error, std::fabs((double)((vec_exp(v).x[i%4] - e)/e)));\n'
+                    '        log_error = std::fmax(log_error, std::fabs((double)((vec_log(ev).x[i%4] - l)/l)));\n'
+                    '        pow_error = std::fmax(pow_error, std::fabs((double)((vec_pow(ev, 0.3).x[i%4] - p)/p)));\n'
+                    '    }\n'
+                    '    std::printf("%.3e %.3e %.3e\\n", exp_error, log_error, pow_error);\n'
+                    '}\n'
+                )
+            executable = os.path.join(tmpdir, 'main')
+            subprocess.check_call(['c++', '-std=c++14', '-O3', '-funsafe-math-optimizations', '-mavx2', '-o', executable,
+                                   os.path.join(tmpdir, 'main.cpp')])
+            output = subprocess.check_output([executable], encoding='utf8')
+        exp_error, log_error, pow_error = [float(v) for v in output.split()]
+        self.assertLess(exp_error, 1e-15)
+        self.assertLess(log_error, 1e-15)
+        # pow(x, n) = exp(n*log(x)) also carries the rounding error of n*log(x)
+        self.assertLess(pow_error, 1e-13)
@@ -3,9 +3,13 @@ from .make_package import _convert_input, _make_FORM_definition, \
                           _make_FORM_function_definition, _make_FORM_list, \
                           _derivative_muliindex_to_name, _make_FORM_shifted_orders, \
                           _validate, _make_prefactor_function, \
-                          _make_CXX_function_declaration
+                          _make_CXX_function_declaration, _make_distsrc_function_declaration, \
+                          _estimate_decomposition_cost, _select_decomposition_method, _decompose_for_cost_estimate, \
+                          _estimate_number_of_terms, _make_sector_codegen_jobs, \
+                          _make_sector_fingerprint
 from ..algebra import Function, Polynomial, Product, ProductRule, Sum
 from ..misc import sympify_expression
+from collections import Counter
 import sys, shutil
 import unittest
 import pytest
@@ -457,6 +461,79 @@ class TestMiscellaneous(unittest.TestCase):
 
         self.assertEqual(FORM_code, target_FORM_code)
 
+    #@pytest.mark.active
+    def test_estimate_number_of_terms(self):
+        poly = Polynomial([(1,0),(0,1),(0,0)], ['a','b','c'], polysymbols=['x','y'])
+        expression = Sum(Product(poly, poly, copy=False), poly, copy=False)
+        self.assertEqual(_estimate_number_of_terms(expression), 3*3 + 3)
+        self.assertEqual(_estimate_number_of_terms(Function('f', poly)), 1)
+
+    #@pytest.mark.active
+    def test_make_sector_fingerprint(self):
+        poly1 = Polynomial([(1,0),(0,1)], ['a','b'], polysymbols=['x','y'])
+        poly2 = Polynomial([(1,1),(0,0)], ['1','c'], polysymbols=['x','y'])
+        fingerprint = _make_sector_fingerprint([poly1], [poly1, poly2])
+
+        # the order within a list does not matter, the grouping does
+        self.assertEqual(_make_sector_fingerprint([poly1], [poly2, poly1]), fingerprint)
+        self.assertNotEqual(_make_sector_fingerprint([poly1, poly1], [poly2]), fingerprint)
+        self.assertNotEqual(_make_sector_fingerprint([poly2], [poly1, poly1]), fingerprint)
+
+    #@pytest.mark.active
+    def test_make_sector_codegen_jobs(self):
+        highest_poles = np.array([1])
+        regulator_powers = [np.array([0]), np.array([1]), np.array([2])]
+        order_terms = Counter({(-1,): 5, (1,): 7})
+
+        jobs = _make_sector_codegen_jobs(3, regulator_powers, highest_poles, order_terms)
+
+        target_jobs = [
+            (5, 'codegen/sector3.order1.info'),
+            (0, 'codegen/sector3.order2.info'),
+            (7, 'codegen/sector3.order3.info'),
+        ]
+        self.assertEqual(jobs, target_jobs)
+
+class TestDecompositionSelection(unittest.TestCase):
+    def setUp(self):
+        self.symbols = ['x','y','eps']
+        self.poly = Polynomial.from_expression('x + y + x*y', self.symbols)
+        self.exponentiated_poly = ExponentiatedPolynomial(self.poly.expolist, self.poly.coeffs, exponent='-2+eps', polysymbols=self.symbols)
+        self.sector = decomposition.Sector([self.exponentiated_poly], [Polynomial.from_expression('1 + x', self.symbols)])
+
+    #@pytest.mark.active
+    def test_estimate_decomposition_cost(self):
+        # 2 integration variables times (1 + 1 + 3 + 2) terms in the Jacobian, the monomial, the cast polynomial, and the other polynomial
+        self.assertEqual(_estimate_decomposition_cost([self.sector], 1), 14)
+        self.assertEqual(_estimate_decomposition_cost([self.sector, self.sector], 1), 28)
+
+    #@pytest.mark.active
+    def test_select_decomposition_method(self):
+        # the geometric method fails without `normaliz` --> must choose the iterative method
+        method, sectors = _select_decomposition_method(['iterative_no_primary', 'geometric_no_primary'], self.sector, 1, False, True,
+                                                       True, True, True, False, 'no-such-normaliz', 'tmpdir_test_select_decomposition_method', 1)
+        self.assertEqual(method, 'iterative_no_primary')
+        self.assertFalse(os.path.exists(os.path.join('tmpdir_test_select_decomposition_method', 'normaliz_workdir_geometric_no_primary')))
+
+        # the sectors of the winner are returned: no primary decomposition, all secondary sectors with the first primary sector
+        primary_sectors, secondary_sectors = sectors
+        self.assertEqual(len(primary_sectors), 1)
+        self.assertEqual(len(secondary_sectors), 1)
+        self.assertEqual(_estimate_decomposition_cost(secondary_sectors[0], 1), _estimate_decomposition_cost(
+            _decompose_for_cost_estimate(('iterative_no_primary', self.sector.copy(), 1, False, True, True, True, True, False,
+                                          'no-such-normaliz', 'tmpdir_test_select_decomposition_method'))[3][1][0], 1))
+
+        # a single candidate is not run
+        self.assertEqual(_select_decomposition_method(['geometric_no_primary'], self.sector, 1, False, True,
+                                                      True, True, True, False, 'no-such-normaliz', 'tmpdir_test_select_decomposition_method', 1),
+                         ('geometric_no_primary', None))
+
+        self.assertRaisesRegex(ValueError, 'Unknown', _select_decomposition_method, ['iterative_no_primary', 'no_such_method'], self.sector, 1, False, True,
+                               True, True, True, False, 'no-such-normaliz', 'tmpdir_test_select_decomposition_method', 1)
+
+        self.assertRaisesRegex(RuntimeError, 'failed', _select_decomposition_method, ['geometric_no_primary', 'geometric_infinity_no_primary'], self.sector, 1, False, True,
+                               True, True, True, False, 'no-such-normaliz', 'tmpdir_test_select_decomposition_method', 1)
+
 class TestWriteCppCodePrefactor(unittest.TestCase):
     #@pytest.mark.active
     def test_one_regulator(self):
@@ -573,6 +650,17 @@ class TestWriteCppCodeFunctionDeclaration(unittest.TestCase):
 
         self.assertEqual(code, target_code)
 
+class TestWriteDistsrcFunctionDeclaration(unittest.TestCase):
+    #@pytest.mark.active
+    def test_zero_args(self):
+        code = _make_distsrc_function_declaration(function_name = 'f', number_of_arguments = 0)
+        self.assertEqual(code, 'mathfn result_t f();')
+
+    #@pytest.mark.active
+    def test_two_args(self):
+        code = _make_distsrc_function_declaration(function_name = 'f', number_of_arguments = 2)
+        self.assertEqual(code, 'mathfn result_t f(arg0, arg1);')
+
 # --------------------------------- algebra helper ----------------------------------
 class TestRealPartFunction(unittest.TestCase):
     def setUp(self):
@@ -54,6 +54,26 @@ class TestTemplateParsing(unittest.TestCase):
 
         self.assertEqual(parsed, target_parsed)
 
+    #@pytest.mark.active
+    def test_parse_template_file_update(self):
+        path_to_template_file = os.path.join(self.tmpdir, 'template')
+        with open(path_to_template_file, 'w') as template_file:
+            template_file.write('inserting integer: %(number)i')
+        path_to_parsed_file = os.path.join(self.tmpdir, 'parsed')
+        parse_template_file(path_to_template_file, path_to_parsed_file, dict(number=1))
+
+        # an unchanged file is kept, including its modification time
+        os.utime(path_to_parsed_file, (0, 0))
+        parse_template_file(path_to_template_file, path_to_parsed_file, dict(number=1), update=True)
+        self.assertEqual(os.stat(path_to_parsed_file).st_mtime, 0)
+
+        # a changed file is replaced
+        parse_template_file(path_to_template_file, path_to_parsed_file, dict(number=2), update=True)
+        self.assertNotEqual(os.stat(path_to_parsed_file).st_mtime, 0)
+        with open(path_to_parsed_file, 'r') as parsed_file:
+            self.assertEqual(parsed_file.read(), 'inserting integer: 2')
+        self.assertEqual(set(os.listdir(self.tmpdir)), set(['template', 'parsed']))
+
     #@pytest.mark.active
     def test_parse_template_tree(self):
         # create template file tree
@@ -119,3 +139,10 @@ class TestTemplateParsing(unittest.TestCase):
             inserting string: Hello world'''
 
             self.assertEqual(parsed, target_parsed)
+
+class TestPylinkQmcTransforms(unittest.TestCase):
+    #@pytest.mark.active
+    def test_transform_selection(self):
+        replacements = generate_pylink_qmc_transform_selection(validate_pylink_qmc_transforms(['none','korobov3','sidi2','baker']))
+        self.assertEqual(replacements['pylink_qmc_transform_ids'], 'no_transform, korobov3x3, sidi2, baker')
+        self.assertEqual(replacements['pylink_qmc_transform_names'], '"none", "korobov3x3", "sidi2", "baker"')
@@ -5,7 +5,7 @@ The geometric sector decomposition routines.
 """
 
 from .common import Sector
-from ..polytope import convex_hull, triangulate, Polytope
+from ..polytope import convex_hull, triangulate_all, Polytope
 from ..algebra import Polynomial, Product, refactorize
 import itertools
 import numpy as np
@@ -227,13 +227,16 @@ def geometric_decomposition(sector, indices=None, normaliz=None, workdir='normal
         return subsector
 
 
+    # triangluate where neccessary, all cones in one go
+    # assert len(cone) > dim # --> this check is done by `triangulate_all`
+    cones_to_triangulate = [transformation[:,cone_indices].T for cone_indices in incidence_lists.values() if len(cone_indices) != dim]
+    triangulations = iter(triangulate_all(cones_to_triangulate, normaliz, workdir))
+
     for cone_indices in incidence_lists.values():
         cone = transformation[:,cone_indices].T
 
-        # triangluate where neccessary
         if len(cone_indices) != dim:
-            # assert len(cone) > dim # --> this check is done by `triangulate`
-            triangular_cones = triangulate(cone, normaliz, workdir)
+            triangular_cones = next(triangulations)
 
             assert len(triangular_cones.shape) == 3
             for i, triangular_cone in enumerate(triangular_cones):
@@ -333,8 +336,8 @@ def geometric_decomposition_ku(sector, indices=None, normaliz=None, workdir='nor
         return subsector
 
     fan = generate_fan( *(product.factors[1] for product in sector.cast) )
-    for cone in fan:
-        for dualcone in triangulate(cone, normaliz, workdir, switch_representation=True):
+    for cone, triangulation in zip(fan, triangulate_all(fan, normaliz, workdir, switch_representation=True)):
+        for dualcone in triangulation:
             # exclude lower dimensional cones
             if dualcone.shape[0] == cone.shape[1]:
                 yield make_sector_ku(dualcone.T)
@@ -10,10 +10,17 @@ Options:
     --points=X              begin integration with this lattice size (default: 1e4)
     --presamples=X          use this many points for presampling (default: 1e4)
     --shifts=X              use this many lattice shifts per integral (default: 32)
-    --cluster=X             use this cluster.json file
+    --cluster=X             use this cluster.json file; if it is edited during the run,
+                            workers are started or stopped to match it
     --coefficients=X        use coefficients from this directory
     --format=X              output the result in this format ("sympy", "mathematica", "json")
     --lattice-candidates=X  number of median lattice candidates, if X>0 (default: 0)
+    --cost-model=X          use the kernel cost model from this json file, as written
+                            by pySecDec.disteval_benchmark (default: cost_model.json
+                            next to the integrand file, if it exists)
+    --stage                 upload the libraries and coefficients to the workers instead
+                            of relying on a shared filesystem
+    --debug                 log the details of each kernel, not only the summaries
     --help                  show this help message
 Arguments:
     <var>=X                 set this integral or coefficient variable to a given value
@@ -22,17 +29,19 @@ Arguments:
 """
 
 import asyncio
+import base64
 import getopt
+import hashlib
 import json
 import math
 import numpy as np
 import os
 import random
-import re
 import subprocess
 import sympy as sp
 import sys
 import time
+import zlib
 
 from .generating_vectors import generating_vector, max_lattice_size
 from .misc import version
@@ -54,11 +63,18 @@ def log(*args):
             print(f"{h:.0f}:{m:02.0f}:{s:06.3f}]", *args, file=log_file)
     log_file.flush()
 
+log_debug = False
+def debug(*args):
+    if log_debug:
+        log(*args)
+
 def abs2(x):
     return np.real(x)**2 + np.imag(x)**2
 
 # Generic RPC
 
+READ_CHUNK_SIZE = 1024*1024
+
 def encode_message(data):
     return json.dumps(data,separators=(',',':')).encode("ascii") + b"\n"
 
@@ -68,6 +84,12 @@ def decode_message(binary):
 class WorkerException(Exception):
     pass
 
+# The error of the calls that a worker did not reply to before it exited
+WORKER_EXITED = "worker exited"
+
+def _dropped_cb(result, exception, w):
+    pass
+
 class Worker:
 
     def __init__(self, process, name=None):
@@ -75,26 +97,68 @@ class Worker:
         self.process = process
         self.serial = 0
         self.callbacks = {}
+        # A node-level sub-coordinator (see `disteval_node`)
+        # stands for `width` workers, and can integrate several
+        # shifts of a kernel in one call.
+        self.node = False
+        self.width = 1
+        self.batches = {} # token -> number of jobs in the call, minus one
+        self.nbatched = 0
+        # Called with the worker once it has exited (e.g. its node
+        # was reclaimed); the calls it has not replied to are then
+        # left in `callbacks`.
+        self.on_exit = None
+        self.exited = False
         self.reader_task = asyncio.get_event_loop().create_task(self._reader())
 
     def queue_size(self):
-        return len(self.callbacks)
+        return len(self.callbacks) + self.nbatched
 
-    def call_cb(self, method, args, callback, callback_args=()):
+    def call_cb(self, method, args, callback, callback_args=(), njobs=1):
         token = self.serial = self.serial + 1
         self.callbacks[token] = (callback, callback_args)
+        if njobs > 1:
+            self.batches[token] = njobs - 1
+            self.nbatched += njobs - 1
         message = encode_message((token, method, args))
         self.process.stdin.write(message)
         return token
 
+    def call_many_cb(self, calls):
+        """
+        Same as `call_cb()` for each of the `(method, args,
+        callback, callback_args, njobs)` calls, but send them all
+        with a single write. Return their tokens.
+        """
+        s0 = self.serial + 1
+        self.serial += len(calls)
+        parts = []
+        for token, (method, args, callback, callback_args, njobs) in enumerate(calls, s0):
+            self.callbacks[token] = (callback, callback_args)
+            if njobs > 1:
+                self.batches[token] = njobs - 1
+                self.nbatched += njobs - 1
+            parts.append(encode_message((token, method, args)))
+        self.process.stdin.write(b"".join(parts))
+        return range(s0, s0 + len(calls))
+
     def cancel_cb(self, token):
-        if token in self.callbacks:
-            self.callbacks[token] = (lambda a,b,c:None, ())
+        """
+        Drop the callback of a pending call, and ask the worker
+        to abandon the job: it will reply with the "cancelled"
+        error instead of the result, unless it was already done.
+        """
+        if token in self.callbacks and self.callbacks[token][0] is not _dropped_cb:
+            self.callbacks[token] = (_dropped_cb, ())
+            self.process.stdin.write(encode_message((0, "cancel", (token,))))
             return True
         return False
 
     def call(self, method, *args):
         fut = asyncio.futures.Future()
+        if self.exited:
+            fut.set_exception(WorkerException(WORKER_EXITED))
+            return fut
         def call_return(result, error, w):
             if error is None: fut.set_result(result)
             else: fut.set_exception(WorkerException(error))
@@ -103,6 +167,9 @@ class Worker:
 
     def multicall(self, calls):
         fut = asyncio.futures.Future()
+        if self.exited:
+            fut.set_exception(WorkerException(WORKER_EXITED))
+            return fut
         results = [None]*len(calls)
         ntodo = [len(calls)]
         def multicall_return(result, error, w, i):
@@ -111,9 +178,9 @@ class Worker:
                 ntodo[0] -= 1
                 if ntodo[0] == 0:
                     fut.set_result(results)
-            else:
+            elif not fut.done():
                 fut.set_exception(WorkerException(error))
-        s0 = self.serial
+        s0 = self.serial + 1
         self.serial += len(calls)
         parts = []
         for i, (method, args) in enumerate(calls):
@@ -123,25 +190,42 @@ class Worker:
         return fut
 
     async def _reader(self):
-        rx = re.compile(b"^@([a-zA-Z0-9_]+)(?: ([^\\n]*))?\n$")
+        # Read whatever replies have arrived in one go, instead of
+        # waiting for them line by line.
         line = None
+        tail = b""
         try:
             while True:
-                line = await self.process.stdout.readline()
-                if len(line) == 0: break
-                if line.startswith(b"@"):
-                    i, res, err = decode_message(line)
-                    callback, callback_args = self.callbacks[i]
-                    del self.callbacks[i]
-                    callback(res, err, self, *callback_args)
-                else:
-                    log(f"{self.name}: {line}")
+                data = await self.process.stdout.read(READ_CHUNK_SIZE)
+                if len(data) == 0: break
+                lines = (tail + data).split(b"\n")
+                tail = lines.pop()
+                for line in lines:
+                    if line.startswith(b"@"):
+                        i, res, err = decode_message(line)
+                        callback, callback_args = self.callbacks[i]
+                        del self.callbacks[i]
+                        self.nbatched -= self.batches.pop(i, 0)
+                        callback(res, err, self, *callback_args)
+                    else:
+                        log(f"{self.name}: {line!r}")
         except Exception as e:
             log(f"{self.name} reader failed: {type(e).__name__}: {e}")
             log(f"{self.name} line was {line!r}")
         log(f"{self.name} reader exited")
+        self.exited = True
+        if self.on_exit is not None:
+            self.on_exit(self)
 
-async def launch_worker(command, dirname, maxtimeout=10):
+async def launch_worker(command, dirname, maxtimeout=10, staged_files=None, node=False):
+    """
+    Start a worker and make it work in `dirname`. If `staged_files`
+    (a map from the worker kind to a map from file names to paths)
+    is given, the worker gets its own run directory instead, and
+    the files are uploaded there (see `stage_files()`). If `node`
+    is set, the command starts a node-level sub-coordinator, and
+    the number of its workers is queried.
+    """
     timeout = min(1, maxtimeout/10)
     while True:
         log(f"running: {command}")
@@ -149,80 +233,453 @@ async def launch_worker(command, dirname, maxtimeout=10):
             p = await asyncio.create_subprocess_shell(command, stdin=subprocess.PIPE, stdout=subprocess.PIPE)
         else:
             p = await asyncio.create_subprocess_exec(*command, stdin=subprocess.PIPE, stdout=subprocess.PIPE)
-        p.stdin.write(encode_message((0, "start", (dirname,))))
+        if staged_files is None:
+            p.stdin.write(encode_message((0, "start", (dirname,))))
+        else:
+            p.stdin.write(encode_message((0, "rundir", ())))
         answer = await p.stdout.readline()
+        local_error = None
         try:
             _, name, err = decode_message(answer)
             if err is not None:
                 log(f"worker startup fail: {err}")
+            elif staged_files is None:
+                w = Worker(p, name=name)
+                if node: w.node, w.width = True, await w.call("workers")
+                log(f"worker {w.name} connected" + (f" with {w.width} workers" if node else ""))
+                return w
             else:
+                name, kind, rundir, cachedir = name
                 w = Worker(p, name=name)
-                log(f"worker {w.name} connected")
+                w.cachedir = (name.split(":")[0], cachedir)
+                await stage_files(w, staged_files[kind])
+                w.name = await w.call("start", rundir)
+                if node: w.node, w.width = True, await w.call("workers")
+                log(f"worker {w.name} connected" + (f" with {w.width} workers" if node else "") + f", staged into {rundir}")
                 return w
         except Exception as e:
             log(f"failed to start worker: {type(e).__name__}: {e}")
+            local_error = e if isinstance(e, OSError) else None
         try:
             p.stdin.close()
             p.kill()
         except ProcessLookupError:
             pass
+        if local_error is not None:
+            # e.g. a file to be staged is unreadable; retrying will not help
+            raise local_error
         log(f"will retry after {timeout}s")
         await asyncio.sleep(timeout)
         timeout = min(timeout*2, maxtimeout)
 
+# File staging
+
+STAGE_CHUNK_SIZE = 4*1024*1024
+file_digests = {} # (path, size, mtime) -> future of the sha256 hex digest
+upload_locks = {} # (host, cachedir, digest) -> asyncio.Lock
+
+def _sha256_file(path):
+    h = hashlib.sha256()
+    with open(path, "rb") as f:
+        for chunk in iter(lambda: f.read(STAGE_CHUNK_SIZE), b""):
+            h.update(chunk)
+    return h.hexdigest()
+
+def file_digest(path):
+    st = os.stat(path)
+    key = (path, st.st_size, st.st_mtime_ns)
+    if key not in file_digests:
+        file_digests[key] = asyncio.get_event_loop().run_in_executor(None, _sha256_file, path)
+    return file_digests[key]
+
+def _pack_chunk(data):
+    return base64.b64encode(zlib.compress(data, 1)).decode("ascii")
+
+async def upload_file(w, path, digest):
+    loop = asyncio.get_event_loop()
+    total = os.path.getsize(path)
+    offset = 0
+    with open(path, "rb") as f:
+        while True:
+            data = f.read(STAGE_CHUNK_SIZE)
+            packed = await loop.run_in_executor(None, _pack_chunk, data)
+            await w.call("upload", digest, offset, len(data), total, packed)
+            offset += len(data)
+            if offset >= total: break
+
+async def unless_exited(w, aw):
+    """
+    Await the calls `aw` to the worker `w`, but if the worker has
+    exited meanwhile, return None instead of failing.
+    """
+    try:
+        return await aw
+    except WorkerException:
+        if not w.exited: raise
+
+async def stage_files(w, files):
+    """
+    Link the given files (a map from names to local paths) into
+    the run directory of the worker, uploading those that are not
+    yet in the cache of its node. Only one worker per node uploads
+    any given file.
+    """
+    names = list(files.keys())
+    digests = await asyncio.gather(*[file_digest(files[name]) for name in names])
+    have = await w.multicall([("have", (d,)) for d in digests])
+    for name, digest, h in zip(names, digests, have):
+        if h: continue
+        async with upload_locks.setdefault((*w.cachedir, digest), asyncio.Lock()):
+            if not await w.call("have", digest):
+                t0 = time.time()
+                await upload_file(w, files[name], digest)
+                log(f"uploaded {name} to {w.cachedir[0]} in {time.time() - t0:.3f}s")
+    await w.multicall([("link", (name, digest)) for name, digest in zip(names, digests)])
+
 # Generic scheduling
 
+SCHEDULE_CHUNK = 1024 # kernels per scheduling batch
+
+class ScheduledCall:
+    """
+    A call sent by the scheduler, which also serves as its
+    cancellation token: if its worker leaves the run, the call
+    is sent to another worker, and the token follows it.
+    """
+    __slots__ = ("worker", "token", "method", "args", "callback", "callback_args", "njobs", "parts")
+
+    def __init__(self, method, args, callback, callback_args, njobs=1):
+        self.worker = None
+        self.token = None
+        self.method = method
+        self.args = args
+        self.callback = callback
+        self.callback_args = callback_args
+        self.njobs = njobs
+        self.parts = None # the single-shift calls it was split into
+
 class RandomScheduler:
-    def __init__(self):
+    def __init__(self, staging=False):
+        self.staging = staging
         self.workers = []
         self.wspeed = []
+        self.calls = {} # worker -> {token: ScheduledCall}
+        self.orphans = [] # calls waiting for a worker to join
         self.npending = 0
         self.drained = asyncio.Event()
         self.drained.set()
 
     def add_worker(self, worker):
+        """
+        Add a worker to the run, even while it is going on: it
+        takes over the calls that had no worker left, or else its
+        share of the calls queued on the others.
+        """
         self.workers.append(worker)
-        self.wspeed.append(worker.speed)
+        self.wspeed.append(worker.speed*worker.width)
+        self.calls[worker] = {}
+        worker.on_exit = self._worker_exited
+        if len(self.orphans) > 0:
+            orphans, self.orphans = self.orphans, []
+            self._move(orphans)
+        else:
+            self.rebalance()
+
+    def remove_worker(self, worker):
+        """
+        Take a worker out of the run, and send the calls it has
+        not finished to the other workers. Return False if it was
+        not in the run.
+        """
+        if worker not in self.workers:
+            return False
+        i = self.workers.index(worker)
+        del self.workers[i]
+        del self.wspeed[i]
+        calls = self.calls.pop(worker)
+        for c in calls.values():
+            if worker.exited:
+                del worker.callbacks[c.token]
+                worker.nbatched -= worker.batches.pop(c.token, 0)
+            else:
+                worker.cancel_cb(c.token)
+        self._move(list(calls.values()))
+        return True
+
+    async def retire(self, worker):
+        """
+        Let a worker leave the run cleanly: its calls go to the
+        other workers, and it is stopped once it has replied to
+        all the calls sent to it.
+        """
+        if not self.remove_worker(worker):
+            return
+        log(f"worker {worker.name} is leaving the run")
+        while len(worker.callbacks) > 0 and not worker.exited:
+            await asyncio.sleep(0.1)
+        worker.process.stdin.close()
+        await worker.process.wait()
+        log(f"worker {worker.name} left the run")
+
+    def _worker_exited(self, worker):
+        if self.remove_worker(worker):
+            log(f"WARNING: worker {worker.name} exited; moved its jobs to the other workers")
+        # The calls not made through the scheduler fail.
+        for t, (callback, callback_args) in list(worker.callbacks.items()):
+            del worker.callbacks[t]
+            callback(None, WORKER_EXITED, worker, *callback_args)
 
     def queue_size(self):
         return sum(w.queue_size() for w in self.workers)
 
-    def call(self, method, *args):
-        w = min(random.choices(self.workers, weights=self.wspeed, k=3),
-                key=lambda w: w.queue_size())#/w.speed)
-        return w.call(method, *args)
+    def _choose(self):
+        return min(random.choices(self.workers, weights=self.wspeed, k=3),
+                key=lambda w: w.queue_size()/w.width)#/w.speed)
+
+    async def call(self, method, *args):
+        """
+        Call the method on one of the workers; if the worker exits
+        before replying, retry on another one.
+        """
+        while True:
+            w = self._choose()
+            try:
+                return await w.call(method, *args)
+            except WorkerException:
+                if not w.exited: raise
 
     def call_cb(self, method, args, callback, callback_args):
-        w = min(random.choices(self.workers, weights=self.wspeed, k=3),
-                key=lambda w: w.queue_size())#/w.speed)
         self.npending += 1
-        return (w, w.call_cb(method, args, self._cb, (callback, callback_args)))
+        return self._post(self._choose(), [ScheduledCall(method, args, callback, callback_args)])[0]
+
+    def _distribute(self, njobs):
+        """
+        Assign `njobs` new jobs to the workers so that their queue
+        sizes relative to their speeds become as even as possible;
+        return the worker index of each job. Consecutive jobs go
+        to the same worker.
+        """
+        speed = np.array(self.wspeed, dtype=np.float64)
+        queue = np.array([w.queue_size() for w in self.workers], dtype=np.float64)
+        order = np.argsort(queue/speed, kind="stable")
+        # Fill the least busy workers up to a common level.
+        level = (njobs + np.cumsum(queue[order]))/np.cumsum(speed[order])
+        k = np.nonzero(level >= queue[order]/speed[order])[0][-1]
+        share = np.clip(level[k]*speed - queue, 0, None)
+        count = np.floor(share).astype(np.int64)
+        extra = njobs - np.sum(count)
+        if extra > 0:
+            count[np.argsort(count - share, kind="stable")[:extra]] += 1
+        return np.repeat(np.arange(len(self.workers)), count)
+
+    def _post(self, w, calls):
+        """
+        Send the `ScheduledCall` calls to the worker `w` with a
+        single write; return them.
+        """
+        tokens = w.call_many_cb([(c.method, c.args, self._cb, (c,), c.njobs) for c in calls])
+        for c, t in zip(calls, tokens):
+            c.worker, c.token = w, t
+            self.calls[w][t] = c
+        return calls
+
+    def _send(self, calls):
+        """
+        Send the `(method, args, callback, callback_args, njobs)`
+        calls, grouped by the worker index; return the list of
+        cancellation tokens of each group.
+        """
+        tokens = {}
+        for i, wcalls in calls.items():
+            self.npending += len(wcalls)
+            tokens[i] = self._post(self.workers[i], [ScheduledCall(*c) for c in wcalls])
+        return tokens
+
+    def _move(self, calls):
+        """
+        Send the calls again, after their worker left the run or
+        to even out the queues. A batch of shifts goes to a node-
+        level sub-coordinator, or is split into single shifts if
+        there is none left.
+        """
+        if len(self.workers) == 0:
+            for c in calls: c.worker = None
+            self.orphans.extend(calls)
+            if len(calls) > 0:
+                log(f"WARNING: no workers left; {len(self.orphans)} jobs are waiting for a worker to join")
+            return
+        nodes = [i for i, w in enumerate(self.workers) if w.node]
+        owner = self._distribute(sum(c.njobs for c in calls)).tolist()
+        groups = {}
+        start = 0
+        for c in calls:
+            i = owner[start]
+            start += c.njobs
+            if c.method == "integrate_shifts" and not self.workers[i].node:
+                if len(nodes) == 0:
+                    self._split_shifts(c)
+                    continue
+                i = min(nodes, key=lambda i: self.workers[i].queue_size()/self.wspeed[i])
+            groups.setdefault(i, []).append(c)
+        for i, wcalls in groups.items():
+            self._post(self.workers[i], wcalls)
+
+    def _split_shifts(self, call):
+        """
+        Replace an "integrate_shifts" call with an "integrate" call
+        for each of its shifts, and reply to it once all of them
+        are done, or once any of them gives NaN.
+        """
+        args = call.args
+        shifts = args[5]
+        values = [None]*len(shifts)
+        stats = [0, 0.0, len(shifts)] # evaluations, time, shifts to go
+        def shift_cb(result, exception, w, s):
+            if stats[2] <= 0: return
+            if exception is not None:
+                stats[2] = 0
+                return call.callback(result, exception, w, *call.callback_args)
+            (re, im), di, dt = result[:3]
+            values[s] = (re, im)
+            stats[0] += di
+            stats[1] += dt
+            stats[2] -= 1
+            if re != re or im != im:
+                stats[2] = 0
+                return call.callback(([(re, im)]*len(shifts), stats[0], stats[1], *result[3:]), None, w, *call.callback_args)
+            if stats[2] == 0:
+                return call.callback((values, stats[0], stats[1]), None, w, *call.callback_args)
+        call.worker = None
+        call.parts = [
+            ScheduledCall("integrate", (*args[:5], shift, *args[6:]), shift_cb, (s,))
+            for s, shift in enumerate(shifts)
+        ]
+        # The parts are counted instead of the call itself.
+        self.npending += len(call.parts) - 1
+        self._move(call.parts)
+
+    def rebalance(self):
+        """
+        Move the queued calls that the busiest workers would only
+        start last to the least busy ones, e.g. to a worker that
+        has just joined. The calls that are already running are
+        left alone.
+        """
+        if len(self.workers) < 2: return
+        speed = np.array(self.wspeed, dtype=np.float64)
+        queue = np.array([w.queue_size() for w in self.workers], dtype=np.float64)
+        level = np.sum(queue)/np.sum(speed)
+        moved = []
+        for w, s, q in zip(self.workers, speed, queue):
+            excess = min(int(q - level*s), int(q) - w.width)
+            for c in reversed(list(self.calls[w].values())):
+                if c.njobs > excess: break
+                if w.cancel_cb(c.token):
+                    del self.calls[w][c.token]
+                    moved.append(c)
+                    excess -= c.njobs
+        if len(moved) > 0:
+            log(f"moving {sum(c.njobs for c in moved)} queued jobs to even out the workers")
+            self._move(moved)
+
+    def call_many_cb(self, method, argslist, callback, callback_args_list):
+        """
+        Schedule the call with each of the `argslist` at once;
+        return the cancellation token of each.
+        """
+        calls = {}
+        where = []
+        for i, args, callback_args in zip(self._distribute(len(argslist)).tolist(), argslist, callback_args_list):
+            wcalls = calls.setdefault(i, [])
+            where.append((i, len(wcalls)))
+            wcalls.append((method, args, callback, callback_args, 1))
+        tokens = self._send(calls)
+        return [tokens[i][k] for i, k in where]
+
+    def integrate_batch(self, jobs, callback, batch_callback):
+        """
+        Schedule the "integrate" call of each `(args, shifts,
+        callback_args)` job once for each of the `shifts`, which
+        are inserted at the position of the shift in `args`. The
+        shifts of all jobs are distributed at once. If a node-level
+        sub-coordinator gets the first shift of a job, all of them
+        are sent to it in one "integrate_shifts" call, and
+        `batch_callback` gets the values of all shifts at once;
+        otherwise `callback` is called for each shift, with its
+        index as the last argument. Return the list of the
+        cancellation tokens of the shifts of each job.
+        """
+        owner = self._distribute(sum(len(shifts) for args, shifts, callback_args in jobs)).tolist()
+        calls = {}
+        where = [] # (worker index, position, njobs) of each call
+        start = 0
+        for args, shifts, callback_args in jobs:
+            ws = owner[start:start + len(shifts)]
+            start += len(shifts)
+            w = self.workers[ws[0]]
+            if w.node and len(shifts) > 1:
+                wcalls = calls.setdefault(ws[0], [])
+                where.append((ws[0], len(wcalls), len(shifts)))
+                wcalls.append(("integrate_shifts", (*args[:5], shifts, *args[5:]), batch_callback, callback_args, len(shifts)))
+                continue
+            for s, (i, shift) in enumerate(zip(ws, shifts)):
+                wcalls = calls.setdefault(i, [])
+                where.append((i, len(wcalls), 1))
+                wcalls.append(("integrate", (*args[:5], shift, *args[5:]), callback, (*callback_args, s), 1))
+        tokens = self._send(calls)
+        tags = []
+        it = iter(where)
+        for args, shifts, callback_args in jobs:
+            tag = []
+            while len(tag) < len(shifts):
+                i, k, n = next(it)
+                tag.extend([tokens[i][k]]*n)
+            tags.append(tag)
+        return tags
+
+    def _cb(self, result, exception, worker, call):
+        del self.calls[worker][call.token]
+        # The callback may schedule more calls (e.g. after a NaN
+        # result), so count this one as done only afterwards.
+        try:
+            return call.callback(result, exception, worker, *call.callback_args)
+        finally:
+            self._done(1)
 
-    def _cb(self, result, exception, worker, callback, callback_args):
-        self.npending -= 1
+    def _done(self, n):
+        self.npending -= n
         if self.npending == 0:
             self.drained.set()
-        return callback(result, exception, worker, *callback_args)
 
-    def cancel_cb(self, token):
-        w, t = token
-        if w.cancel_cb(t):
-            self.npending -= 1
-            if self.npending == 0:
-                self.drained.set()
-            return True
+    def cancel_cb(self, call):
+        if call.parts is not None:
+            return sum(self.cancel_cb(c) for c in call.parts) > 0
+        if call.worker is None:
+            if call not in self.orphans: return False
+            self.orphans.remove(call)
+        elif call.worker.cancel_cb(call.token):
+            del self.calls[call.worker][call.token]
         else:
             return False
+        self._done(1)
+        return True
+
+    def cancel_all(self):
+        for w in self.workers:
+            for c in list(self.calls[w].values()):
+                self.cancel_cb(c)
+        for c in list(self.orphans):
+            self.cancel_cb(c)
 
     async def drain(self):
-        assert self.npending <= sum(len(w.callbacks) for w in self.workers)
+        assert self.npending <= sum(len(w.callbacks) for w in self.workers) + len(self.orphans)
         if self.npending > 0:
             self.drained.clear()
             await self.drained.wait()
 
 # Main
 
-async def benchmark_worker(w):
+async def benchmark_worker(w, nempty=1000):
     lattice, genvec = generating_vector(2, 10**3)
     shift = ([0.3, 0.8])
     deformp = ([1.0, 1.0])
@@ -239,7 +696,7 @@ async def benchmark_worker(w):
     t0 = time.time()
     bench0 = await asyncio.gather(*[
         w.call("integrate", 0, lattice, 0, 1, genvec, shift, deformp)
-        for i in range(1000)
+        for i in range(nempty)
     ])
     t1 = time.time()
     dt0 = min(dt for v, dn, dt in bench0)
@@ -277,16 +734,83 @@ def mul_variance(coef, var):
     vi = np.imag(var)
     return complex(cr2*vr + ci2*vi, ci2*vr + cr2*vi)
 
+# The largest factor by which the lattice of a kernel grows from
+# one round to the next. The proposed sizes extrapolate the variance
+# with the fitted scaling exponent, which is only reliable close to
+# the lattices already measured; the limit keeps a poor fit (e.g.
+# from a single lattice size) from spending a whole round on a far
+# too large lattice, at the cost of a few more rounds for kernels
+# far from their precision goal.
+MAX_LATTICE_GROWTH = 20
+
+def fit_scaling_exponents(moments, groups, default=2.0, nshifts=32, prior_sigma=0.5, amin=1.0, amax=6.0):
+    """
+    Estimate the exponent `a` of the variance scaling law
+    `var(n) = w/n^a` for each kernel from its history of
+    `(lattice, variance)` measurements, given as the moments
+    `(count, sum x, sum y, sum x^2, sum x*y)` of the points
+    `x = log(lattice)`, `y = log(variance)` of each kernel.
+
+    The exponent of each kernel is the least-squares slope of
+    `log(var)` versus `log(n)`, regularised towards a prior:
+    the pooled slope of all kernels within the same group
+    (family), which in turn is regularised towards `default`.
+    The regularisation weight follows from the variance of
+    `log(var)` estimated from `nshifts` shifts, and the assumed
+    spread `prior_sigma` of the exponents around the prior, so
+    kernels with a single lattice size get the prior, and the
+    fit takes over as the lattice history grows.
+    """
+    lam = 2/max(nshifts - 1, 1)/prior_sigma**2
+    count, sx, sy, sxx, sxy = np.asarray(moments, dtype=np.float64).reshape(-1, 5).T
+    fit = count >= 2
+    count = np.maximum(count, 1)
+    sxy = np.where(fit, sxy - sx*sy/count, 0)
+    sxx = np.where(fit, sxx - sx*sx/count, 0)
+    groups = np.asarray(groups)
+    a = np.empty(len(count))
+    for g in set(groups.tolist()):
+        mask = groups == g
+        prior = (lam*default - np.sum(sxy[mask]))/(np.sum(sxx[mask]) + lam)
+        a[mask] = (lam*prior - sxy[mask])/(sxx[mask] + lam)
+    return np.clip(a, amin, amax)
+
+def rescale_n(n, W2, w, a, V):
+    """
+    Rescale the lattice sizes `n` so that the total variance
+    `W2 @ (w/n**a)` becomes `V`, staying on the optimal cost
+    curve `n ~ mu^(1/(a+1))`. With a common exponent `a` this
+    is a uniform rescaling; otherwise the Lagrange multiplier
+    `mu` is found by bisection.
+    """
+    if np.all(a == a[0]):
+        return n * (1/V * (W2 @ (w/n**a)))**(1/a[0])
+    if V <= 0:
+        return n*np.inf
+    def logvar(s):
+        return np.log(W2 @ (w/(n*np.exp(s/(a+1)))**a)) - np.log(V)
+    lo, hi = -1.0, 1.0
+    while logvar(lo) < 0: lo *= 2
+    while logvar(hi) > 0: hi *= 2
+    for i in range(100):
+        mid = (lo + hi)/2
+        if logvar(mid) > 0: lo = mid
+        else: hi = mid
+        if hi - lo < 1e-12: break
+    return n*np.exp(hi/(a+1))
+
 def adjust_1d_n(W2, V, w, a, tau, nmin, nmax, allow_medianQMC):
+    a = np.broadcast_to(np.asarray(a, dtype=np.float64), w.shape)
     assert np.all(W2 > 0)
     assert np.all(w > 0)
     assert np.all(tau > 0)
     assert np.all(nmin > 0)
+    assert np.all(a > 0)
     if W2 @ (w/nmin**a) <= V:
         return nmin
-    n = (w/tau * W2)**(1/(a+1))
+    n = (a*w/tau * W2)**(1/(a+1))
     assert not np.any(np.isnan(n))
-    n *= (1/V * (W2 @ (w/n**a)))**(1/a)
+    n = rescale_n(n, W2, w, a, V)
     assert not np.any(np.isinf(n))
     assert not np.any(np.isnan(n))
     # if not using medianQMC: Enforce nmax, raising the rest
@@ -297,14 +821,14 @@ def adjust_1d_n(W2, V, w, a, tau, nmin, nmax, allow_medianQMC):
             maskc = np.count_nonzero(mask)
             if maskc == 0: break
             if maskc == len(n): return n
-            VV = V - (W2[mask] @ (w[mask]/n[mask]**a))
+            VV = V - (W2[mask] @ (w[mask]/n[mask]**a[mask]))
             if VV < 0:
                 log(f"Probably can't reach the target error now that {np.count_nonzero(mask)} integrals are capped at maximum lattice size")
                 log(f"... will still try though")
                 return n
             assert np.all(VV > 0)
             mask2 = (~mask)
-            n[mask2] *= (1/VV * (W2[mask2] @ (w[mask2]/n[mask2]**a)))**(1/a)
+            n[mask2] = rescale_n(n[mask2], W2[mask2], w[mask2], a[mask2], VV)
             assert not np.any(np.isinf(n))
             assert not np.any(np.isnan(n))
             add = (n > nmax)
@@ -317,9 +841,9 @@ def adjust_1d_n(W2, V, w, a, tau, nmin, nmax, allow_medianQMC):
         maskc = np.count_nonzero(mask)
         if maskc == 0: break
         if maskc == len(n): return n
-        VV = np.clip(V - W2[mask] @ (w[mask]/n[mask]**a), 0, np.inf)
+        VV = np.clip(V - W2[mask] @ (w[mask]/n[mask]**a[mask]), 0, np.inf)
         mask2 = (~mask)
-        n[mask2] *= (1/VV * (W2[mask2] @ (w[mask2]/n[mask2]**a)))**(1/a)
+        n[mask2] = rescale_n(n[mask2], W2[mask2], w[mask2], a[mask2], VV)
         add = (n < nmin)
         if not np.any(add): break
         mask |= add
@@ -330,14 +854,49 @@ def adjust_1d_n(W2, V, w, a, tau, nmin, nmax, allow_medianQMC):
 def adjust_n(W2, V, w, a, tau, nmin, nmax, allow_medianQMC, names=[]):
     assert np.all(V>0)
     assert len(W2) == len(V)
+    a = np.broadcast_to(np.asarray(a, dtype=np.float64), w.shape)
     n = nmin.copy()
     for i in range(len(W2)-1, -1, -1):
         mask = (w != 0) & (W2[i,:] != 0)
         if np.count_nonzero(mask) > 0:
-            n[mask] = adjust_1d_n(W2[i,mask], V[i], w[mask], a, tau[mask], n[mask], nmax[mask], allow_medianQMC)
+            n[mask] = adjust_1d_n(W2[i,mask], V[i], w[mask], a[mask], tau[mask], n[mask], nmax[mask], allow_medianQMC)
     return n
 
-async def prepare_eval(workers, datadir, intfile):
+# The time per point of a kernel, in the units of the builtin
+# gauge kernel, is predicted from the static metrics recorded by
+# export_sector as a linear combination of them. The coefficients
+# are roughly such that the gauge kernel itself comes out as 1;
+# better ones can be fitted with pySecDec.disteval_benchmark.
+DEFAULT_COST_MODEL = {
+    "point": 0.18,
+    "dimension": 0.1,
+    "operations": 0.006,
+    "transcendental": 0.1,
+    "calls": 0.03
+}
+
+def load_cost_model(filename):
+    with open(filename, "r") as f:
+        model = json.load(f)
+    unknown = set(model.keys()) - set(DEFAULT_COST_MODEL.keys())
+    if unknown:
+        raise ValueError(f"unknown cost model terms in {filename}: {', '.join(sorted(unknown))}")
+    return {key : float(model.get(key, 0)) for key in DEFAULT_COST_MODEL.keys()}
+
+def predict_kernel_cost(model, metrics):
+    """
+    Return the predicted time per point of a kernel relative to
+    the gauge kernel, given its metrics from `<family>.costs.json`.
+    """
+    return max(model["point"] + sum(c*metrics.get(key, 0) for key, c in model.items() if key != "point"), 1e-3)
+
+async def prepare_eval(workers, datadir, intfile, stage=False, cost_model=None, clusterfile=None):
+    """
+    Load the integrals, and start the `workers` (see
+    `load_worker_commands()`). If `clusterfile` is given, the
+    workers listed there may change during the evaluation (see
+    `Membership`).
+    """
     # Load the integrals from the requested json file
     t0 = time.time()
 
@@ -376,19 +935,52 @@ async def prepare_eval(workers, datadir, intfile):
             for ker in oo["kernels"]:
                 korders.setdefault((fam, ker), i)
 
-    log("Kernel ids:")
-    for (fam, ker), i in kernel2idx.items():
-        log(f"- ({fam}, {ker}) = k{i}")
+    if log_debug:
+        debug("Kernel ids:")
+        for (fam, ker), i in kernel2idx.items():
+            debug(f"- ({fam}, {ker}) = k{i}")
 
     family2idx = {fam:i for i, fam in enumerate(infos.keys())}
 
+    # Predict the time per point of each kernel from its static
+    # metrics, if those are available; the rest are assumed to be
+    # as fast as the gauge kernel.
+    if cost_model is None:
+        cost_model = os.path.join(datadir, "cost_model.json")
+        model = load_cost_model(cost_model) if os.path.exists(cost_model) else DEFAULT_COST_MODEL
+    else:
+        model = load_cost_model(cost_model)
+    kern_prior = np.ones(len(kernel2idx))
+    nprior = 0
+    for fam in infos.keys():
+        costfile = os.path.join(datadir, f"{fam}.costs.json")
+        if not os.path.exists(costfile): continue
+        with open(costfile, "r") as f:
+            costs = json.load(f)["kernels"]
+        for ker, metrics in costs.items():
+            if (fam, ker) in kernel2idx:
+                kern_prior[kernel2idx[fam, ker]] = predict_kernel_cost(model, metrics)
+                nprior += 1
+    log(f"got the cost estimates of {nprior} kernels")
+
     # Launch all the workers
     t1 = time.time()
 
-    par = RandomScheduler()
+    par = RandomScheduler(staging=stage)
+    staged_files = None
+    if stage:
+        libraries = ["builtin", *infos.keys()]
+        staged_files = {
+            kind : {
+                f"{lib}{ext}" : os.path.join(datadir, f"{lib}{ext}")
+                for lib in libraries for ext in extensions
+                if os.path.exists(os.path.join(datadir, f"{lib}{ext}"))
+            }
+            for kind, extensions in (("cpu", (".so",)), ("cuda", (".so", ".fatbin")))
+        }
 
-    async def add_worker(cmd):
-        w = await launch_worker(cmd, datadir)
+    async def start_worker(cmd, nempty=1000):
+        w = await launch_worker(worker_command(cmd), datadir, staged_files=staged_files, node=worker_is_node(cmd))
         await w.call("family", 0, "builtin", 2, (2.0, 0.1, 0.2, 0.3), (), True)
         await w.call("kernel", 0, 0, "gauge")
         await w.multicall([
@@ -399,12 +991,21 @@ async def prepare_eval(workers, datadir, intfile):
             ("kernel", (i+1, family2idx[fam]+1, ker))
             for (fam, ker), i in kernel2idx.items()
         ])
-        await benchmark_worker(w)
+        await benchmark_worker(w, nempty)
+        return w
+
+    # The workers that join later get a shorter benchmark, so that
+    # they start working sooner.
+    members = Membership(lambda cmd: start_worker(cmd, nempty=100), clusterfile)
+    async def add_worker(cmd):
+        w = await start_worker(cmd)
+        members.add(cmd, w)
         par.add_worker(w)
     await asyncio.gather(*[add_worker(cmd) for cmd in workers])
     log("workers:")
     for w in par.workers:
-        log(f"- {w.name}: int speed={w.speed:.2e}bps, int overhead={w.int_overhead:.2e}s, total overhead={w.overhead:.2e}s, latency={w.latency:.2e}s")
+        log(f"- {w.name}: " + (f"{w.width} workers, " if w.width > 1 else "") +
+            f"int speed={w.speed:.2e}bps, int overhead={w.int_overhead:.2e}s, total overhead={w.overhead:.2e}s, latency={w.latency:.2e}s")
 
     t2 = time.time()
 
@@ -417,13 +1018,15 @@ async def prepare_eval(workers, datadir, intfile):
         ampcount,
         korders,
         family2idx,
+        kern_prior,
         par,
         t1 - t0,
-        t2 - t1)
+        t2 - t1,
+        members)
 
 async def do_eval(prepared, coeffsdir, epsabs, epsrel, npresample, npoints0, nshifts, lattice_candidates, standard_lattices, valuemap_int, valuemap_coeff, deadline):
 
-    datadir, info, requested_orders, kernel2idx, infos, ampcount, korders, family2idx, par, t_init, t_worker = prepared
+    datadir, info, requested_orders, kernel2idx, infos, ampcount, korders, family2idx, kern_prior, par, t_init, t_worker, members = prepared
 
     if lattice_candidates == 0: standard_lattices=True
     if lattice_candidates > 0 and lattice_candidates % 2 == 0: lattice_candidates += 1
@@ -446,116 +1049,131 @@ async def do_eval(prepared, coeffsdir, epsabs, epsrel, npresample, npoints0, nsh
     }
     valuemap_coeff = {k : str(v) for k, v in valuemap_coeff.items()}
 
-    log(f"parsing {len(infos)} integral prefactors")
-    for ii in infos.values():
-        ii["expanded_prefactor_value"] = {
-            tuple(t["regulator_powers"]) : complex(sp.sympify(t["coefficient"]).subs(valuemap_int))
-            for t in ii["expanded_prefactor"]
-        }
-
-    await asyncio.gather(*[
-        w.multicall([
+    # The setup steps only wait for their own inputs: the presampling
+    # of each kernel follows the parameter update on each worker (the
+    # workers handle their input in order), and the first round of
+    # integration of each kernel starts as soon as its presampling is
+    # done (see `presample_cb()`). The prefactors and the coefficients
+    # are evaluated alongside, and only awaited when the errors of the
+    # sums are first combined.
+    def changefamily_calls():
+        return [
             ("changefamily", (i+1, realp[fam], complexp[fam]))
             for i, (fam, info) in enumerate(infos.items())
-        ])
+        ]
+    changefamily = asyncio.gather(*[
+        unless_exited(w, w.multicall(changefamily_calls()))
         for w in par.workers])
 
-    # Load the integral coefficients
     ap2coeffs = {} # (ampid, powerlist) -> coeflist
-    if info["type"] == "integral":
-        sum_names = [info["name"]]
-        br_coef = {(0,)*len(info["regulators"]): sp.sympify(1)}
-        split_integral_into_orders(ap2coeffs, 0, kernel2idx, info, br_coef, valuemap_int, sp_regulators, requested_orders)
-    elif info["type"] == "sum":
-        log("loading amplitude coefficients")
-        sum_names = list(info["sums"].keys())
-        done_evalf = asyncio.Future()
-        done_evalf.todo = sum(len(terms) for terms in info["sums"].values())
-        def evalf_cb(br_coef, exception, w, a, t):
-            if exception is not None:
-                done_evalf.set_exception(WorkerException(exception))
-                return
-            log("-", t["coefficient"])
-            br_coef = {tuple(k):complex(re, im) for k, (re, im) in br_coef}
-            split_integral_into_orders(ap2coeffs, a, kernel2idx, infos[t["integral"]], br_coef, valuemap_int, sp_regulators, requested_orders)
-            done_evalf.todo -= 1
-            if done_evalf.todo == 0:
-                done_evalf.set_result(None)
-        for a, terms in enumerate(info["sums"].values()):
-            for t in terms:
+    sum_names = [info["name"]] if info["type"] == "integral" else list(info["sums"].keys())
+
+    def coefficient_path(coefficient):
+        if par.staging:
+            return f"coefficients/{coefficient}"
+        return os.path.relpath(os.path.join(coeffsdir, coefficient), datadir)
+    coefficient_files = {}
+    if par.staging and info["type"] == "sum":
+        coefficient_files = {
+            coefficient_path(t["coefficient"]) : os.path.join(coeffsdir, t["coefficient"])
+            for terms in info["sums"].values() for t in terms
+        }
+
+    # The workers that join during the evaluation (see `Membership`)
+    # get the same setup as the others before any job.
+    async def admit(w):
+        await w.multicall(changefamily_calls())
+        if len(coefficient_files) > 0:
+            await stage_files(w, coefficient_files)
+    watcher = None
+    if members.clusterfile is not None:
+        watcher = asyncio.ensure_future(members.watch(par, admit))
+    W = W2 = W_re_var_coef = W_im_var_coef = None
+    t_coefficients = None
+
+    async def load_coefficients():
+        nonlocal ap2coeffs, W, W2, W_re_var_coef, W_im_var_coef, epsrel, epsabs, t_coefficients
+
+        log(f"parsing {len(infos)} integral prefactors")
+        for ii in infos.values():
+            ii["expanded_prefactor_value"] = {
+                tuple(t["regulator_powers"]) : complex(sp.sympify(t["coefficient"]).subs(valuemap_int))
+                for t in ii["expanded_prefactor"]
+            }
+            # Let the presampling callbacks run in between.
+            await asyncio.sleep(0)
+
+        # Load the integral coefficients
+        if info["type"] == "integral":
+            br_coef = {(0,)*len(info["regulators"]): sp.sympify(1)}
+            split_integral_into_orders(ap2coeffs, 0, kernel2idx, info, br_coef, valuemap_int, sp_regulators, requested_orders)
+        elif info["type"] == "sum":
+            log("loading amplitude coefficients")
+            if par.staging:
+                await asyncio.gather(*[unless_exited(w, stage_files(w, coefficient_files)) for w in par.workers])
+            # These calls are not tracked by the scheduler, so that
+            # `par.drain()` and `par.cancel_all()` only concern the
+            # integration jobs.
+            async def evalf(a, t):
                 intinfo = infos[t["integral"]]
                 pref_lord = np.min([o["regulator_powers"] for o in intinfo["expanded_prefactor"]], axis=0)
                 kern_lord = np.min([o["regulator_powers"] for o in intinfo["orders"]], axis=0)
                 coef_ord = - kern_lord - pref_lord + requested_orders
-                par.call_cb("evalf", (
-                        os.path.relpath(os.path.join(coeffsdir, t["coefficient"]), datadir),
-                        {k:str(v) for k,v in valuemap_coeff.items()},
-                        [[str(var), int(order)] for var, order in zip(sp_regulators, coef_ord)]
-                    ),
-                    evalf_cb,
-                    (a, t)
-                )
-        await done_evalf
-
-    # Sort in the (ampid, orderid) order to make the reporting
-    # stable. The code below should however work no matter the
-    # order here.
-    ap2coeffs = dict(sorted(ap2coeffs.items()))
-
-    W = np.stack([w for w in ap2coeffs.values()])
-    Wre2 = np.real(W)**2
-    Wim2 = np.imag(W)**2
-    W2 = Wre2 + Wim2
-    W_re_var_coef = Wre2 + 1j*Wim2
-    W_im_var_coef = Wim2 + 1j*Wre2
-    del Wre2, Wim2
-    log(f"will consider {len(ap2coeffs)} sums:")
-    for a, p in sorted(ap2coeffs.keys()):
-        log(f"- {sum_names[a]!r},", " ".join(f"{r}^{e}" for r, e in zip(sp_regulators, p)))
-
-    if len(epsrel) <= len(sum_names):
-        # Assume one epsrel per amplitude is specified, in the
-        # order of the amplitudes. If fewer are given, use the
-        # last entry as the default.
-        epsrel = [epsrel[a] if a < len(epsrel) else epsrel[-1] for a, p in ap2coeffs.keys()]
-    elif len(epsrel) == len(ap2coeffs):
-        # Assume one epsrel per amplitude*order is specified, in the
-        # order of the amplitudes. For advanced use only.
-        pass
-    else:
-        raise ValueError(f"Incorrect size of the epsrel array given")
-
-    if len(epsabs) <= len(sum_names):
-        # Assume one epsabs per amplitude is specified, in the
-        # order of the amplitudes. If fewer are given, use the
-        # last entry as the default.
-        epsabs = [epsabs[a] if a < len(epsabs) else epsabs[-1] for a, p in ap2coeffs.keys()]
-    elif len(epsabs) == len(ap2coeffs):
-        # Assume one epsabs per amplitude*order is specified, in the
-        # order of the amplitudes. For advanced use only.
-        pass
-    else:
-        raise ValueError(f"Incorrect size of the epsabs array given")
-
-    # Presample all kernels
-    kern_rng = [np.random.RandomState(0) for fam, ker in kernel2idx.keys()]
-    t2 = time.time()
-    log("distributing presampling jobs")
-    results = []
-    for i, (fam, ker) in enumerate(kernel2idx.keys()):
-        lattice, genvec = generating_vector(infos[fam]["dimension"], npresample)
-        f = par.call("maxdeformp", i+1, infos[fam]["deformp_count"],
-            lattice, genvec, kern_rng[i].rand(infos[fam]["dimension"]).tolist())
-        results.append(f)
-    log("waiting for the presampling results")
-    deformp = await asyncio.gather(*results)
-    deformp = [[min(max(x, 1e-6), 1.0) for x in defp] for defp in deformp]
-    for i, d in enumerate(deformp):
-        log(f"maxdeformp of k{i} is {d}")
+                br_coef = await par.call("evalf",
+                    coefficient_path(t["coefficient"]),
+                    {k:str(v) for k,v in valuemap_coeff.items()},
+                    [[str(var), int(order)] for var, order in zip(sp_regulators, coef_ord)])
+                log("-", t["coefficient"])
+                br_coef = {tuple(k):complex(re, im) for k, (re, im) in br_coef}
+                split_integral_into_orders(ap2coeffs, a, kernel2idx, intinfo, br_coef, valuemap_int, sp_regulators, requested_orders)
+            await asyncio.gather(*[
+                evalf(a, t)
+                for a, terms in enumerate(info["sums"].values())
+                for t in terms
+            ])
+
+        # Sort in the (ampid, orderid) order to make the reporting
+        # stable. The code below should however work no matter the
+        # order here.
+        ap2coeffs = dict(sorted(ap2coeffs.items()))
+
+        W = np.stack([w for w in ap2coeffs.values()])
+        Wre2 = np.real(W)**2
+        Wim2 = np.imag(W)**2
+        W2 = Wre2 + Wim2
+        W_re_var_coef = Wre2 + 1j*Wim2
+        W_im_var_coef = Wim2 + 1j*Wre2
+        del Wre2, Wim2
+        log(f"will consider {len(ap2coeffs)} sums:")
+        for a, p in sorted(ap2coeffs.keys()):
+            log(f"- {sum_names[a]!r},", " ".join(f"{r}^{e}" for r, e in zip(sp_regulators, p)))
+
+        if len(epsrel) <= len(sum_names):
+            # Assume one epsrel per amplitude is specified, in the
+            # order of the amplitudes. If fewer are given, use the
+            # last entry as the default.
+            epsrel = [epsrel[a] if a < len(epsrel) else epsrel[-1] for a, p in ap2coeffs.keys()]
+        elif len(epsrel) == len(ap2coeffs):
+            # Assume one epsrel per amplitude*order is specified, in the
+            # order of the amplitudes. For advanced use only.
+            pass
+        else:
+            raise ValueError(f"Incorrect size of the epsrel array given")
+
+        if len(epsabs) <= len(sum_names):
+            # Assume one epsabs per amplitude is specified, in the
+            # order of the amplitudes. If fewer are given, use the
+            # last entry as the default.
+            epsabs = [epsabs[a] if a < len(epsabs) else epsabs[-1] for a, p in ap2coeffs.keys()]
+        elif len(epsabs) == len(ap2coeffs):
+            # Assume one epsabs per amplitude*order is specified, in the
+            # order of the amplitudes. For advanced use only.
+            pass
+        else:
+            raise ValueError(f"Incorrect size of the epsabs array given")
+        t_coefficients = time.time()
 
     # Integrate the weighted sum
-    t3 = time.time()
-
     fams = [fam for fam, ker in kernel2idx.keys()]
     kers = [ker for fam, ker in kernel2idx.keys()]
     dims = [infos[fam]["dimension"] for fam in fams]
@@ -566,78 +1184,217 @@ async def do_eval(prepared, coeffsdir, epsabs, epsrel, npresample, npoints0, nsh
     for i in range(len(kernel2idx)):
         lattices[i], genvecs[i] = generating_vector(dims[i], npoints0)
     shift_val = np.full((len(kernel2idx), max(nshifts,lattice_candidates)), np.nan, dtype=np.complex128)
-    shift_rnd = np.empty((len(kernel2idx), max(nshifts,lattice_candidates)), dtype=object)
-    shift_tag = np.full((len(kernel2idx), max(nshifts,lattice_candidates)), None, dtype=object)
-    kern_db = np.ones(len(kernel2idx))
+    shift_rnd = np.empty(len(kernel2idx), dtype=object) # the shifts of the last run of each kernel
+    shift_tag = [[] for i in range(len(kernel2idx))] # the cancellation tokens of the last run
+    kern_rng = [np.random.RandomState(0) for fam, ker in kernel2idx.keys()]
+    deformp = [None] * len(kernel2idx)
+    kern_started = np.zeros(len(kernel2idx), dtype=bool) # integrated right after presampling
+    # Until measured, the cost of each kernel is the prior estimate
+    # with the weight of a single point.
+    kern_db = kern_prior.copy()
     kern_dt = np.ones(len(kernel2idx))
     kern_di = np.ones(len(kernel2idx))
     kern_val = np.zeros(len(kernel2idx), dtype=np.complex128)
     kern_var = np.full(len(kernel2idx), np.inf, dtype=np.complex128)
-
-    genvec_candidates = dict()
-
-    def shift_done_cb(result, exception, w, idx, shift):
-        (re, im), di, dt = result
-        if math.isnan(re) or math.isnan(im):
-            for s in range(nshifts):
-                par.cancel_cb(shift_tag[idx, s])
-            deformp[idx] = tuple(p*0.9 for p in deformp[idx])
-            log(f"got NaN from k{idx}; decreasing deformp by 0.9 to {deformp[idx]}")
-            schedule_kernel(idx)
+    # Variance of each kernel is assumed to scale as 1/lattice^a,
+    # with `a` fitted from the lattice history of that kernel,
+    # which is kept as the moments of the (log lattice, log
+    # variance) points (see `fit_scaling_exponents()`).
+    default_scaling = 2
+    kern_hist = np.zeros((len(kernel2idx), 5))
+    kern_scaling = np.full(len(kernel2idx), default_scaling, dtype=np.float64)
+
+    # The results are only collected as they arrive, and stored
+    # into the arrays above all at once by `ingest_results()`.
+    # A NaN result restarts its kernel, and increments its
+    # generation, so that the results of the abandoned run that
+    # are still in flight are ignored.
+    kern_gen = np.zeros(len(kernel2idx), dtype=np.int64)
+    new_values = [] # (idx, shift, generation, re, im)
+    new_stats = [] # (idx, di, dt, overhead, speed)
+    nan_causes = {} # cause -> count
+    # Restarts of each kernel with new shifts only, after a NaN
+    # that no deformation could fix.
+    max_nan_reshifts = 3
+    kern_reshifts = np.zeros(len(kernel2idx), dtype=np.int64)
+    # Restarts of each kernel after a job failed because its worker
+    # exited (e.g. a local worker of a node); any other error of a
+    # job stops the evaluation once the pending jobs are cancelled.
+    max_exit_restarts = 3
+    kern_exit_restarts = np.zeros(len(kernel2idx), dtype=np.int64)
+    job_errors = []
+
+    genvec_candidates = dict() # idx -> the candidate generating vectors
+
+    def got_nan(idx, where):
+        # The workers locate the first failing point, and find the
+        # deformation that makes it finite (see "nanpoint.h"); if
+        # they can not, lower all deformation parameters blindly.
+        for tag in shift_tag[idx]:
+            par.cancel_cb(tag)
+        kern_gen[idx] += 1
+        cause = "unlocated" if where is None else where[2]
+        nan_causes[cause] = nan_causes.get(cause, 0) + 1
+        if where is not None and where[3] is not None:
+            deformp[idx] = tuple(min(p, q) for p, q in zip(deformp[idx], where[3]))
+            debug(f"got NaN ({cause}) from k{idx} at point {where[0]}, x={where[1]}; lowering deformp to {deformp[idx]}")
+        elif where is not None and kern_reshifts[idx] < max_nan_reshifts:
+            kern_reshifts[idx] += 1
+            debug(f"got NaN ({cause}) from k{idx} at point {where[0]}, x={where[1]}, which no deformation fixes; retrying with new shifts")
         else:
-            shift_val[idx, shift] = complex(re, im)
-            if dt > 2*w.int_overhead:
-                kern_db[idx] += (dt - w.int_overhead)*w.speed
-                kern_di[idx] += di
-                kern_dt[idx] += dt
-
-    def schedule_kernel(idx):
-        for s in range(nshifts):
-            shift = kern_rng[idx].rand(dims[idx])
-            shift_rnd[idx, s] = shift
-            shift_tag[idx, s] = par.call_cb("integrate",
-                (idx+1, int(lattices[idx]), 0, int(lattices[idx]), genvecs[idx],
-                shift.tolist(),
-                deformp[idx]),
-                shift_done_cb, (idx, s))
-
-    def shift_done_cb_median_lattice(result, exception, w, idx, shift):
-        (re, im), di, dt = result
-        if math.isnan(re) or math.isnan(im):
-            for s in range(lattice_candidates):
-                par.cancel_cb(shift_tag[idx, s])
             deformp[idx] = tuple(p*0.9 for p in deformp[idx])
-            log(f"got NaN from k{idx}; decreasing deformp by 0.9 to {deformp[idx]}")
-            schedule_kernel_median_lattice(idx)
+            debug(f"got NaN ({cause}) from k{idx}; decreasing deformp by 0.9 to {deformp[idx]}")
+
+    def job_failed(idx, gen, exception, reschedule):
+        if gen != kern_gen[idx]: return
+        if exception == WORKER_EXITED and kern_exit_restarts[idx] < max_exit_restarts:
+            kern_exit_restarts[idx] += 1
+            for tag in shift_tag[idx]:
+                par.cancel_cb(tag)
+            kern_gen[idx] += 1
+            debug(f"a job of k{idx} failed: {exception}; restarting the kernel")
+            reschedule([idx])
+        else:
+            job_errors.append(f"k{idx}: {exception}")
+            par.cancel_all()
+
+    def check_job_errors():
+        if len(job_errors) > 0:
+            raise WorkerException(f"{len(job_errors)} integration jobs failed, e.g. {job_errors[0]}")
+
+    def shift_done_cb(result, exception, w, idx, gen, shift):
+        if exception is not None:
+            job_failed(idx, gen, exception, schedule_kernels)
+            return
+        (re, im), di, dt = result[:3]
+        if re != re or im != im:
+            if gen == kern_gen[idx]:
+                got_nan(idx, result[3] if len(result) > 3 else None)
+                schedule_kernels([idx])
         else:
-            shift_val[idx, shift] = complex(re, im)
-            if dt > 2*w.int_overhead:
-                kern_db[idx] += (dt - w.int_overhead)*w.speed
-                kern_di[idx] += di
-                kern_dt[idx] += dt
-
-    def schedule_kernel_median_lattice(idx):
-        for s in range(lattice_candidates):
-            shift = kern_rng[idx].rand(dims[idx])
-            shift_rnd[idx, s] = shift
-            def rand():
-                r = 0
-                while math.gcd(int(lattices[idx]),r) != 1:
-                    r = kern_rng[idx].randint(1,(lattices[idx])-1)
-                return r
-            genvec_candidates[(idx, s)] = tuple( rand() for _ in range(dims[idx]) )
-            shift_tag[idx, s] = par.call_cb("integrate",
-                (idx+1, int(lattices[idx]), 0, int(lattices[idx]), genvec_candidates[(idx,s)],
-                shift.tolist(),
-                deformp[idx]),
-                shift_done_cb_median_lattice, (idx, s))
+            new_values.append((idx, shift, gen, re, im))
+            new_stats.append((idx, di, dt, w.int_overhead, w.speed))
+
+    def shifts_done_cb(result, exception, w, idx, gen):
+        if exception is not None:
+            job_failed(idx, gen, exception, schedule_kernels)
+            return
+        values, di, dt = result[:3]
+        if any(re != re or im != im for re, im in values):
+            if gen == kern_gen[idx]:
+                got_nan(idx, result[3] if len(result) > 3 else None)
+                schedule_kernels([idx])
+        else:
+            new_values.extend((idx, s, gen, re, im) for s, (re, im) in enumerate(values))
+            new_stats.append((idx, di, dt, w.int_overhead*len(values), w.speed))
+
+    def shift_done_cb_median_lattice(result, exception, w, idx, gen, shift):
+        if exception is not None:
+            job_failed(idx, gen, exception, schedule_kernels_median_lattice)
+            return
+        (re, im), di, dt = result[:3]
+        if re != re or im != im:
+            if gen == kern_gen[idx]:
+                got_nan(idx, result[3] if len(result) > 3 else None)
+                schedule_kernels_median_lattice([idx])
+        else:
+            new_values.append((idx, shift, gen, re, im))
+            new_stats.append((idx, di, dt, w.int_overhead, w.speed))
+
+    def ingest_results():
+        if len(nan_causes) > 0:
+            causes = ", ".join(f"{c}: {n}" for c, n in sorted(nan_causes.items()))
+            log(f"got NaN {sum(nan_causes.values())} times ({causes}); lowered the deformation where needed, and restarted those kernels")
+            nan_causes.clear()
+        if len(new_values) > 0:
+            idx, s, gen, re, im = np.array(new_values, dtype=np.float64).T
+            idx = idx.astype(np.int64)
+            s = s.astype(np.int64)
+            current = gen == kern_gen[idx]
+            shift_val[idx[current], s[current]] = re[current] + 1j*im[current]
+            new_values.clear()
+        if len(new_stats) > 0:
+            idx, di, dt, overhead, speed = np.array(new_stats, dtype=np.float64).T
+            idx = idx.astype(np.int64)
+            busy = dt > 2*overhead
+            np.add.at(kern_db, idx[busy], (dt[busy] - overhead[busy])*speed[busy])
+            np.add.at(kern_di, idx[busy], di[busy])
+            np.add.at(kern_dt, idx[busy], dt[busy])
+            new_stats.clear()
+
+    def schedule_kernels(idxs):
+        jobs = []
+        for idx in idxs:
+            shifts = kern_rng[idx].rand(nshifts, dims[idx])
+            shift_rnd[idx] = shifts
+            jobs.append((
+                (idx+1, int(lattices[idx]), 0, int(lattices[idx]), genvecs[idx], deformp[idx]),
+                shifts.tolist(),
+                (idx, int(kern_gen[idx]))))
+        for idx, tags in zip(idxs, par.integrate_batch(jobs, shift_done_cb, shifts_done_cb)):
+            shift_tag[idx] = tags
+
+    def schedule_kernels_median_lattice(idxs):
+        argslist = []
+        callback_args = []
+        for idx in idxs:
+            lattice = int(lattices[idx])
+            shifts = kern_rng[idx].rand(lattice_candidates, dims[idx])
+            shift_rnd[idx] = shifts
+            # Random generating vectors, coprime to the lattice size.
+            genvec = kern_rng[idx].randint(1, lattice-1, size=(lattice_candidates, dims[idx]))
+            bad = np.gcd(genvec, lattice) != 1
+            while np.any(bad):
+                genvec[bad] = kern_rng[idx].randint(1, lattice-1, size=np.count_nonzero(bad))
+                bad = np.gcd(genvec, lattice) != 1
+            genvec_candidates[idx] = genvec
+            for s in range(lattice_candidates):
+                argslist.append((idx+1, lattice, 0, lattice, genvec[s].tolist(), shifts[s].tolist(), deformp[idx]))
+                callback_args.append((idx, int(kern_gen[idx]), s))
+        tags = par.call_many_cb("integrate", argslist, shift_done_cb_median_lattice, callback_args)
+        for k, idx in enumerate(idxs):
+            shift_tag[idx] = tags[k*lattice_candidates:(k+1)*lattice_candidates]
+
+    # Presample all kernels. The first round of a kernel needs
+    # nothing else, unless its lattice is to be constructed by the
+    # median QMC rules, which is left to `iterate_integration()`.
+    t2 = time.time()
+    presampled = asyncio.Future()
+    presampled.todo = len(kernel2idx)
+    t_presampled = None
+
+    def presample_cb(defp, exception, w, idx):
+        nonlocal t_presampled
+        if presampled.done(): return
+        if exception is not None:
+            presampled.set_exception(WorkerException(exception))
+            return
+        deformp[idx] = [min(max(x, 1e-6), 1.0) for x in defp]
+        debug(f"maxdeformp of k{idx} is {deformp[idx]}")
+        if lattice_candidates == 0 or (standard_lattices and lattices[idx] <= maxlattices[idx]):
+            kern_started[idx] = True
+            schedule_kernels([idx])
+        presampled.todo -= 1
+        if presampled.todo == 0:
+            t_presampled = time.time()
+            presampled.set_result(None)
+
+    log("distributing presampling jobs")
+    for i, (fam, ker) in enumerate(kernel2idx.keys()):
+        lattice, genvec = generating_vector(infos[fam]["dimension"], npresample)
+        par.call_cb("maxdeformp", (i+1, infos[fam]["deformp_count"],
+            lattice, genvec, kern_rng[i].rand(infos[fam]["dimension"]).tolist()),
+            presample_cb, (i,))
+    coefficients = asyncio.ensure_future(load_coefficients())
+    await changefamily
+    t3 = time.time()
 
     perkern_epsrel = 0.2
     perkern_epsabs = 1e-4
 
     def propose_lattices1(amp_val, amp_var):
-        scaling = 2
-        K = 20
+        scaling = kern_scaling
+        K = MAX_LATTICE_GROWTH
         kern_maxvar = np.maximum(perkern_epsabs**2, abs2(kern_val)*perkern_epsrel**2)
         kern_absvar = np.real(kern_var) + np.imag(kern_var)
         if np.all(kern_absvar <= kern_maxvar):
@@ -651,8 +1408,8 @@ async def do_eval(prepared, coeffsdir, epsabs, epsrel, npresample, npoints0, nsh
         return n
 
     def propose_lattices2(amp_val, amp_var):
-        scaling = 2
-        K = 20
+        scaling = kern_scaling
+        K = MAX_LATTICE_GROWTH
         amp_absval = np.sqrt(abs2(amp_val))
         amp_abserr = np.sqrt(np.real(amp_var) + np.imag(amp_var))
         log("absval =", amp_absval)
@@ -679,22 +1436,86 @@ async def do_eval(prepared, coeffsdir, epsabs, epsrel, npresample, npoints0, nsh
             n[toosmall] = lattices[toosmall]
         return n
 
+    # With a deadline, the lattice sizes are chosen so that the next
+    # round is expected to finish in time. The duration of a round
+    # is estimated from the measured cost of each kernel (`tau`, in
+    # benchmark evaluations per point), the total speed of the
+    # workers, and the per-job overhead, and corrected by the ratio
+    # of the measured to the estimated duration of the last round.
+    # The totals are taken anew for each estimate, as the workers
+    # may join or leave during the run.
+    deadline_margin = 0.9
+    round_slack = 1.0
+
+    def round_duration(n, mask):
+        if len(par.workers) == 0:
+            return math.inf
+        total_speed = sum(par.wspeed)
+        total_width = sum(w.width for w in par.workers)
+        job_overhead = np.mean([w.overhead for w in par.workers])
+        tau = kern_db[mask]/kern_di[mask]
+        njobs = np.full(np.count_nonzero(mask), nshifts)
+        if lattice_candidates > 0:
+            njobs += lattice_candidates*((n[mask] > maxlattices[mask]) if standard_lattices else 1)
+        work = np.sum(njobs*(n[mask]*tau/total_speed + job_overhead/total_width))
+        # A job runs on a single worker, so no round is shorter
+        # than its longest job.
+        longest = np.max(n[mask]*tau, initial=0)*total_width/total_speed
+        return max(work, longest)
+
+    def fit_lattices_to_deadline(n):
+        """
+        Shrink the proposed lattice sizes `n` so that the next round
+        is expected to finish before the deadline. The sizes are
+        moved towards the current ones geometrically, which keeps
+        their proportions (and so the optimal distribution of the
+        error found by the planner); kernels that would grow by less
+        than 2x (or less than proposed, if that is below 2x) are
+        not rerun at all. Return None if not even the smallest such
+        round fits.
+        """
+        if deadline == math.inf:
+            return n
+        budget = deadline_margin*(deadline - time.time())/round_slack
+        if round_duration(n, n > lattices) <= budget:
+            return n
+        ratio = n/lattices
+        def shrink(t):
+            m = lattices*ratio**t
+            return np.where(m >= np.minimum(2, ratio)*lattices, m, lattices)
+        lo, hi = 0.0, 1.0
+        for i in range(30):
+            mid = (lo + hi)/2
+            m = shrink(mid)
+            if round_duration(m, m > lattices) <= budget: lo = mid
+            else: hi = mid
+        m = shrink(lo)
+        if not np.any(m > lattices):
+            return None
+        log(f"{deadline - time.time():.1f}s left until the deadline; limiting the growth of the lattices to fit")
+        return m
+
     early_exit = False
 
     async def iterate_integration(propose_lattices):
-        nonlocal early_exit
+        nonlocal early_exit, round_slack
         while True:
+            t_round = time.time()
+            if not presampled.done():
+                log("waiting for the presampling results")
+                await presampled
             mask_todo = lattices != oldlattices
+            kern_reshifts[mask_todo & ~kern_started] = 0
             if np.any(mask_todo):
                 # Schedule all kernels in mask_todo
                 # Construct lattices using medianQmc if required
                 if lattice_candidates > 0:
-                    for i in mask_todo.nonzero()[0]:
-                        if(not standard_lattices or lattices[i] > maxlattices[i]):
-                            schedule_kernel_median_lattice(int(i))
-                            await asyncio.sleep(0)
+                    idxs = (mask_todo if not standard_lattices else mask_todo & (lattices > maxlattices)).nonzero()[0].tolist()
+                    for k in range(0, len(idxs), SCHEDULE_CHUNK):
+                        schedule_kernels_median_lattice(idxs[k:k+SCHEDULE_CHUNK])
+                        await asyncio.sleep(0)
                     if par.queue_size() > 0:
-                        log(f"distributing {par.queue_size()//lattice_candidates}*{lattice_candidates} jobs to construct generating vectors")
+                        log(f"distributing {len(idxs)}*{lattice_candidates} jobs to construct generating vectors")
                         log("worker queue sizes:")
                         for w in par.workers:
                             log(f"- {w.name}: {w.queue_size()}")
@@ -704,23 +1525,31 @@ async def do_eval(prepared, coeffsdir, epsabs, epsrel, npresample, npoints0, nsh
                         await asyncio.wait_for(par.drain(), timeout=tilldeadline)
                     except asyncio.TimeoutError:
                         log("WARNING: timeout reached, will stop soon")
+                        par.cancel_all()
                         early_exit = True
-                    def signedMax(x):
-                        if isinstance(x,complex):
-                            return x.real if abs(x.real) > abs(x.imag) else x.imag
-                        else: return x
-                    for i in mask_todo.nonzero()[0]:
-                        if(not standard_lattices or lattices[i] > maxlattices[i]):
-                            median = np.median([signedMax(x) for x in shift_val[i,:lattice_candidates]])
-                            for s in range(lattice_candidates):
-                                if signedMax(shift_val[i,s]) == median:
-                                    genvecs[i] = list(genvec_candidates[(i,s)])
-                                shift_val[i,s] = np.nan
-
-                # Run integration
-                log(f"distributing {np.count_nonzero(mask_todo)}*{nshifts} integration jobs")
-                for i in mask_todo.nonzero()[0]:
-                    schedule_kernel(int(i))
+                    check_job_errors()
+                    ingest_results()
+                    if len(idxs) > 0:
+                        # Choose the candidate with the median value,
+                        # taking the larger of the real and the
+                        # imaginary parts.
+                        val = shift_val[idxs, :lattice_candidates]
+                        val = np.where(np.abs(np.real(val)) > np.abs(np.imag(val)), np.real(val), np.imag(val))
+                        median = np.argsort(val, axis=1, kind="stable")[:, lattice_candidates//2]
+                        complete = ~np.any(np.isnan(val), axis=1)
+                        for idx, s in zip(np.array(idxs)[complete].tolist(), median[complete].tolist()):
+                            genvecs[idx] = genvec_candidates[idx][s].tolist()
+                        shift_val[idxs, :lattice_candidates] = np.nan
+
+                # Run integration, except for the kernels that were
+                # started right after their presampling
+                idxs = (mask_todo & ~kern_started).nonzero()[0].tolist()
+                nstarted = np.count_nonzero(mask_todo & kern_started)
+                kern_started[:] = False
+                log(f"distributing {len(idxs)}*{nshifts} integration jobs" +
+                    (f" ({nstarted} kernels already started after presampling)" if nstarted > 0 else ""))
+                for k in range(0, len(idxs), SCHEDULE_CHUNK):
+                    schedule_kernels(idxs[k:k+SCHEDULE_CHUNK])
                     await asyncio.sleep(0)
                 log("worker queue sizes:")
                 for w in par.workers:
@@ -734,7 +1563,15 @@ async def do_eval(prepared, coeffsdir, epsabs, epsrel, npresample, npoints0, nsh
                     await asyncio.wait_for(par.drain(), timeout=tilldeadline)
                 except asyncio.TimeoutError:
                     log("WARNING: timeout reached, will stop soon")
+                    par.cancel_all()
                     early_exit = True
+                check_job_errors()
+                ingest_results()
+                if not early_exit:
+                    estimate = round_duration(lattices, mask_todo)
+                    if 0 < estimate < math.inf:
+                        round_slack = np.clip((time.time() - t_round)/estimate, 0.25, 10)
+                        debug(f"the round took {round_slack:.3g}x the estimated time")
 
                 # Not all kernels might be done due to an early exit
                 mask_done = np.logical_and(mask_todo, ~np.any(np.isnan(shift_val[:,:nshifts]), axis=1))
@@ -748,22 +1585,35 @@ async def do_eval(prepared, coeffsdir, epsabs, epsrel, npresample, npoints0, nsh
 
                 latticex = lattices[mask_done]/oldlattices[mask_done]
                 precisionx = np.sqrt((np.real(kern_var[mask_done]) + np.imag(kern_var[mask_done])) / (np.real(new_kern_var) + np.imag(new_kern_var)))
-                ratiox = kern_val[mask_done]/new_kern_val
                 with np.errstate(all='ignore'):
                     sigmarx = np.abs(np.real(kern_val[mask_done]-new_kern_val))/np.sqrt(np.maximum( np.abs(np.real(kern_var[mask_done])), np.abs(np.real(new_kern_var)) ))
                     sigmaix = np.abs(np.imag(kern_val[mask_done]-new_kern_val))/np.sqrt(np.maximum( np.abs(np.imag(kern_var[mask_done])), np.abs(np.imag(new_kern_var)) ))
-                for i, idx in enumerate(mask_done.nonzero()[0]):
-                    idx = int(idx)
-                    if precisionx[i] < 1.0:
-                        log(f"k{idx} @ {lattices[idx]:.3e} = {new_kern_val[i]:.16e} ~ {new_kern_var[i]:.3e} ({1/precisionx[i]:.4g}x worse at {latticex[i]:.1f}x lattice; {sigmarx[i]:.3g}+{sigmaix[i]:.3g}j sigma)")
-                    else:
-                        log(f"k{idx} @ {lattices[idx]:.3e} = {new_kern_val[i]:.16e} ~ {new_kern_var[i]:.3e} ({precisionx[i]:.4g}x better at {latticex[i]:.1f}x lattice; {sigmarx[i]:.3g}+{sigmaix[i]:.3g}j sigma)")
-                    if (sigmarx[i] > 10. or sigmaix[i] > 10.) and not math.isnan(latticex[i]):
-                        log(f"WARNING: unlikely that new result is compatible with old, {new_kern_val[i]} ~ {np.sqrt(new_kern_var[i])} vs {kern_val[mask_done][i]} ~ {np.sqrt(kern_var[mask_done][i])}")
+                incompatible = ((sigmarx > 10.) | (sigmaix > 10.)) & ~np.isnan(latticex)
+                if log_debug:
+                    for i, idx in enumerate(mask_done.nonzero()[0]):
+                        idx = int(idx)
+                        if precisionx[i] < 1.0:
+                            debug(f"k{idx} @ {lattices[idx]:.3e} = {new_kern_val[i]:.16e} ~ {new_kern_var[i]:.3e} ({1/precisionx[i]:.4g}x worse at {latticex[i]:.1f}x lattice; {sigmarx[i]:.3g}+{sigmaix[i]:.3g}j sigma)")
+                        else:
+                            debug(f"k{idx} @ {lattices[idx]:.3e} = {new_kern_val[i]:.16e} ~ {new_kern_var[i]:.3e} ({precisionx[i]:.4g}x better at {latticex[i]:.1f}x lattice; {sigmarx[i]:.3g}+{sigmaix[i]:.3g}j sigma)")
+                        if incompatible[i]:
+                            debug(f"WARNING: unlikely that new result of k{idx} is compatible with old, {new_kern_val[i]} ~ {np.sqrt(new_kern_var[i])} vs {kern_val[idx]} ~ {np.sqrt(kern_var[idx])}")
+                if np.any(incompatible):
+                    log(f"WARNING: unlikely that the new results of {np.count_nonzero(incompatible)} kernels are compatible with the old ones")
+                new_kern_absvar = np.real(new_kern_var) + np.imag(new_kern_var)
+                valid = (0 < new_kern_absvar) & (new_kern_absvar < np.inf)
+                x = np.log(lattices[mask_done][valid])
+                y = np.log(new_kern_absvar[valid])
+                kern_hist[mask_done.nonzero()[0][valid]] += np.stack([np.ones_like(x), x, y, x*x, x*y], axis=1)
+                kern_scaling[:] = fit_scaling_exponents(kern_hist, fams, default_scaling, nshifts)
+                log(f"variance scaling exponents: min={np.min(kern_scaling):.3g}, median={np.median(kern_scaling):.3g}, max={np.max(kern_scaling):.3g}")
                 submask_lucky = new_kern_var <= kern_var[mask_done]
                 kern_val[mask_done] = np.where(submask_lucky, new_kern_val, kern_val[mask_done])
                 kern_var[mask_done] = np.where(submask_lucky, new_kern_var, kern_var[mask_done])
                 log(f"unlucky results: {np.count_nonzero(~submask_lucky)} out of {np.count_nonzero(mask_done)}")
+            if not coefficients.done():
+                log("waiting for the coefficients")
+            await coefficients
             amp_val = W @ kern_val
             amp_var = W_re_var_coef @ np.real(kern_var) + W_im_var_coef @ np.imag(kern_var)
             # Report results
@@ -792,6 +1642,11 @@ async def do_eval(prepared, coeffsdir, epsabs, epsrel, npresample, npoints0, nsh
             n = propose_lattices(amp_val, amp_var)
             if n is None:
                 return amp_val, amp_var
+            n = fit_lattices_to_deadline(n)
+            if n is None:
+                log("not enough time left for another round before the deadline; stopping")
+                early_exit = True
+                return amp_val, amp_var
             newgenvecs = [None] * len(kernel2idx)
             if standard_lattices:
                 for i in range(len(kernel2idx)):
@@ -801,9 +1656,12 @@ async def do_eval(prepared, coeffsdir, epsabs, epsrel, npresample, npoints0, nsh
             if not np.any(n != lattices):
                 log("can't increase the lattice sizes any more; giving up")
                 return amp_val, amp_var
-            for i, (l1, l2) in enumerate(zip(lattices, n)):
-                if l1 != l2:
-                    log(f"lattice[k{i}] = {l1:.0f} -> {l2:.0f} ({l2/l1:.1f}x)")
+            grown = (n != lattices).nonzero()[0]
+            if log_debug:
+                for i in grown:
+                    debug(f"lattice[k{i}] = {lattices[i]:.0f} -> {n[i]:.0f} ({n[i]/lattices[i]:.1f}x)")
+            growth = n[grown]/lattices[grown]
+            log(f"increasing the lattices of {len(grown)} kernels by {np.min(growth):.1f}x - {np.max(growth):.1f}x")
             oldlattices[:] = lattices
             lattices[:] = n
             genvecs[:] = newgenvecs
@@ -817,12 +1675,16 @@ async def do_eval(prepared, coeffsdir, epsabs, epsrel, npresample, npoints0, nsh
         log(f"trying to achieve epsrel={epsrel} and epsabs={epsabs} for each order of each amplitude")
         amp_val, amp_var = await iterate_integration(propose_lattices2)
 
+    if watcher is not None:
+        watcher.cancel()
+
     # Report the results
     t4 = time.time()
     log("integral load time:", t_init)
     log("worker startup time:", t_worker)
-    log("parameter substitution time:", t2-t1)
-    log("presampling time:", t3-t2)
+    log("parameter substitution time:", t3-t1)
+    log("presampling time:", t_presampled-t2)
+    log("coefficient time:", t_coefficients-t1)
     log("integration time:", t4-t3)
 
     log(f"per-integral statistics:")
@@ -888,20 +1750,151 @@ def default_worker_commands(dirname):
     return [["nice", sys.executable, "-m", "pySecDecContrib", "pysecdec_cpuworker"]] * ncpu + \
         [["nice", sys.executable, "-m", "pySecDecContrib", "pysecdec_cudaworker", "-d", str(i)] for i in range(ncuda)]
 
+def cluster_worker_commands(cluster_json):
+    """
+    Return the list of worker commands of the parsed cluster.json
+    file, one per worker.
+    """
+    assert "cluster" in cluster_json
+    assert isinstance(cluster_json["cluster"], list)
+    workers = []
+    for w in cluster_json["cluster"]:
+        if w.get("node", False):
+            workers.extend([{"command": w["command"], "node": True}] * w.get("count", 1))
+        else:
+            workers.extend([w["command"]] * w.get("count", 1))
+    return workers
+
 def load_worker_commands(jsonfile, dirname):
+    """
+    Return the list of worker commands, and whether the files
+    should be staged to the workers.
+    """
     try:
         with open(jsonfile, "r") as f:
             cluster_json = json.load(f)
-            assert "cluster" in cluster_json
-            assert isinstance(cluster_json["cluster"], list)
+            workers = cluster_worker_commands(cluster_json)
             log(f"Using cluster configuration from {jsonfile!r}")
-            workers = []
-            for w in cluster_json["cluster"]:
-                workers.extend([w["command"]] * w.get("count", 1))
-            return workers
+            return workers, bool(cluster_json.get("stage", False))
     except FileNotFoundError:
         log(f"Can't find {jsonfile}; will run locally")
-    return default_worker_commands(dirname)
+    return default_worker_commands(dirname), False
+
+def worker_command(cmd):
+    # Node-level sub-coordinators are given as {"command": ..., "node": true}
+    return cmd["command"] if isinstance(cmd, dict) else cmd
+
+def worker_is_node(cmd):
+    return isinstance(cmd, dict) and bool(cmd.get("node", False))
+
+MEMBERSHIP_INTERVAL = 10 # seconds between the checks of the cluster file
+
+class Membership:
+    """
+    The workers of a run, by the command that started each. With
+    a cluster file, the file is checked for changes while the
+    integration goes on: workers are started for the commands that
+    were added to it (or whose count grew), and the workers of the
+    commands that were removed (or whose count shrank) leave the
+    run. A worker that exits on its own is only replaced once the
+    file changes again.
+    """
+
+    def __init__(self, start, clusterfile=None):
+        self.start = start # cmd -> coroutine giving a registered and benchmarked worker
+        self.clusterfile = clusterfile
+        self.mtime = None if clusterfile is None else os.stat(clusterfile).st_mtime_ns
+        self.members = [] # (key, worker)
+        self.starting = {} # key -> number of workers being started
+        self.joining = set() # the tasks starting workers
+        self.leaving = set() # the tasks stopping workers
+
+    @staticmethod
+    def key(cmd):
+        return json.dumps(cmd, sort_keys=True)
+
+    def add(self, cmd, w):
+        self.members.append((self.key(cmd), w))
+
+    def _reload(self):
+        """
+        Return the worker commands of the cluster file, or None if
+        it has not changed since it was last read.
+        """
+        try:
+            mtime = os.stat(self.clusterfile).st_mtime_ns
+            if mtime == self.mtime: return None
+            self.mtime = mtime
+            with open(self.clusterfile, "r") as f:
+                return cluster_worker_commands(json.load(f))
+        except FileNotFoundError:
+            return None
+        except (OSError, ValueError, KeyError, AssertionError) as e:
+            log(f"WARNING: can't reload {self.clusterfile!r}: {type(e).__name__}: {e}")
+            return None
+
+    def update(self, par, admit):
+        commands = self._reload()
+        if commands is None: return
+        self.members = [(k, w) for k, w in self.members if w in par.workers]
+        wanted = {}
+        for cmd in commands:
+            wanted.setdefault(self.key(cmd), [cmd, 0])[1] += 1
+        have = dict(self.starting)
+        for k, w in self.members:
+            have[k] = have.get(k, 0) + 1
+        nleave = 0
+        for k, n in have.items():
+            excess = n - wanted.get(k, (None, 0))[1]
+            for i in reversed(range(len(self.members))):
+                if excess <= 0: break
+                if self.members[i][0] != k: continue
+                self._spawn(self.leaving, par.retire(self.members.pop(i)[1]))
+                excess -= 1
+                nleave += 1
+        njoin = 0
+        for k, (cmd, n) in wanted.items():
+            for i in range(n - have.get(k, 0)):
+                self._spawn(self.joining, self._join(k, cmd, par, admit))
+                njoin += 1
+        log(f"{self.clusterfile!r} changed: starting {njoin} workers, stopping {nleave}")
+
+    def _spawn(self, tasks, coro):
+        task = asyncio.ensure_future(coro)
+        tasks.add(task)
+        task.add_done_callback(tasks.discard)
+
+    async def _join(self, key, cmd, par, admit):
+        self.starting[key] = self.starting.get(key, 0) + 1
+        w = None
+        try:
+            w = await self.start(cmd)
+            await admit(w)
+        except Exception as e:
+            log(f"WARNING: failed to add a worker: {type(e).__name__}: {e}")
+            if w is not None: w.process.stdin.close()
+            return
+        finally:
+            self.starting[key] -= 1
+        self.members.append((key, w))
+        par.add_worker(w)
+        log(f"worker {w.name} joined the run: int speed={w.speed:.2e}bps, total overhead={w.overhead:.2e}s, latency={w.latency:.2e}s")
+
+    async def watch(self, par, admit, interval=MEMBERSHIP_INTERVAL):
+        """
+        Follow the changes of the cluster file until cancelled;
+        `admit(w)` brings a started worker up to date with the
+        evaluation before it joins the scheduler `par`.
+        """
+        try:
+            while True:
+                await asyncio.sleep(interval)
+                self.update(par, admit)
+        finally:
+            # The workers still starting are abandoned; those that
+            # are leaving finish doing so.
+            for task in list(self.joining):
+                task.cancel()
 
 def split_integral_into_orders(orders, ampid, kernel2idx, info, br_coef, valmap, sp_regulators, requested_orders):
     br_pref = info["expanded_prefactor_value"]
@@ -992,6 +1985,7 @@ def result_to_json(result):
     return result
 
 def main():
+    global log_debug
 
     valuemap_coeff = {}
     valuemap_int = {}
@@ -1005,9 +1999,11 @@ def main():
     coeffsdir = None
     lattice_candidates = 0
     standard_lattices = False
+    stage = False
     deadline = math.inf
+    cost_model = None
     try:
-        opts, args = getopt.gnu_getopt(sys.argv[1:], "", ["cluster=", "coefficients=", "epsabs=", "epsrel=", "format=", "points=", "presamples=", "shifts=", "lattice-candidates=", "standard-lattices=", "timeout=", "help"])
+        opts, args = getopt.gnu_getopt(sys.argv[1:], "", ["cluster=", "coefficients=", "epsabs=", "epsrel=", "format=", "points=", "presamples=", "shifts=", "lattice-candidates=", "standard-lattices=", "cost-model=", "stage", "debug", "timeout=", "help"])
     except getopt.GetoptError as e:
         print(e, file=sys.stderr)
         print("use --help to see the usage", file=sys.stderr)
@@ -1024,6 +2020,9 @@ def main():
         elif key == "--timeout": deadline = time.time() + parse_unit(value, {"s": 1, "m": 60, "h": 60*60, "d": 24*60*60})
         elif key == "--lattice-candidates": lattice_candidates = int(float(value))
         elif key == "--standard-lattices": standard_lattices = value.lower() == "yes"
+        elif key == "--cost-model": cost_model = value
+        elif key == "--stage": stage = True
+        elif key == "--debug": log_debug = True
         elif key == "--help":
             print(__doc__.strip())
             exit(0)
@@ -1065,14 +2064,16 @@ def main():
         log(f"- {key} = {value}")
 
     # Load worker list
-    workers = load_worker_commands(clusterfile, dirname)
+    workers, cluster_stage = load_worker_commands(clusterfile, dirname)
+    stage = stage or cluster_stage
     if len(workers) == 0:
         log("No workers defined")
         exit(1)
 
     # Begin evaluation
     loop = asyncio.get_event_loop()
-    prepared = loop.run_until_complete(prepare_eval(workers, dirname, intfile))
+    prepared = loop.run_until_complete(prepare_eval(workers, dirname, intfile, stage=stage, cost_model=cost_model,
+        clusterfile=clusterfile if os.path.exists(clusterfile) else None))
     result = loop.run_until_complete(do_eval(prepared, coeffsdir, epsabs, epsrel, npresamples, npoints, nshifts, lattice_candidates, standard_lattices, valuemap_int, valuemap_coeff, deadline))
 
     # Report the result
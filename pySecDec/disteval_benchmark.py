@@ -8,6 +8,8 @@ Usage:
 Options:
     --points=X          evaluate using this many points per batch (default: 1e5)
     --repetitions=X     repeat the measurement this many times (default: 10)
+    --fit-cost-model=X  fit the kernel cost model of pySecDec.disteval to the
+                        measured rates, and save it into this json file
     --help              show this help message
 Arguments:
     <var>=X             set this integral or coefficient variable to a given value
@@ -26,6 +28,7 @@ import sympy as sp
 import sys
 import time
 
+from .disteval import DEFAULT_COST_MODEL
 from .generating_vectors import generating_vector, max_lattice_size
 
 from pySecDecContrib import dirname as contrib_dirname
@@ -156,9 +159,51 @@ async def launch_worker(command, dirname, maxtimeout=10):
         timeout = min(timeout*2, maxtimeout)
 
 
+# Cost model
+
+def fit_cost_model(metrics, tau):
+    """
+    Fit the coefficients of the disteval kernel cost model (see
+    `pySecDec.disteval.DEFAULT_COST_MODEL`) to the measured times
+    per point `tau`, in units of the gauge kernel, of the kernels
+    with the given static metrics. The relative error is
+    minimized, and the coefficients are kept non-negative by
+    dropping the terms that come out negative and refitting.
+    """
+    keys = list(DEFAULT_COST_MODEL.keys())
+    A = np.array([[1.0 if key == "point" else m.get(key, 0) for key in keys] for m in metrics], dtype=np.float64)
+    tau = np.asarray(tau, dtype=np.float64)
+    A = A/tau[:,None]
+    b = np.ones(len(tau))
+    active = np.any(A != 0, axis=0)
+    coeffs = np.zeros(len(keys))
+    while np.any(active):
+        coeffs[:] = 0
+        coeffs[active] = np.linalg.lstsq(A[:,active], b, rcond=None)[0]
+        if np.all(coeffs >= 0): break
+        active &= coeffs > 0
+    return {key : float(c) for key, c in zip(keys, coeffs)}
+
 # Main
 
-async def dobenchmark(workercmd, datadir, intfile, valuemap, npoints, nreps):
+async def measure_rate(w, keridx, dim, npoints, nreps):
+    lattice, genvec = generating_vector(dim, npoints)
+    shift = [random.random() for i in range(dim)]
+    deformp = [1e-10 for i in range(dim)]
+    dn = np.zeros(nreps)
+    dt = np.zeros(nreps)
+    for i in range(nreps):
+        (re, im), dn[i], dt[i] = (await w.call("integrate", keridx, lattice, 0, lattice, genvec, shift, deformp))[:3]
+        if math.isnan(re) or math.isnan(im):
+            log(f"- got ({re},{im}) at {lattice:.3e} points")
+    rate = float(np.mean(dn/dt))
+    rateerr = float(np.std(dn/dt))/math.sqrt(nreps)
+    tm = float(np.mean(dt))
+    tmerr = float(np.std(dt))/math.sqrt(nreps)
+    log(f"- {rate:.3e} ± {rateerr:.1e} evals/s at {lattice:.3e} points in {tm:.3e} ± {tmerr:.1e}s")
+    return rate, rateerr
+
+async def dobenchmark(workercmd, datadir, intfile, valuemap, npoints, nreps, costmodelfile=None):
     # Load the integrals from the requested json file
     with open(intfile, "r") as f:
         info = json.load(f)
@@ -221,20 +266,7 @@ async def dobenchmark(workercmd, datadir, intfile, valuemap, npoints, nreps):
     for (fam, ker), keridx in kernel2idx.items():
         dim = infos[fam]["dimension"]
         log(f"{fam}.{ker} (dim={dim}):")
-        lattice, genvec = generating_vector(dim, npoints)
-        shift = [random.random() for i in range(dim)]
-        deformp = [1e-10 for i in range(dim)]
-        dn = np.zeros(nreps)
-        dt = np.zeros(nreps)
-        for i in range(nreps):
-            (re, im), dn[i], dt[i] = await w.call("integrate", keridx+1, lattice, 0, lattice, genvec, shift, deformp)
-            if math.isnan(re) or math.isnan(im):
-                log(f"- got ({re},{im}) at {lattice:.3e} points")
-        rate = float(np.mean(dn/dt))
-        rateerr = float(np.std(dn/dt))/math.sqrt(nreps)
-        tm = float(np.mean(dt))
-        tmerr = float(np.std(dt))/math.sqrt(nreps)
-        log(f"- {rate:.3e} ± {rateerr:.1e} evals/s at {lattice:.3e} points in {tm:.3e} ± {tmerr:.1e}s")
+        rate, rateerr = await measure_rate(w, keridx+1, dim, npoints, nreps)
         results.append((fam, ker, rate, rateerr))
 
     # Print the final statistics
@@ -242,13 +274,37 @@ async def dobenchmark(workercmd, datadir, intfile, valuemap, npoints, nreps):
     for result in results:
         print(",".join(map(str, result)))
 
+    # Fit the cost model to the kernels with known static metrics
+    if costmodelfile is not None:
+        log(f"builtin.gauge (dim=2):")
+        gauge_rate, _ = await measure_rate(w, 0, 2, npoints, nreps)
+        costs = {}
+        for fam in infos.keys():
+            costfile = os.path.join(datadir, f"{fam}.costs.json")
+            if os.path.exists(costfile):
+                with open(costfile, "r") as f:
+                    costs.update({(fam, ker) : m for ker, m in json.load(f)["kernels"].items()})
+            else:
+                log(f"no static metrics for {fam}, skipping its kernels")
+        metrics = [costs[fam, ker] for fam, ker, rate, rateerr in results if (fam, ker) in costs]
+        tau = [gauge_rate/rate for fam, ker, rate, rateerr in results if (fam, ker) in costs]
+        if len(metrics) == 0:
+            raise ValueError("no kernels with static metrics to fit the cost model to")
+        model = fit_cost_model(metrics, tau)
+        log(f"cost model fitted to {len(metrics)} kernels:")
+        for key, c in model.items():
+            log(f"- {key} = {c:.3e}")
+        with open(costmodelfile, "w") as f:
+            json.dump(model, f, indent=1)
+
 def main():
 
     valuemap = {}
     npoints = 10**5
     nreps = 10
+    costmodelfile = None
     try:
-        opts, args = getopt.gnu_getopt(sys.argv[1:], "", ["points=", "repetitions=", "help"])
+        opts, args = getopt.gnu_getopt(sys.argv[1:], "", ["points=", "repetitions=", "fit-cost-model=", "help"])
     except getopt.GetoptError as e:
         print(e, file=sys.stderr)
         print("use --help to see the usage", file=sys.stderr)
@@ -258,6 +314,8 @@ def main():
             npoints = int(float(value))
         elif key == "--repetitions":
             nreps = int(float(value))
+        elif key == "--fit-cost-model":
+            costmodelfile = value
         elif key == "--help":
             print(__doc__.strip())
             exit(0)
@@ -300,7 +358,7 @@ def main():
 
     # Run the benchmark
     loop = asyncio.get_event_loop()
-    result = loop.run_until_complete(dobenchmark(worker, dirname, intfile, valuemap, npoints, nreps))
+    result = loop.run_until_complete(dobenchmark(worker, dirname, intfile, valuemap, npoints, nreps, costmodelfile))
 
 if __name__ == "__main__":
     main()
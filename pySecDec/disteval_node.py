@@ -0,0 +1,248 @@
+#!/usr/bin/env python3
+"""
+Node-level sub-coordinator for disteval: start the workers of one
+node, and serve them to the central coordinator over a single
+connection, so that the coordinator handles one connection per
+node instead of one per worker.
+Usage:
+    python3 -m pySecDec.disteval_node [options] [worker command ...]
+Options:
+    --workers=X     start this many local workers (default: one per
+                    CPU core but one, or one per GPU)
+    --help          show this help message
+Arguments:
+    worker command  start the local workers with this command
+                    (default: pysecdec_cpuworker or pysecdec_cudaworker)
+
+To use it, list the command in the cluster.json file of the
+coordinator with "node": true, e.g.
+    {"cluster": [{"command": "ssh node1 python3 -m pySecDec.disteval_node", "node": true}]}
+
+The sub-coordinator speaks the same protocol as the workers.
+Integration jobs are sent to the least busy local worker; the
+configuration commands ("family", "kernel", "changefamily",
+"link") are sent to all of them. In addition it implements
+    ["workers", []] -> the number of local workers
+    ["integrate_shifts", [kernel, lattice, i1, i2, genvec, [shift, ...], deformp]]
+        -> [[[re, im], ...], di, dt]
+which integrates a kernel with several shifts at once, and replies
+with the sum of each shift, and the total number of evaluations
+and integration time. If one of the shifts gives NaN, the others
+are cancelled and their sums are reported as NaN too, and the
+location of the failing point given by the worker, if any, is
+appended to the reply.
+"""
+
+import asyncio
+import getopt
+import json
+import os
+import socket
+import subprocess
+import sys
+
+from .disteval import Worker, WorkerException, WORKER_EXITED, log, default_worker_commands
+
+def encode_reply(data):
+    return b"@" + json.dumps(data, separators=(',',':')).encode("ascii") + b"\n"
+
+class Node:
+
+    def __init__(self, commands, output):
+        self.commands = commands
+        self.output = output
+        self.workers = []
+        self.staged = False
+        self.name = f"{socket.gethostname()}:{os.getpid()}"
+        self.pending = {} # token -> [(worker, token), ...] of the local calls
+        self.started = False
+        self.input = None
+
+    def reply(self, token, result, error=None):
+        if token in self.pending:
+            del self.pending[token]
+            self.output.write(encode_reply((token, result, error)))
+            self.output.flush()
+
+    async def start_workers(self, dirname):
+        if self.started: return
+        self.started = True
+        commands = self.commands(dirname)
+        for command in commands:
+            log(f"running: {command}")
+            if isinstance(command, str):
+                p = await asyncio.create_subprocess_shell(command, stdin=subprocess.PIPE, stdout=subprocess.PIPE)
+            else:
+                p = await asyncio.create_subprocess_exec(*command, stdin=subprocess.PIPE, stdout=subprocess.PIPE)
+            w = Worker(p, name=f"{self.name}/{len(self.workers)}")
+            w.on_exit = self.worker_exited
+            self.workers.append(w)
+
+    def worker_exited(self, w):
+        """
+        Fail the calls that a local worker did not reply to before
+        it exited; the coordinator runs their jobs again. A node
+        without workers stops, so that the coordinator moves its
+        jobs to the other workers.
+        """
+        log(f"{w.name} exited")
+        if w in self.workers:
+            self.workers.remove(w)
+        for t, (callback, callback_args) in list(w.callbacks.items()):
+            del w.callbacks[t]
+            callback(None, WORKER_EXITED, w, *callback_args)
+        if len(self.workers) == 0 and self.input is not None:
+            self.input.feed_eof()
+
+    def choose(self):
+        return min(self.workers, key=lambda w: w.queue_size())
+
+    async def broadcast(self, method, args, args_of=None):
+        """
+        Send the call to all local workers, return their results.
+        """
+        return await asyncio.gather(*[
+            w.call(method, *(args if args_of is None else args_of(w)))
+            for w in self.workers
+        ])
+
+    def forward(self, token, method, args, w=None):
+        w = self.choose() if w is None else w
+        def forward_cb(result, error, w):
+            self.reply(token, result, error)
+        self.pending[token] = [(w, w.call_cb(method, args, forward_cb))]
+
+    def integrate_shifts(self, token, args):
+        kernel, lattice, i1, i2, genvec, shifts, deformp = args
+        values = [None]*len(shifts)
+        total = [0, 0.0]
+        where = []
+        def shift_cb(result, error, w, s):
+            # Sign check errors come with a NaN result, which is
+            # passed on; other errors fail the whole call.
+            if result is None:
+                self.cancel(token, error)
+                return
+            (re, im), di, dt = result[:3]
+            values[s] = (re, im)
+            total[0] += di
+            total[1] += dt
+            if re != re or im != im:
+                self.cancel(token, None)
+                where.extend(result[3:])
+                for i in range(len(values)):
+                    if values[i] is None: values[i] = (re, im)
+            if all(v is not None for v in values):
+                self.reply(token, (values, total[0], total[1], *where))
+        calls = []
+        for s, shift in enumerate(shifts):
+            w = self.choose()
+            calls.append((w, w.call_cb("integrate", (kernel, lattice, i1, i2, genvec, shift, deformp), shift_cb, (s,))))
+        self.pending[token] = calls
+
+    def cancel(self, token, error="cancelled"):
+        """
+        Abandon the local calls of a pending command; reply with
+        the given error, unless it is None.
+        """
+        calls = self.pending.get(token, [])
+        for w, t in calls:
+            w.cancel_cb(t)
+        if error is not None:
+            self.reply(token, None, error)
+
+    async def handle(self, token, method, args):
+        try:
+            if method == "ping":
+                self.reply(token, None)
+            elif method == "workers":
+                self.reply(token, len(self.workers))
+            elif method == "start":
+                await self.start_workers(args[0])
+                if self.staged:
+                    # Each worker has its own run directory.
+                    await self.broadcast("start", args, lambda w: (w.rundir,))
+                else:
+                    await self.broadcast("start", args)
+                self.reply(token, self.name)
+            elif method == "rundir":
+                await self.start_workers(".")
+                results = await self.broadcast("rundir", ())
+                for w, (name, kind, rundir, cachedir) in zip(self.workers, results):
+                    w.rundir = rundir
+                self.staged = True
+                name, kind, rundir, cachedir = results[0]
+                self.reply(token, (self.name, kind, rundir, cachedir))
+            elif method in ("family", "kernel", "changefamily", "link"):
+                # Each worker links the files into its own run directory.
+                results = await self.broadcast(method, args)
+                self.reply(token, results[0])
+            elif method in ("have", "upload"):
+                # The cache is shared by the workers of the node, and
+                # the chunks of a file must all go to the same worker.
+                self.forward(token, method, args, self.workers[0])
+            elif method == "integrate_shifts":
+                self.integrate_shifts(token, args)
+            else:
+                self.forward(token, method, args)
+        except WorkerException as e:
+            self.reply(token, None, str(e))
+        except Exception as e:
+            self.reply(token, None, f"{type(e).__name__}: {e}")
+
+    async def serve(self, input):
+        self.input = input
+        while True:
+            line = await input.readline()
+            if len(line) == 0: break
+            token, method, args = json.loads(line)
+            if method == "cancel":
+                self.cancel(args[0])
+                continue
+            self.pending[token] = []
+            # Jobs are only passed on here, but the configuration
+            # commands are completed before the next line is read,
+            # so that all workers see them in the same order.
+            await self.handle(token, method, args)
+        for w in self.workers:
+            w.process.stdin.close()
+        await asyncio.gather(*[w.process.wait() for w in self.workers])
+
+async def run_node(commands):
+    loop = asyncio.get_event_loop()
+    input = asyncio.StreamReader(limit=2**30)
+    await loop.connect_read_pipe(lambda: asyncio.StreamReaderProtocol(input), sys.stdin)
+    await Node(commands, sys.stdout.buffer).serve(input)
+
+def main():
+    count = None
+    try:
+        opts, args = getopt.getopt(sys.argv[1:], "", ["workers=", "help"])
+    except getopt.GetoptError as e:
+        print(e, file=sys.stderr)
+        print("use --help to see the usage", file=sys.stderr)
+        exit(1)
+    for key, value in opts:
+        if key == "--workers": count = int(value)
+        elif key == "--help":
+            print(__doc__.strip())
+            exit(0)
+    def commands(dirname):
+        if len(args) > 0:
+            if count is None:
+                return [args] * default_worker_count()
+            return [args] * count
+        commands = default_worker_commands(dirname)
+        if count is not None:
+            commands = (commands * count)[:count]
+        return commands
+    asyncio.get_event_loop().run_until_complete(run_node(commands))
+
+def default_worker_count():
+    try:
+        return max(1, len(os.sched_getaffinity(0)) - 1)
+    except AttributeError:
+        return max(1, os.cpu_count() - 1)
+
+if __name__ == "__main__":
+    main()
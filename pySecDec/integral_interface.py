@@ -14,6 +14,7 @@ try:
     from Queue import Queue
 except ImportError:
     from queue import Queue
+import numbers
 import os
 import os.path
 from .misc import version
@@ -320,6 +321,8 @@ def series_to_json(series, name="sum"):
 # assuming
 # enum qmc_transform_t : int
 # {
+#     auto_transform = 0,
+#
 #     no_transform = -1,
 #
 #     baker = -2,
@@ -339,6 +342,8 @@ def series_to_json(series, name="sum"):
 #     sidi6 = -16
 # };
 known_qmc_transforms = dict(
+    auto = 0,
+
     none = -1,
 
     baker = -2,
@@ -395,6 +400,22 @@ known_qmc_generatingvectors = dict(
     none = 5
 )
 
+def _describe_integrator(name, *args):
+    '''
+    Describe an integrator for the workers of an
+    :class:`IntegralLibrary` by the name of its
+    "allocate_" function in the c++ library and the
+    arguments passed to it.
+
+    '''
+    def describe(arg):
+        if isinstance(arg, CPPIntegrator):
+            return arg._description
+        if isinstance(arg, numbers.Integral):
+            return str(int(arg))
+        return repr(float(arg))
+    return ' '.join([name] + [describe(arg) for arg in args])
+
 class CPPIntegrator(object):
     '''
     Abstract base class for integrators to be used with
@@ -465,6 +486,7 @@ class MultiIntegrator(CPPIntegrator):
         self.c_lib.allocate_MultiIntegrator.restype = c_void_p
         self.c_lib.allocate_MultiIntegrator.argtypes = [c_void_p, c_void_p, c_int]
         self.c_integrator_ptr = self.c_lib.allocate_MultiIntegrator(low_dim_integrator.c_integrator_ptr,high_dim_integrator.c_integrator_ptr,critical_dim)
+        self._description = _describe_integrator('MultiIntegrator',critical_dim,low_dim_integrator,high_dim_integrator)
 
 class CQuad(CPPIntegrator):
     '''
@@ -485,6 +507,7 @@ class CQuad(CPPIntegrator):
         self.c_lib.allocate_gsl_cquad.restype = c_void_p
         self.c_lib.allocate_gsl_cquad.argtypes = [c_double, c_double, c_uint, c_bool, c_double]
         self.c_integrator_ptr = self.c_lib.allocate_gsl_cquad(epsrel,epsabs,n,verbose,zero_border)
+        self._description = _describe_integrator('gsl_cquad',epsrel,epsabs,n,verbose,zero_border)
         self._epsrel=epsrel
         self._epsabs=epsabs
 
@@ -507,6 +530,7 @@ class Vegas(CPPIntegrator):
         self.c_lib.allocate_cuba_Vegas.restype = c_void_p
         self.c_lib.allocate_cuba_Vegas.argtypes = [c_double, c_double, c_int, c_int, c_longlong, c_longlong, c_double, c_longlong, c_longlong, c_longlong, c_bool]
         self.c_integrator_ptr = self.c_lib.allocate_cuba_Vegas(epsrel,epsabs,flags,seed,mineval,maxeval,zero_border,nstart,nincrease,nbatch,real_complex_together)
+        self._description = _describe_integrator('cuba_Vegas',epsrel,epsabs,flags,seed,mineval,maxeval,zero_border,nstart,nincrease,nbatch,real_complex_together)
         self._epsrel=epsrel
         self._epsabs=epsabs
         self._mineval=mineval
@@ -531,6 +555,7 @@ class Suave(CPPIntegrator):
         self.c_lib.allocate_cuba_Suave.restype = c_void_p
         self.c_lib.allocate_cuba_Suave.argtypes = [c_double, c_double, c_int, c_int, c_longlong, c_longlong, c_double, c_longlong, c_longlong, c_double, c_bool]
         self.c_integrator_ptr = self.c_lib.allocate_cuba_Suave(epsrel,epsabs,flags,seed,mineval,maxeval,zero_border,nnew,nmin,flatness,real_complex_together)
+        self._description = _describe_integrator('cuba_Suave',epsrel,epsabs,flags,seed,mineval,maxeval,zero_border,nnew,nmin,flatness,real_complex_together)
         self._epsrel=epsrel
         self._epsabs=epsabs
         self._mineval=mineval
@@ -561,6 +586,9 @@ class Divonne(CPPIntegrator):
         self.c_integrator_ptr = self.c_lib.allocate_cuba_Divonne(epsrel, epsabs, flags, seed, mineval,maxeval,
                                                                  zero_border, key1, key2, key3, maxpass, border,
                                                                  maxchisq, mindeviation, real_complex_together)
+        self._description = _describe_integrator('cuba_Divonne', epsrel, epsabs, flags, seed, mineval, maxeval,
+                                                 zero_border, key1, key2, key3, maxpass, border,
+                                                 maxchisq, mindeviation, real_complex_together)
         self._epsrel=epsrel
         self._epsabs=epsabs
         self._mineval=mineval
@@ -585,6 +613,7 @@ class Cuhre(CPPIntegrator):
         self.c_lib.allocate_cuba_Cuhre.restype = c_void_p
         self.c_lib.allocate_cuba_Cuhre.argtypes = [c_double, c_double, c_int, c_longlong, c_longlong, c_double, c_int, c_bool]
         self.c_integrator_ptr = self.c_lib.allocate_cuba_Cuhre(epsrel,epsabs,flags,mineval,maxeval,zero_border,key,real_complex_together)
+        self._description = _describe_integrator('cuba_Cuhre',epsrel,epsabs,flags,mineval,maxeval,zero_border,key,real_complex_together)
         self._epsrel=epsrel
         self._epsabs=epsabs
         self._mineval=mineval
@@ -617,6 +646,11 @@ class Qmc(CPPIntegrator):
         ``"korobov#"``, and ``korobov#x#`` where
         any ``#`` (the rank of the Korobov/Sidi transform)
         must be an integer between 1 and 6.
+        With ``"auto"``, each integral is integrated on
+        the first lattice with every transform in
+        `pylink_qmc_transforms` of the generate script,
+        and refined with the transform with the smallest
+        error times integration time.
 
     :param fitfunction:
         string;
@@ -657,6 +691,31 @@ class Qmc(CPPIntegrator):
         median Qmc rule should be kept for other integrals
         Default: ``"False"``
 
+    :param subdivision_depth:
+        int; experimental
+        Maximal number of nested splits of the integration
+        domain. If a first iteration misses the requested
+        accuracy, the domain of an integrand may be split in
+        two along the variable that dominates its variance,
+        provided that a pilot lattice predicts this to be
+        cheaper. The pieces are integrated separately and the
+        results are added.
+        ``0`` disables the subdivision.
+        Default: ``0``
+
+    :param subdivision_minn:
+        int; experimental
+        Number of points of the pilot lattice used to decide
+        on a split.
+        ``0`` takes the default ``8191``.
+
+    :param subdivision_threshold:
+        float; experimental
+        Split only if the predicted cost of the pieces drops
+        below this fraction of the predicted cost of the whole
+        domain.
+        ``0`` takes the default ``0.8``.
+
 
     :param cputhreads:
         int;
@@ -683,7 +742,8 @@ class Qmc(CPPIntegrator):
 
     '''
     def __init__(self,integral_library,transform='korobov3',fitfunction='default',generatingvectors='default',epsrel=1e-2,epsabs=1e-7,maxeval=4611686018427387903,errormode='default',evaluateminn=0,
-                      minn=10000,minm=0,maxnperpackage=0,maxmperpackage=0,cputhreads=None,cudablocks=0,cudathreadsperblock=0,verbosity=0,seed=0,devices=[],lattice_candidates=0,standard_lattices=False,keep_lattices=False):
+                      minn=10000,minm=0,maxnperpackage=0,maxmperpackage=0,cputhreads=None,cudablocks=0,cudathreadsperblock=0,verbosity=0,seed=0,devices=[],lattice_candidates=0,standard_lattices=False,keep_lattices=False,
+                      subdivision_depth=0,subdivision_minn=0,subdivision_threshold=0):
         if cputhreads is None:
             try:
                 cputhreads = len(os.sched_getaffinity(0))
@@ -712,7 +772,10 @@ class Qmc(CPPIntegrator):
                                                             c_int, # generatingvectors_id
                                                             c_ulonglong, # lattice_candidates
                                                             c_bool, # standard_lattices
-                                                            c_bool # keep_lattices
+                                                            c_bool, # keep_lattices
+                                                            c_ulonglong, # subdivision_depth
+                                                            c_ulonglong, # subdivision_minn
+                                                            c_double # subdivision_threshold
                                                       ]
 
         # assuming:
@@ -736,8 +799,90 @@ class Qmc(CPPIntegrator):
                                                                     seed,known_qmc_transforms[str(transform).lower()],
                                                                     known_qmc_fitfunctions[str(fitfunction).lower()],
                                                                     known_qmc_generatingvectors[str(generatingvectors).lower()],
-                                                                    lattice_candidates,standard_lattices,keep_lattices
+                                                                    lattice_candidates,standard_lattices,keep_lattices,
+                                                                    subdivision_depth,subdivision_minn,subdivision_threshold
                                                                    )
+        self._description = _describe_integrator('integrators_Qmc',epsrel,epsabs,maxeval,errormode_enum,evaluateminn,minn,
+                                                 minm,maxnperpackage,maxmperpackage,cputhreads,
+                                                 cudablocks,cudathreadsperblock,verbosity,
+                                                 seed,known_qmc_transforms[str(transform).lower()],
+                                                 known_qmc_fitfunctions[str(fitfunction).lower()],
+                                                 known_qmc_generatingvectors[str(generatingvectors).lower()],
+                                                 lattice_candidates,standard_lattices,keep_lattices,
+                                                 subdivision_depth,subdivision_minn,subdivision_threshold)
+        self._epsrel=epsrel
+        self._epsabs=epsabs
+        self._mineval=minn
+        self._maxeval=maxeval
+
+class DigitalNet(CPPIntegrator):
+    '''
+    .. versionadded:: 1.6.4
+
+    Wrapper for the :cpp:class:`secdecutil::integrators::DigitalNet`,
+    a quasi-Monte Carlo integrator based on interlaced polynomial
+    lattice rules. These higher order digital nets converge like
+    ``n^-order`` for smooth integrands without an integral transform,
+    which makes them an alternative to the :class:`Qmc` for smooth
+    (e.g. finite, Euclidean) sectors.
+
+    :param integral_library:
+        :class:`IntegralLibrary`;
+        The integral to be computed with this integrator.
+
+    :param order:
+        int;
+        The interlacing factor, i.e. the order of convergence
+        the rule is constructed for. Values of ``2`` or ``3``
+        are recommended; ``1`` gives an ordinary polynomial
+        lattice rule.
+        ``0`` takes the default ``2``.
+
+    :param minn:
+        int;
+        The minimal number of points, rounded up to the next
+        power of two.
+
+    :param minm:
+        int;
+        The number of random digital shifts used to estimate
+        the error.
+        ``0`` takes the default ``32``.
+
+    :param cputhreads:
+        int;
+        The number of CPU threads that should be used to evaluate
+        the integrand function. The default is the number of
+        logical CPUs allocated to the current process.
+
+    The remaining options `epsrel`, `epsabs`, `maxeval`,
+    `verbosity`, and `seed` have the same meaning as for the
+    :class:`Qmc`. The options are described in more detail in
+    :numref:`chapter_cpp_digital_net`.
+
+    '''
+    def __init__(self,integral_library,epsrel=1e-2,epsabs=1e-7,maxeval=4611686018427387903,minn=8192,minm=0,order=0,cputhreads=None,verbosity=0,seed=0):
+        if cputhreads is None:
+            try:
+                cputhreads = len(os.sched_getaffinity(0))
+            except AttributeError:
+                cputhreads = os.cpu_count()
+        self.c_lib = integral_library.c_lib
+        self.c_lib_path = integral_library.c_lib_path
+        self.c_lib.allocate_integrators_DigitalNet.restype = c_void_p
+        self.c_lib.allocate_integrators_DigitalNet.argtypes = [
+                                                                   c_double, # epsrel
+                                                                   c_double, # epsabs
+                                                                   c_ulonglong, # maxeval
+                                                                   c_ulonglong, # minn
+                                                                   c_ulonglong, # minm
+                                                                   c_uint, # order
+                                                                   c_longlong, # cputhreads
+                                                                   c_ulonglong, # verbosity
+                                                                   c_longlong # seed
+                                                             ]
+        self.c_integrator_ptr = self.c_lib.allocate_integrators_DigitalNet(epsrel,epsabs,maxeval,minn,minm,order,cputhreads,verbosity,seed)
+        self._description = _describe_integrator('integrators_DigitalNet',epsrel,epsabs,maxeval,minn,minm,order,cputhreads,verbosity,seed)
         self._epsrel=epsrel
         self._epsabs=epsabs
         self._mineval=minn
@@ -770,6 +915,11 @@ class CudaQmc(object):
         ``"korobov#"``, and ``korobov#x#`` where
         any ``#`` (the rank of the Korobov/Sidi transform)
         must be an integer between 1 and 6.
+        With ``"auto"``, each integral is integrated on
+        the first lattice with every transform in
+        `pylink_qmc_transforms` of the generate script,
+        and refined with the transform with the smallest
+        error times integration time.
 
     :param fitfunction:
         string;
@@ -806,6 +956,31 @@ class CudaQmc(object):
         median Qmc rule should be kept for other integrals
         Default: ``"False"``
 
+    :param subdivision_depth:
+        int;
+        Maximal number of nested splits of the integration
+        domain. If a first iteration misses the requested
+        accuracy, the domain of an integrand may be split in
+        two along the variable that dominates its variance,
+        provided that a pilot lattice predicts this to be
+        cheaper. The pieces are integrated separately and the
+        results are added.
+        ``0`` disables the subdivision.
+        Default: ``0``
+
+    :param subdivision_minn:
+        int;
+        Number of points of the pilot lattice used to decide
+        on a split.
+        ``0`` takes the default ``8191``.
+
+    :param subdivision_threshold:
+        float;
+        Split only if the predicted cost of the pieces drops
+        below this fraction of the predicted cost of the whole
+        domain.
+        ``0`` takes the default ``0.8``.
+
     :param cputhreads:
         int;
         The number of CPU threads that should be used to evaluate
@@ -831,7 +1006,8 @@ class CudaQmc(object):
 
     '''
     def __init__(self,integral_library,transform='korobov3',fitfunction='default',generatingvectors='default',epsrel=1e-2,epsabs=1e-7,maxeval=4611686018427387903,errormode='default',evaluateminn=0,
-                      minn=10000,minm=0,maxnperpackage=0,maxmperpackage=0,cputhreads=None,cudablocks=0,cudathreadsperblock=0,verbosity=0,seed=0,devices=[],lattice_candidates=0,standard_lattices=False,keep_lattices=False):
+                      minn=10000,minm=0,maxnperpackage=0,maxmperpackage=0,cputhreads=None,cudablocks=0,cudathreadsperblock=0,verbosity=0,seed=0,devices=[],lattice_candidates=0,standard_lattices=False,keep_lattices=False,
+                      subdivision_depth=0,subdivision_minn=0,subdivision_threshold=0):
         devices_t = c_int * len(devices)
         if cputhreads is None:
             try:
@@ -859,6 +1035,9 @@ class CudaQmc(object):
                         c_ulonglong, # lattice_candidates
                         c_bool, # standard_lattices
                         c_bool, # keep_lattices
+                        c_ulonglong, # subdivision_depth
+                        c_ulonglong, # subdivision_minn
+                        c_double, # subdivision_threshold
                         c_ulonglong, # number_of_devices
                         devices_t # devices[]
                    ]
@@ -890,6 +1069,7 @@ class CudaQmc(object):
                                                                                                known_qmc_fitfunctions[str(fitfunction).lower()],
                                                                                                known_qmc_generatingvectors[str(generatingvectors).lower()],
                                                                                                lattice_candidates,standard_lattices,keep_lattices,
+                                                                                               subdivision_depth,subdivision_minn,subdivision_threshold,
                                                                                                len(devices),devices_t(*devices)
                                                                                           )
         self.c_integrator_ptr_separate = self.c_lib.allocate_cuda_integrators_Qmc_separate(
@@ -900,6 +1080,7 @@ class CudaQmc(object):
                                                                                                known_qmc_fitfunctions[str(fitfunction).lower()],
                                                                                                known_qmc_generatingvectors[str(generatingvectors).lower()],
                                                                                                lattice_candidates,standard_lattices,keep_lattices,
+                                                                                               subdivision_depth,subdivision_minn,subdivision_threshold,
                                                                                                len(devices),devices_t(*devices)
                                                                                           )
         self._epsrel=epsrel
@@ -1117,6 +1298,26 @@ class IntegralLibrary(object):
         is ignored if compiled without cuda.
         Default: ``0 (never)``.
 
+    :param workers:
+        list of str, optional;
+        Shell commands that each start a worker built by
+
+        .. code::
+
+            $ make worker
+
+        in the root directory of the c++ library, e.g.
+        ``["./box1L/worker_box1L"] * 4`` or
+        ``["ssh node /path/to/box1L/worker_box1L"]``.
+        If given, the integrals are computed by the
+        workers instead of ``number_of_threads`` local
+        threads. The workers rebuild the amplitudes from
+        the parameters and the integrator of this call,
+        and read the library data from the same
+        (relative) path. Cannot be used with
+        :class:`.CudaQmc`.
+        Default: ``[]``.
+
     :param verbose:
         bool, optional;
         Controls the verbosity of the output of the amplitude.
@@ -1154,11 +1355,12 @@ class IntegralLibrary(object):
     The integrator can be configured by calling the
     member methods :meth:`.use_Vegas`, :meth:`.use_Suave`,
     :meth:`.use_Divonne`, :meth:`.use_Cuhre`,
-    :meth:`.use_CQuad`, and :meth:`.use_Qmc`.
+    :meth:`.use_CQuad`, :meth:`.use_Qmc`, and :meth:`.use_DigitalNet`.
     The available options are listed in the documentation of
     :class:`.Vegas`, :class:`.Suave`, :class:`.Divonne`,
     :class:`.Cuhre`, :class:`.CQuad`, :class:`.Qmc`
-    (:class:`.CudaQmc` for GPU version), respectively.
+    (:class:`.CudaQmc` for GPU version), and :class:`.DigitalNet`,
+    respectively.
     :class:`CQuad` can only be used for one dimensional
     integrals. A call to :meth:`use_CQuad` configures the
     integrator to use :class:`CQuad` if possible (1D) and the
@@ -1243,7 +1445,9 @@ class IntegralLibrary(object):
                                                c_size_t, # reset_cuda_after
                                                c_bool, # verbose
                                                c_int, # errormode
-                                               c_char_p  # lib_path
+                                               c_char_p, # lib_path
+                                               c_char_p, # workers
+                                               c_char_p  # integrator_description
         ]
 
         # set cuda integrate types if applicable
@@ -1291,7 +1495,7 @@ class IntegralLibrary(object):
                      mineval=None, maxincreasefac=20., min_epsrel=0.2, min_epsabs=1.e-4,
                      max_epsrel=1.e-14, max_epsabs=1.e-20, min_decrease_factor=0.9,
                      decrease_to_percentage=0.7, wall_clock_limit=1.7976931348623158e+308, # 1.7976931348623158e+308 max double
-                     number_of_threads=0, reset_cuda_after=0, verbose=False, errormode='abs', format="series"
+                     number_of_threads=0, reset_cuda_after=0, workers=[], verbose=False, errormode='abs', format="series"
                 ):
         # Set the default integrator
         if getattr(self, "integrator", None) is None:
@@ -1316,6 +1520,9 @@ class IntegralLibrary(object):
         else:
             raise ValueError('Unknown `errormode` "' + str(errormode) + '"')
 
+        if workers and self._cuda:
+            raise RuntimeError('Cannot use `workers` together with `CudaQmc`.')
+
         if verbose:
             print(version)
 
@@ -1338,7 +1545,7 @@ class IntegralLibrary(object):
                                                   mineval, maxincreasefac, min_epsrel, min_epsabs,
                                                   max_epsrel, max_epsabs, min_decrease_factor,
                                                   decrease_to_percentage, wall_clock_limit,
-                                                  number_of_threads, reset_cuda_after, verbose, errormode_enum
+                                                  number_of_threads, reset_cuda_after, workers, verbose, errormode_enum
                                               )
                                      )
         integration_thread.daemon = True # daemonize worker to have it killed when the main thread is killed
@@ -1376,7 +1583,7 @@ class IntegralLibrary(object):
                                 mineval, maxincreasefac, min_epsrel, min_epsabs,
                                 max_epsrel, max_epsabs, min_decrease_factor,
                                 decrease_to_percentage, wall_clock_limit,
-                                number_of_threads, reset_cuda_after, verbose, errormode_enum
+                                number_of_threads, reset_cuda_after, workers, verbose, errormode_enum
                             ):
         # Passed in correct number of parameters?
         assert len(real_parameters) == int(self.info['number_of_real_parameters']), \
@@ -1432,7 +1639,9 @@ class IntegralLibrary(object):
                                             max_epsrel, max_epsabs, min_decrease_factor,
                                             decrease_to_percentage, wall_clock_limit,
                                             number_of_threads, reset_cuda_after, verbose,errormode_enum,
-                                            self.c_lib_path.encode("utf-8")
+                                            self.c_lib_path.encode("utf-8"),
+                                            "\n".join(workers).encode("utf-8"),
+                                            self.integrator._description.encode("utf-8")
                                     )
         return_value_queue.put(compute_integral_return_value)
         if compute_integral_return_value != 0:
@@ -1490,6 +1699,11 @@ class IntegralLibrary(object):
             self._cuda = True
             self.high_dimensional_integrator = self.integrator = CudaQmc(self,*args,**kwargs)
 
+    def use_DigitalNet(self, *args, **kwargs):
+        if self._cuda:
+            raise RuntimeError('Cannot use `DigitalNet` together with `CudaQmc`.')
+        self.high_dimensional_integrator = self.integrator = DigitalNet(self,*args,**kwargs)
+
 def _runlength_encode(values):
     result = []
     prev_val = None
@@ -1533,13 +1747,23 @@ class DistevalLibrary(object):
         Default: one ``"nice python3 -m pySecDecContrib pysecdec_cpuworker"``
         per available CPU, or one
         ``"nice python3 -m pySecDecContrib pysecdec_cudaworker -d <i>"``
-        for each available GPU.
+        for each available GPU. A command can also be given as
+        ``{"command": ..., "node": True}`` if it starts a node-level
+        sub-coordinator (``python3 -m pySecDec.disteval_node``).
 
     :param verbose:
         bool, optional;
         Print the set up and the integration log.
         Default: ``True``.
 
+    :param stage:
+        bool, optional;
+        Upload the integration libraries and the coefficient
+        files to the workers (and cache them on their nodes)
+        instead of relying on a filesystem shared with the
+        workers.
+        Default: ``False``.
+
     Instances of this class can be called with the
     following arguments:
 
@@ -1631,7 +1855,7 @@ class DistevalLibrary(object):
     value as a series in the regulator powers.
     '''
 
-    def __init__(self, specification_path, workers=None, verbose=True):
+    def __init__(self, specification_path, workers=None, verbose=True, stage=False):
         import asyncio
         import sys
         from . import disteval
@@ -1655,7 +1879,7 @@ class DistevalLibrary(object):
         self.filename = specification_path
         self.dirname = dirname
         self.verbose = verbose
-        self.prepared = asyncio.run(disteval.prepare_eval(workers, dirname, specification_path))
+        self.prepared = asyncio.run(disteval.prepare_eval(workers, dirname, specification_path, stage=stage))
 
     def __call__(self,
             parameters={}, real_parameters=[], complex_parameters=[],
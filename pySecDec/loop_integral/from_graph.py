@@ -3,10 +3,70 @@
 from .common import LoopIntegral
 from ..algebra import Polynomial, ExponentiatedPolynomial
 from ..misc import missing, cached_property, sympify_symbols, assert_degree_at_most_max_degree, sympify_expression, rec_subs
-from itertools import combinations
 import sympy as sp
 import numpy as np
 
+def forest_cuts(edges, numvert, numcut):
+    '''
+    Generate all sets of `numcut` edges of a graph whose removal
+    leaves a forest spanning all vertices, i.e. a spanning tree
+    if ``len(edges) - numcut == numvert - 1``, and a spanning
+    two-forest if ``len(edges) - numcut == numvert - 2``.
+
+    The uncut edges are added to a union-find structure one by
+    one, and any branch where an uncut edge would close a cycle
+    is abandoned immediately.
+
+    Yield pairs of the cut (a tuple of edge indices) and a list
+    that maps each vertex to a representative of its connected
+    component. The cuts come in the same order as from
+    ``itertools.combinations(range(len(edges)), numcut)``.
+
+    :param edges:
+        list of pairs of integers in ``range(numvert)``;
+        the vertices connected by each edge.
+
+    :param numvert:
+        integer; the number of vertices.
+
+    :param numcut:
+        integer; the number of edges to cut.
+    '''
+    numkeep = len(edges) - numcut
+    parent = list(range(numvert))
+    size = [1]*numvert
+    cut = []
+
+    def find(v):
+        # no path compression, so that unions can be undone
+        while parent[v] != v:
+            v = parent[v]
+        return v
+
+    def recurse(i, numkept):
+        if i == len(edges):
+            yield tuple(cut), [find(v) for v in range(numvert)]
+            return
+        # Cutting edge `i` before keeping it produces the cuts
+        # in lexicographic order.
+        if len(cut) < numcut:
+            cut.append(i)
+            yield from recurse(i + 1, numkept)
+            cut.pop()
+        if numkept < numkeep:
+            a, b = find(edges[i][0]), find(edges[i][1])
+            if a != b:
+                if size[a] < size[b]:
+                    a, b = b, a
+                parent[b] = a
+                size[a] += size[b]
+                yield from recurse(i + 1, numkept + 1)
+                size[a] -= size[b]
+                parent[b] = b
+
+    if 0 <= numkeep <= len(edges):
+        yield from recurse(0, 0)
+
 class LoopIntegralFromGraph(LoopIntegral):
     __doc__ = '''
     Construct the Feynman parametrization of a
@@ -147,31 +207,19 @@ class LoopIntegralFromGraph(LoopIntegral):
 
         return M
 
+    @cached_property
+    def _edges(self):
+        # the internal propagators as pairs of vertex indices
+        return [(self.intverts[line[1][0]], self.intverts[line[1][1]]) for line in self.internal_lines]
+
     @cached_property
     def preliminary_U(self):
 
         expolists=[]
         coeffs=[]
 
-        # iterate over all possible L-fold cuts
-        for cut in combinations(range(self.P), self.L):
-            # find uncut propagators
-            uncut = missing(range(self.P),cut)
-
-            # Define transition matrix for cut graph by removing cut propagators
-            newmatrix = np.matrix(self.vertmatrix) # copies data by default
-            for i in cut:
-                start = self.intverts[self.internal_lines[i][1][0]]
-                end = self.intverts[self.internal_lines[i][1][1]]
-                newmatrix[start,end] -= 1
-                newmatrix[end,start] -= 1
-
-            # Check if cut graph is connected
-            numvert = self.V + len(self.external_lines)
-            if(0 in newmatrix**numvert):
-                # not connected if exponentiated matrix has a zero
-                continue
-
+        # iterate over all L-fold cuts that leave a spanning tree
+        for cut, component in forest_cuts(self._edges, self.V, self.L):
             # construct monomial of Feynman parameters of cut propagators to be added to U
             expolist=[0]*self.P
             for i in cut:
@@ -187,45 +235,12 @@ class LoopIntegralFromGraph(LoopIntegral):
         expolists=[]
         coeffs=[]
 
-        # iterate over all possible (L+1)-fold cuts
-        for cut in combinations(range(self.P), self.L+1):
-            # find uncut propagators
-            uncut = missing(range(self.P),cut)
-
-            # Define transition matrix for cut graph by removing cut propagators
-            newmatrix = np.matrix(self.vertmatrix) # copies data by default
-            for i in cut:
-                start = self.intverts[self.internal_lines[i][1][0]]
-                end = self.intverts[self.internal_lines[i][1][1]]
-                newmatrix[start,end] -= 1
-                newmatrix[end,start] -= 1
-
-            numvert = self.V + len(self.external_lines)
-            newmatrix = newmatrix**numvert
-
-            # find all internal vertices *not* connected to vertex 0 (arbitrary choice)
-            intnotconnectedto0 = []
-            for i in range(self.V):
-                if newmatrix[0,i]==0:
-                    intnotconnectedto0.append(i)
-
-            # find all external vertices *not* connected to vertex 0
-            extnotconnectedto0 = []
-            for i in range(self.V,numvert):
-                if newmatrix[0,i]==0:
-                    extnotconnectedto0.append(i)
-
-            # check if all vertices not connected to 0 are connected to each other
-            valid2tree = True
-            notconnectedto0 = intnotconnectedto0 + extnotconnectedto0
-            for i,j in combinations(notconnectedto0, 2):
-                if newmatrix[i,j]==0:
-                    # there are more than two disconnected components -> not a valid two-tree cut
-                    valid2tree = False
-                    break
-            # drop current cut if it is not a valid two-tree cut
-            if not valid2tree:
-                continue
+        # iterate over all (L+1)-fold cuts that leave a spanning two-forest
+        numvert = self.V + len(self.external_lines)
+        for cut, component in forest_cuts(self._edges, self.V, self.L+1):
+            # find all external vertices *not* connected to vertex 0 (arbitrary choice)
+            extnotconnectedto0 = [self.V + i for i, line in enumerate(self.external_lines) \
+                                  if component[self.intverts[line[1]]] != component[0]]
 
             # find momementa running through the two cut lines
             # choose either all the external momenta connected to vertex 0 or the complement
@@ -33,7 +33,8 @@ def LoopPackage(name, loop_integral, requested_orders=None,
                  split=False, ibp_power_goal=-1,
                  use_iterative_sort=True, use_light_Pak=True,
                  use_dreadnaut=False, use_Pak=True,
-                 processes=None, pylink_qmc_transforms=['korobov3x3']):
+                 processes=None, pylink_qmc_transforms=['korobov3x3'],
+                 subtraction_taylor_threshold=None, extend=False):
     '''
     Convert a loop integral into a :func:`pySecDec.code_writer.MakePackage` object
     (suitable for use in :func:`pySecDec.code_writer.sum_package`).
@@ -42,8 +43,8 @@ def LoopPackage(name, loop_integral, requested_orders=None,
 
     ..note::
         The (optional) arguments `real_parameters`, `complex_parameters`,
-        `pylink_qmc_transforms`, `regulators`, `requested_orders` and
-        `requested_order` are ignored. These arguments should instead be passed to
+        `pylink_qmc_transforms`, `regulators`, `requested_orders`,
+        `requested_order` and `extend` are ignored. These arguments should instead be passed to
         the call to :func:`pySecDec.code_writer.sum_package`.
     '''
     # convert `contour_deformation` to bool
@@ -117,7 +118,11 @@ def LoopPackage(name, loop_integral, requested_orders=None,
         split = split,
         processes = processes,
 
-        pylink_qmc_transforms = pylink_qmc_transforms
+        pylink_qmc_transforms = pylink_qmc_transforms,
+
+        subtraction_taylor_threshold = subtraction_taylor_threshold,
+
+        extend = extend
     )
 
 def loop_package(name, loop_integral, requested_orders=None,
@@ -141,6 +146,8 @@ def loop_package(name, loop_integral, requested_orders=None,
                  use_Pak=True,
                  processes=None,
                  pylink_qmc_transforms=['korobov3x3'],
+                 subtraction_taylor_threshold=None,
+                 extend=False,
                  package_generator=make_package):
     """
     Decompose, subtract and expand a Feynman
@@ -237,6 +244,8 @@ def loop_package(name, loop_integral, requested_orders=None,
         * 'iterative'
         * 'geometric' (default)
         * 'geometric_ku'
+        * 'auto': the cheapest of the above, see
+          :func:`pySecDec.code_writer.make_package`
 
     :param enforce_complex:
         bool, optional;
@@ -339,6 +348,24 @@ def loop_package(name, loop_integral, requested_orders=None,
         `New in version 1.5`.
         Default: ``['korobov3x3']``
 
+    :param subtraction_taylor_threshold:
+        float or None, optional;
+        If given, the subtracted integrand is evaluated by
+        its Taylor expansion where a subtracted integration
+        variable is below this threshold, in order to avoid
+        numerical cancellations close to the sector boundaries.
+        See :func:`pySecDec.code_writer.make_package`.
+        Default: ``None``
+
+    :param extend:
+        bool, optional;
+        Extend the existing package `name`, generated by a
+        previous call with the same arguments but lower
+        `requested_orders`, so that only the new orders are
+        generated and compiled.
+        See :func:`pySecDec.code_writer.make_package`.
+        Default: ``False``
+
     :param package_generator:
         function;
         The generator function for the integral,
@@ -379,6 +406,8 @@ def loop_package(name, loop_integral, requested_orders=None,
         use_Pak=use_Pak,
         processes=processes,
         pylink_qmc_transforms=pylink_qmc_transforms,
+        subtraction_taylor_threshold=subtraction_taylor_threshold,
+        extend=extend,
     )._asdict())
 
     if isinstance(loop_integral, LoopIntegralFromGraph):
@@ -1,5 +1,7 @@
 from . import *
+from .from_graph import forest_cuts
 from ..misc import sympify_expression
+from itertools import combinations
 import numpy as np
 import sympy as sp
 import os
@@ -1131,6 +1133,43 @@ class TestUF_FromGraph(unittest.TestCase):
                                 LoopIntegralFromGraph, internal_lines = [['m',[1,2]], ['m',[1,2]]],
                                 external_lines = [['p1',1],['p1**2',2]])
 
+    def test_vertmatrix(self):
+        # one-loop bubble: two internal vertices, two external lines
+        li = LoopIntegralFromGraph(internal_lines = [['m',[1,2]], ['0',[1,2]]],
+                                   external_lines = [['p1',1],['p2',2]])
+        np.testing.assert_array_equal(li.vertmatrix, [[1,2,1,0],
+                                                      [2,1,0,1],
+                                                      [1,0,1,0],
+                                                      [0,1,0,1]])
+
+    def test_forest_cuts(self):
+        # complete graph with four vertices plus a self loop
+        edges = [(0,1), (0,2), (0,3), (1,2), (1,3), (2,3), (2,2)]
+
+        def spanning(uncut, numcomponents):
+            components = [{v} for v in range(4)]
+            for a, b in uncut:
+                ca = next(c for c in components if a in c)
+                cb = next(c for c in components if b in c)
+                if ca is cb:
+                    return False
+                components.remove(cb)
+                ca |= cb
+            return len(components) == numcomponents
+
+        for numcut, numcomponents in [(4,1), (5,2)]:
+            expected = [cut for cut in combinations(range(len(edges)), numcut) \
+                        if spanning([edges[i] for i in range(len(edges)) if i not in cut], numcomponents)]
+            cuts = [cut for cut, component in forest_cuts(edges, 4, numcut)]
+            self.assertEqual(cuts, expected)
+        self.assertEqual(len(list(forest_cuts(edges, 4, 4))), 16) # Cayley's formula
+
+        for cut, component in forest_cuts(edges, 4, 5):
+            uncut = [edges[i] for i in range(len(edges)) if i not in cut]
+            for a, b in uncut:
+                self.assertEqual(component[a], component[b])
+            self.assertEqual(len(set(component)), 2)
+
 def compare_two_loop_integrals(testcase, li1, li2):
     result_U_1 = sympify_expression(li1.U)
     result_F_1 = sympify_expression(li1.F)
@@ -17,7 +17,8 @@ def make_package(name, integration_variables, regulators, requested_orders,
                  decomposition_method='geometric_no_primary', normaliz_executable=None,
                  enforce_complex=False, split=False, ibp_power_goal=-1, use_iterative_sort=True,
                  use_light_Pak=True, use_dreadnaut=False, use_Pak=True, processes=None, form_executable=None,
-                 pylink_qmc_transforms=['korobov3x3']):
+                 pylink_qmc_transforms=['korobov3x3'], subtraction_taylor_threshold=None,
+                 extend=False):
     r'''
     Decompose, subtract and expand an expression.
     Return it as c++ package.
@@ -222,6 +223,11 @@ def make_package(name, integration_variables, regulators, requested_orders,
         In order to compute loop integrals, please use the
         function :func:`pySecDec.loop_integral.loop_package`.
 
+        With 'auto', 'auto_no_primary', or a list of the
+        strategies above, the candidate with the lowest
+        estimated cost is chosen automatically; see
+        :func:`pySecDec.code_writer.make_package`.
+
     :param normaliz_executable:
         string, optional;
         The command to run `normaliz`. `normaliz` is only
@@ -336,6 +342,24 @@ def make_package(name, integration_variables, regulators, requested_orders,
 
         `New in version 1.5`.
         Default: ``['korobov3x3']``
+
+    :param subtraction_taylor_threshold:
+        float or None, optional;
+        If given, the subtracted integrand is evaluated by
+        its Taylor expansion where a subtracted integration
+        variable is below this threshold, in order to avoid
+        numerical cancellations close to the sector boundaries.
+        See :func:`pySecDec.code_writer.make_package`.
+        Default: ``None``
+
+    :param extend:
+        bool, optional;
+        Extend the existing package `name`, generated by a
+        previous call with the same arguments but lower
+        `requested_orders`, so that only the new orders are
+        generated and compiled.
+        See :func:`pySecDec.code_writer.make_package`.
+        Default: ``False``
     '''
 
     # Build generators_args
@@ -370,7 +394,9 @@ def make_package(name, integration_variables, regulators, requested_orders,
         'use_dreadnaut' : use_dreadnaut,
         'use_Pak' : use_Pak,
         'processes' : processes,
-        'pylink_qmc_transforms' : pylink_qmc_transforms
+        'pylink_qmc_transforms' : pylink_qmc_transforms,
+        'subtraction_taylor_threshold' : subtraction_taylor_threshold,
+        'extend' : extend
     }
 
     sum_package(
@@ -381,5 +407,6 @@ def make_package(name, integration_variables, regulators, requested_orders,
                 real_parameters,
                 complex_parameters,
                 form_executable=form_executable,
-                pylink_qmc_transforms=pylink_qmc_transforms
+                pylink_qmc_transforms=pylink_qmc_transforms,
+                extend=extend
                 )
@@ -149,9 +149,6 @@ def find_regions(exp_param_index , polynomial, indices = None, normaliz=None, wo
         exp_param_index = indices.index(range(dim)[exp_param_index])
         polytope_vertices = [[vertex[i] for i in indices] for vertex in polytope_vertices]
 
-    if normaliz is None:
-        normaliz = os.path.join(pySecDecContrib.dirname, 'bin', 'normaliz')
-
     polytope = Polytope(vertices=polytope_vertices)
     polytope.complete_representation(normaliz, workdir)
 
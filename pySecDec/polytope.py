@@ -8,7 +8,7 @@ and :mod:`pySecDec.decomposition.geometric`.
 """
 
 from .algebra import Polynomial
-import os, shutil, subprocess, re, numpy as np
+import atexit, os, shutil, subprocess, re, threading, numpy as np
 
 import pySecDecContrib
 
@@ -149,6 +149,211 @@ def run_normaliz(normaliz=None, workdir='normaliz_tmp', run_card_filename='norma
                     error.filename = normaliz
                 raise
 
+class PolytopeEngine(object):
+    '''
+    Pool of long-lived polytope engine processes that
+    compute convex hulls and triangulations with the
+    `normaliz` library [BIR]_ in memory.
+
+    Requests are sent in batches over a pipe, so that
+    a decomposition does not spawn one `normaliz` process
+    per sector or cone, and does not communicate through
+    files. Concurrent callers (e.g. threads decomposing
+    different sectors) are served by separate processes.
+
+    :param executable:
+        string;
+        The polytope engine executable.
+        Default: use ``pysecdec_polytope`` from
+        pySecDecContrib
+
+    '''
+    def __init__(self, executable=None):
+        if executable is None:
+            executable = os.path.join(pySecDecContrib.dirname, 'bin', 'pysecdec_polytope')
+        self.executable = executable
+        self._lock = threading.Lock()
+        self._idle = []
+        self._pid = os.getpid()
+
+    def _acquire(self):
+        with self._lock:
+            if self._pid != os.getpid():
+                # the processes belong to the parent of a fork
+                self._idle = []
+                self._pid = os.getpid()
+            if self._idle:
+                return self._idle.pop()
+        try:
+            return subprocess.Popen([self.executable], stdin=subprocess.PIPE, stdout=subprocess.PIPE,
+                                    stderr=subprocess.DEVNULL, universal_newlines=True)
+        except OSError as error:
+            if self.executable not in str(error):
+                error.filename = self.executable
+            raise
+
+    def _release(self, process):
+        with self._lock:
+            if self._pid == os.getpid():
+                self._idle.append(process)
+                return
+        process.stdin.close()
+        process.wait()
+
+    @staticmethod
+    def _write_requests(stream, requests):
+        try:
+            for command, input_type, data in requests:
+                stream.write('%s %s %i %i\n' % (command, input_type, data.shape[0], data.shape[1]))
+                for row in data:
+                    stream.write(' '.join(str(int(x)) for x in row))
+                    stream.write('\n')
+            stream.flush()
+        except (BrokenPipeError, ValueError):
+            # the reader notices that the engine exited
+            pass
+
+    @staticmethod
+    def _read_reply(stream):
+        header = stream.readline().split(None, 1)
+        if not header:
+            raise RuntimeError('The polytope engine exited unexpectedly')
+        if header[0] == 'error':
+            return header[1].strip()
+        output = []
+        for i in range(int(header[1])):
+            shape = int(stream.readline()), int(stream.readline())
+            array_as_str = ''.join(stream.readline() for j in range(shape[0]))
+            if shape[0] == 0:
+                output.append(np.array([]))
+            else:
+                output.append(np.array(array_as_str.split(), dtype=int).reshape(shape))
+        return output
+
+    def run(self, requests):
+        '''
+        Process a batch of requests; return the list of
+        replies in the same order.
+
+        :param requests:
+            iterable of triples ``(command, input_type, data)``
+            where `data` is a two dimensional integer array;
+            See ``pySecDecContrib/polytope/server.cpp`` for
+            the commands.
+
+        '''
+        requests = [(command, input_type, np.asarray(data)) for command, input_type, data in requests]
+        if not requests:
+            return []
+        process = self._acquire()
+        try:
+            # write from a separate thread, so that large batches
+            # can not block on full pipes in both directions
+            writer = threading.Thread(target=self._write_requests, args=(process.stdin, requests))
+            writer.start()
+            replies = [self._read_reply(process.stdout) for request in requests]
+            writer.join()
+        except:
+            process.kill()
+            process.wait()
+            raise
+        self._release(process)
+        for reply in replies:
+            if isinstance(reply, str):
+                raise RuntimeError('normaliz failed: ' + reply)
+        return replies
+
+    def triangulate(self, cones, switch_representation=False):
+        '''
+        Triangulate a batch of cones; see :func:`.triangulate`.
+
+        :param cones:
+            iterable of two dimensional arrays;
+            The defining rays of the cones, or their facets
+            if `switch_representation` is ``True``.
+
+        :param switch_representation:
+            bool;
+            Whether or not to switch between facet and vertex/ray
+            representation.
+
+        '''
+        input_type = 'inequalities' if switch_representation else 'cone'
+        output = []
+        for original_cone, simplicial_cones_indices in self.run(('triangulate', input_type, cone) for cone in cones):
+            if np.array_equal(original_cone, np.array([])):
+                simplicial_cones_indices = []
+            output.append(original_cone[simplicial_cones_indices])
+        return output
+
+    def complete_representation(self, polytopes):
+        '''
+        Complete the representation of a batch of polytopes;
+        see :meth:`.Polytope.complete_representation`.
+
+        :param polytopes:
+            iterable of :class:`.Polytope`.
+
+        '''
+        polytopes = list(polytopes)
+        requests = []
+        for polytope in polytopes:
+            if polytope.facets is None:
+                requests.append(('convert', 'polytope', polytope.vertices))
+            elif polytope.vertices is None:
+                requests.append(('convert', 'inequalities', polytope.facets))
+            else:
+                raise ValueError('Both representations (facet and vertex) are already calculated')
+        for polytope, (vertices, facets, equations) in zip(polytopes, self.run(requests)):
+            # discard the last column that only consists of ones
+            polytope.vertices = vertices[:,:-1]
+            polytope.facets = facets
+            polytope.equations = equations
+
+    def close(self):
+        '''
+        Terminate the idle engine processes.
+
+        '''
+        with self._lock:
+            idle = self._idle if self._pid == os.getpid() else []
+            self._idle = []
+        for process in idle:
+            process.stdin.close()
+            process.wait()
+
+_default_polytope_engine = None
+_default_polytope_engine_lock = threading.Lock()
+
+def default_polytope_engine(normaliz=None, keep_workdir=False):
+    '''
+    Return the shared :class:`.PolytopeEngine`, or ``None``
+    if the file based communication with the `normaliz`
+    executable is to be used instead: if a `normaliz`
+    command is given, if the `workdir` is to be kept, or if
+    pySecDecContrib comes without the polytope engine.
+
+    :param normaliz:
+        string or None;
+        The `normaliz` argument of the caller.
+
+    :param keep_workdir:
+        bool;
+        The `keep_workdir` argument of the caller.
+
+    '''
+    global _default_polytope_engine
+    if normaliz is not None or keep_workdir:
+        return None
+    with _default_polytope_engine_lock:
+        if _default_polytope_engine is None:
+            engine = PolytopeEngine()
+            if not os.path.isfile(engine.executable):
+                return None
+            _default_polytope_engine = engine
+            atexit.register(engine.close)
+        return _default_polytope_engine
+
 def triangulate(cone, normaliz=None, workdir='normaliz_tmp', keep_workdir=False, switch_representation=False):
     '''
     Split a cone into simplicial cones; i.e.
@@ -156,8 +361,10 @@ def triangulate(cone, normaliz=None, workdir='normaliz_tmp', keep_workdir=False,
     where :math:`D` is the dimensionality.
 
     .. note::
-        This function calls the command line executable of
-        `normaliz` [BIR]_.
+        This function calls `normaliz` [BIR]_, through the
+        :class:`.PolytopeEngine` if `normaliz` is not given
+        and `keep_workdir` is ``False``, or through its
+        command line executable otherwise.
 
 
     :param cone:
@@ -178,8 +385,9 @@ def triangulate(cone, normaliz=None, workdir='normaliz_tmp', keep_workdir=False,
         is raised.
 
         .. note::
-            The communication with `normaliz` is done via
-            files.
+            The communication with the `normaliz` executable
+            is done via files. The :class:`.PolytopeEngine`
+            does not use the `workdir`.
 
     :param keep_workdir:
         bool;
@@ -191,13 +399,11 @@ def triangulate(cone, normaliz=None, workdir='normaliz_tmp', keep_workdir=False,
         representation.
 
     '''
-    cone = np.asarray(cone)
-    # basic consistency checks
-    assert len(cone.shape) == 2, '`cone` must be two dimensional'
-    assert cone.shape[0] >= cone.shape[1], 'Must at least have as many rays as the dimensionality'
+    cone = _check_cone(cone, switch_representation)
 
-    if cone.shape[0] == cone.shape[1] and not switch_representation:
-        raise ValueError("`cone` is simplicial already")
+    engine = default_polytope_engine(normaliz, keep_workdir)
+    if engine is not None:
+        return engine.triangulate([cone], switch_representation)[0]
 
     os.mkdir(workdir)
     try:
@@ -232,6 +438,51 @@ def triangulate(cone, normaliz=None, workdir='normaliz_tmp', keep_workdir=False,
         if not keep_workdir:
             shutil.rmtree(workdir)
 
+def triangulate_all(cones, normaliz=None, workdir='normaliz_tmp', switch_representation=False):
+    '''
+    Triangulate several cones; see :func:`.triangulate`.
+    With the default `normaliz`, all cones are sent to the
+    polytope engine in one batch. Return the list of
+    triangulations.
+
+    :param cones:
+        iterable of two dimensional arrays;
+        The defining rays of the cones.
+
+    :param normaliz:
+        string;
+        The shell command to run `normaliz`.
+        Default: use the polytope engine or `normaliz`
+        from pySecDecContrib
+
+    :param workdir:
+        string;
+        The directory for the communication with `normaliz`;
+        see :func:`.triangulate`.
+
+    :param switch_representation:
+        bool;
+        Whether or not to switch between facet and vertex/ray
+        representation.
+
+    '''
+    cones = [_check_cone(cone, switch_representation) for cone in cones]
+    engine = default_polytope_engine(normaliz)
+    if engine is not None:
+        return engine.triangulate(cones, switch_representation)
+    return [triangulate(cone, normaliz, workdir, switch_representation=switch_representation) for cone in cones]
+
+def _check_cone(cone, switch_representation):
+    cone = np.asarray(cone)
+    # basic consistency checks
+    assert len(cone.shape) == 2, '`cone` must be two dimensional'
+    assert cone.shape[0] >= cone.shape[1], 'Must at least have as many rays as the dimensionality'
+
+    if cone.shape[0] == cone.shape[1] and not switch_representation:
+        raise ValueError("`cone` is simplicial already")
+
+    return cone
+
 class Polytope(object):
     r'''
     Representation of a polytope defined by either its
@@ -288,8 +539,10 @@ class Polytope(object):
         ``self.vertices``.
 
         .. note::
-            This function calls the command line executable of
-            `normaliz` [BIR]_.
+            This function calls `normaliz` [BIR]_, through the
+            :class:`.PolytopeEngine` if `normaliz` is not given
+            and `keep_workdir` is ``False``, or through its
+            command line executable otherwise.
 
         :param normaliz:
             string;
@@ -305,14 +558,20 @@ class Polytope(object):
             is raised.
 
             .. note::
-                The communication with `normaliz` is done via
-                files.
+                The communication with the `normaliz` executable
+                is done via files. The :class:`.PolytopeEngine`
+                does not use the `workdir`.
 
         :param keep_workdir:
             bool;
             Whether or not to delete the `workdir` after execution.
 
         '''
+        engine = default_polytope_engine(normaliz, keep_workdir)
+        if engine is not None:
+            engine.complete_representation([self])
+            return
+
         os.mkdir(workdir)
         try:
             if self.facets is None:
@@ -46,7 +46,7 @@ def pole_structure(monomial_product, *indices):
 
 # -------------------------------------------- original subtraction --------------------------------------------
 
-def _integrate_pole_part_single_index(polyprod, index):
+def _integrate_pole_part_single_index(polyprod, index, taylor_switch=None):
     monomial_product = polyprod.factors[0] # e.g. (z1**2)**1-eps0-eps1  *  (z1*z2)**3-4*eps1
     monomial_product_FeynmanJ_set_to_one = monomial_product.replace(index,1)
     regulator_poles = polyprod.factors[1]
@@ -124,13 +124,39 @@ def _integrate_pole_part_single_index(polyprod, index):
         output_summands.append(Product(*current_factors, copy=False))
         minus_cal_I_expansion_summands.append(Product(-make_FeynmanIndex_to_power(p, p_factorial, polysymbols), derivative_cal_I_Feynmanj_set_to_zero, copy=False ))
 
-    integrable_part = Product(   monomial_product, regulator_poles, Sum(cal_I, *minus_cal_I_expansion_summands, copy=False).simplify() , copy=False   )
+    remainder = Sum(cal_I, *minus_cal_I_expansion_summands, copy=False).simplify()
+
+    if taylor_switch is not None:
+        # Close to ``t_j = 0``, the remainder is the difference of
+        # almost equal numbers. Replace it there by the next two terms
+        # of its Taylor expansion, which are free of cancellations:
+        # use ``switch * remainder + (1 - switch) * taylor_expansion``.
+        # ``p_factorial`` and ``derivative_cal_I`` continue from the pole part
+        taylor_summands = []
+        for p in range(int(-exponent_constant_term), int(-exponent_constant_term) + 2):
+            p_factorial *= p
+            derivative_cal_I = derivative_cal_I.derive(index)
+            taylor_summands.append(Product(make_FeynmanIndex_to_power(p, p_factorial, polysymbols), derivative_cal_I.replace(index, 0), copy=False))
+        switch = taylor_switch(index)
+        constant = np.zeros((1, monomial_product.number_of_variables), dtype=int)
+        one_minus_switch = Sum(
+                                    Polynomial(constant, np.array([_sympy_one]), polysymbols, copy=False),
+                                    Product(Polynomial(constant.copy(), np.array([-_sympy_one]), polysymbols, copy=False), switch.copy(), copy=False),
+                                    copy=False
+                              )
+        remainder = Sum(
+                            Product(switch, remainder, copy=False),
+                            Product(one_minus_switch, Sum(*taylor_summands, copy=False), copy=False),
+                            copy=False
+                       )
+
+    integrable_part = Product(   monomial_product, regulator_poles, remainder , copy=False   )
 
     output_summands.append(integrable_part)
 
     return output_summands
 
-def integrate_pole_part(polyprod, *indices):
+def integrate_pole_part(polyprod, *indices, taylor_switch=None):
     r'''
     Transform an integral of the form
 
@@ -197,6 +223,22 @@ def integrate_pole_part(polyprod, *indices):
         The index/indices of the parameter(s) to partially integrate.
         :math:`j` in the formulae above.
 
+    :param taylor_switch:
+        callable or None, optional;
+        If given, ``taylor_switch(j)`` must return an expression
+        of :math:`t_j` that is one where :math:`R` is to be
+        evaluated as is, and zero close to :math:`t_j = 0`, where
+        the subtracted difference cancels catastrophically in
+        floating point arithmetic. There, :math:`R` is replaced by
+        the first two terms of its Taylor expansion in :math:`t_j`.
+        The derivatives of the switch are assumed to vanish.
+        If :math:`R` starts at order :math:`t_j^n`, the neglected
+        terms are of order :math:`t_j^{n+2}`, i.e. the relative
+        truncation error is of order :math:`t_j^2` and below the
+        square of the threshold of the switch, while the rounding
+        error of the subtracted form grows like :math:`1/t_j^n`.
+        Default: ``None``
+
     Return the pole part and the numerically integrable remainder
     as a list. That is the sum and the integrand of equation (21)
     in arXiv:0803.4177v2 [Hei08]_.
@@ -209,7 +251,7 @@ def integrate_pole_part(polyprod, *indices):
         old_products = new_products
         new_products = []
         for polyprod in old_products:
-            new_products.extend( _integrate_pole_part_single_index(polyprod, index) )
+            new_products.extend( _integrate_pole_part_single_index(polyprod, index, taylor_switch) )
     return new_products
 
 # -------------------------------------------- integration by parts --------------------------------------------
@@ -0,0 +1,177 @@
+from .disteval import *
+from .disteval_node import Node
+from .disteval_benchmark import fit_cost_model
+import asyncio
+import io
+import json
+import unittest
+import pytest
+
+class FakeStdout:
+    def __init__(self):
+        self.data = asyncio.Queue()
+
+    async def read(self, n):
+        return await self.data.get()
+
+class FakeStdin:
+    def __init__(self):
+        self.messages = []
+
+    def write(self, data):
+        self.messages.extend(json.loads(line) for line in data.splitlines())
+
+    def close(self):
+        pass
+
+class FakeProcess:
+    """
+    Stands for a worker process: the messages sent to it are
+    collected in `stdin.messages`, and its replies are given
+    by `reply()`.
+    """
+    def __init__(self):
+        self.stdin = FakeStdin()
+        self.stdout = FakeStdout()
+
+    def reply(self, token, result, error=None):
+        self.stdout.data.put_nowait(b"@" + json.dumps([token, result, error]).encode("ascii") + b"\n")
+
+    def exit(self):
+        self.stdout.data.put_nowait(b"")
+
+def fake_worker(name, speed=1.0, node=False, width=1):
+    w = Worker(FakeProcess(), name=name)
+    w.speed, w.node, w.width = speed, node, width
+    w.latency = w.overhead = w.int_overhead = 0.0
+    return w
+
+async def settle():
+    for i in range(10):
+        await asyncio.sleep(0)
+
+#@pytest.mark.active
+class TestRandomScheduler(unittest.TestCase):
+    #@pytest.mark.active
+    def test_split_shifts_of_exited_node(self):
+        async def run():
+            par = RandomScheduler()
+            node = fake_worker("node", speed=1e6, node=True, width=4)
+            cpu = fake_worker("cpu")
+            par.add_worker(node)
+            par.add_worker(cpu)
+            shifts = [[0.1, 0.2], [0.3, 0.4], [0.5, 0.6]]
+            results = []
+            par.integrate_batch([((1, 100, 0, 100, [1, 7], [0.5, 0.5]), shifts, ("job",))],
+                None, lambda result, exception, w, *args: results.append((result, exception, args)))
+            sent = [m for m in node.process.stdin.messages if m[1] == "integrate_shifts"]
+            self.assertEqual(len(sent), 1)
+            self.assertEqual(sent[0][2], [1, 100, 0, 100, [1, 7], shifts, [0.5, 0.5]])
+
+            # The node exits; its shifts are sent to the CPU worker one by one.
+            node.process.exit()
+            await settle()
+            self.assertEqual(par.workers, [cpu])
+            calls = [m for m in cpu.process.stdin.messages if m[1] == "integrate"]
+            self.assertEqual(len(calls), len(shifts))
+            for (token, method, args), shift in zip(calls, shifts):
+                self.assertEqual(args, [1, 100, 0, 100, [1, 7], shift, [0.5, 0.5]])
+            for s, (token, method, args) in enumerate(calls):
+                cpu.process.reply(token, [[s, -s], 10, 0.5])
+            await settle()
+            self.assertEqual(results, [(([(0, 0), (1, -1), (2, -2)], 30, 1.5), None, ("job",))])
+            self.assertEqual(par.npending, 0)
+        asyncio.run(run())
+
+#@pytest.mark.active
+class TestWorker(unittest.TestCase):
+    #@pytest.mark.active
+    def test_multicall_while_calls_are_pending(self):
+        async def run():
+            w = fake_worker("w")
+            results = []
+            token = w.call_cb("integrate", (), lambda result, exception, w: results.append(result))
+            multicall = w.multicall([("have", ("a",)), ("have", ("b",))])
+            tokens = [m[0] for m in w.process.stdin.messages]
+            self.assertEqual(len(set(tokens)), 3)
+            self.assertNotIn(0, tokens)
+            for t in tokens[1:]:
+                w.process.reply(t, t)
+            w.process.reply(token, "integrated")
+            self.assertEqual(await multicall, tokens[1:])
+            await settle()
+            self.assertEqual(results, ["integrated"])
+            self.assertEqual(w.callbacks, {})
+        asyncio.run(run())
+
+#@pytest.mark.active
+class TestNode(unittest.TestCase):
+    #@pytest.mark.active
+    def test_local_worker_exits(self):
+        async def run():
+            output = io.BytesIO()
+            node = Node(None, output)
+            node.input = asyncio.StreamReader()
+            for i in range(2):
+                w = fake_worker(f"local{i}")
+                w.on_exit = node.worker_exited
+                node.workers.append(w)
+            w0, w1 = node.workers
+            node.pending[7] = []
+            node.integrate_shifts(7, (1, 100, 0, 100, [1], [[0.1], [0.2]], [0.5]))
+            self.assertEqual(len(w0.process.stdin.messages), 1)
+            self.assertEqual(len(w1.process.stdin.messages), 1)
+
+            # The shifts of the exited worker fail the whole call, and
+            # the other shifts are cancelled.
+            w0.process.exit()
+            await settle()
+            self.assertEqual(node.workers, [w1])
+            self.assertEqual([json.loads(line[1:]) for line in output.getvalue().splitlines()], [[7, None, WORKER_EXITED]])
+            self.assertEqual(w1.process.stdin.messages[-1][1], "cancel")
+
+            # Without workers, the node stops reading commands.
+            w1.process.exit()
+            await settle()
+            self.assertEqual(node.workers, [])
+            self.assertEqual(await node.input.readline(), b"")
+        asyncio.run(run())
+
+#@pytest.mark.active
+class TestCostModel(unittest.TestCase):
+    metrics = [
+        {"dimension": 2, "operations": 100, "transcendental": 0, "calls": 0},
+        {"dimension": 3, "operations": 400, "transcendental": 2, "calls": 1},
+        {"dimension": 4, "operations": 1000, "transcendental": 10, "calls": 0},
+        {"dimension": 5, "operations": 3000, "transcendental": 5, "calls": 4},
+        {"dimension": 6, "operations": 8000, "transcendental": 30, "calls": 2},
+        {"dimension": 7, "operations": 20000, "transcendental": 12, "calls": 6}
+    ]
+
+    #@pytest.mark.active
+    def test_fit_exact(self):
+        model = {"point": 0.2, "dimension": 0.05, "operations": 0.004, "transcendental": 0.08, "calls": 0.03}
+        tau = [predict_kernel_cost(model, m) for m in self.metrics]
+        fit = fit_cost_model(self.metrics, tau)
+        for key in model:
+            self.assertAlmostEqual(fit[key], model[key])
+
+    #@pytest.mark.active
+    def test_fit_non_negative(self):
+        # the unconstrained fit gives a negative coefficient of "calls"
+        model = {"point": 0.2, "dimension": 0.05, "operations": 0.004, "transcendental": 0.08, "calls": -0.03}
+        tau = [sum(c*(1 if key == "point" else m[key]) for key, c in model.items()) for m in self.metrics]
+        fit = fit_cost_model(self.metrics, tau)
+        self.assertEqual(fit["calls"], 0)
+        for key in model:
+            self.assertGreaterEqual(fit[key], 0)
+        for m, t in zip(self.metrics, tau):
+            self.assertLess(abs(predict_kernel_cost(fit, m)/t - 1), 0.2)
+
+    #@pytest.mark.active
+    def test_unused_terms(self):
+        # terms that are zero for every kernel are not fitted
+        metrics = [{"dimension": d, "operations": n} for d, n in ((2, 100), (3, 250), (4, 700), (5, 800))]
+        fit = fit_cost_model(metrics, [0.5, 0.7, 1.2, 1.4])
+        self.assertEqual(fit["transcendental"], 0)
+        self.assertEqual(fit["calls"], 0)
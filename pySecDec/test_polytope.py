@@ -434,3 +434,56 @@ class TestPolytope(unittest.TestCase):
         target_cone = np.array([])
         triangulated_cone = triangulate(cone, workdir='tmpdir_test_triangulate_0D_python' + python_major_version, switch_representation=True)
         np.testing.assert_array_equal(triangulated_cone, target_cone)
+
+@unittest.skipIf(default_polytope_engine() is None, 'the polytope engine is not installed')
+class TestPolytopeEngine(unittest.TestCase):
+    def setUp(self):
+        self.engine = PolytopeEngine()
+        self.cone = [[ 1,  0,  0], [ 0,  1,  0], [ 0, -1, -1], [-1,  0, -1]]
+        self.vertices = [[2,1],[1,2],[2,0],[1,0],[0,2],[0,1],[1,1]]
+        self.facets = [[0,1,0],[1,0,0],[-1,0,2],[0,-1,2],[1,1,-1],[-1,-1,3]]
+
+    def tearDown(self):
+        self.engine.close()
+
+    #@pytest.mark.active
+    def test_batch(self):
+        triangulations = self.engine.triangulate([self.cone, self.cone, [[1]]], switch_representation=False)
+        assert len(triangulations) == 3
+        assert triangulations[0].shape == (2,3,3)
+        np.testing.assert_array_equal(triangulations[0], triangulations[1])
+        np.testing.assert_array_equal(triangulations[2], [[[1]]])
+
+        polytope1 = Polytope(vertices=self.vertices)
+        polytope2 = Polytope(facets=self.facets)
+        self.engine.complete_representation([polytope1, polytope2])
+        np.testing.assert_array_equal(sort_2D_array(polytope1.facets), sort_2D_array(np.array(self.facets)))
+        np.testing.assert_array_equal(sort_2D_array(polytope2.vertices), sort_2D_array(np.array(self.vertices[:-1])))
+        np.testing.assert_array_equal(polytope1.equations, np.array([]))
+
+        with pytest.raises(ValueError, match='(B|b)oth.*already'):
+            self.engine.complete_representation([polytope1])
+
+    #@pytest.mark.active
+    def test_error(self):
+        with pytest.raises(RuntimeError, match='normaliz failed'):
+            self.engine.run([('triangulate', 'cone', self.cone), ('convert', 'cone', self.cone)])
+        # the engine keeps working after an error
+        assert self.engine.triangulate([self.cone])[0].shape == (2,3,3)
+
+    #@pytest.mark.active
+    def test_nonexistent_executable(self):
+        engine = PolytopeEngine('nonexistentPolytopeEngine')
+        with pytest.raises(OSError, match='No such file or directory.*nonexistentPolytopeEngine'):
+            engine.triangulate([self.cone])
+
+    #@pytest.mark.active
+    def test_threads(self):
+        import concurrent.futures
+        target = self.engine.triangulate([self.cone])[0]
+        with concurrent.futures.ThreadPoolExecutor(4) as pool:
+            results = list(pool.map(lambda i: self.engine.triangulate([self.cone]*(i+1)), range(16)))
+        for i, result in enumerate(results):
+            assert len(result) == i + 1
+            for triangulation in result:
+                np.testing.assert_array_equal(triangulation, target)
@@ -117,6 +117,51 @@ class TestIntegratePolePart(unittest.TestCase):
         for i,term in enumerate(I_0):
             integrate_pole_part(term,1)
 
+    #@pytest.mark.active
+    def test_taylor_switch(self):
+        all_symbols = self.Feynman_parameter_symbols+self.regulator_symbols
+        cal_I = Polynomial([(0,0,0,0),(1,0,0,0),(2,1,0,0),(3,0,0,0),(4,0,0,0),(0,1,0,0)],['A','B','C','E','F','D'], polysymbols=all_symbols)
+        taylor_switch = lambda index: Function('SW', Polynomial.from_expression(all_symbols[index], all_symbols))
+        I_j_before = Product(self.monomial_product1,self.regulator_poles,cal_I)
+        I_j_after = integrate_pole_part(I_j_before, 0, taylor_switch=taylor_switch)
+        I_j_without_switch = integrate_pole_part(I_j_before, 0)
+
+        # the pole parts do not change
+        assert len(I_j_after) == len(I_j_without_switch)
+        for with_switch, without_switch in zip(I_j_after[:-1], I_j_without_switch[:-1]):
+            assert (sympify_expression(with_switch) - sympify_expression(without_switch)).simplify() == 0
+
+        # where the switch is zero, the remainder is replaced by the
+        # second and third order of its Taylor expansion in x0
+        expected_numerical_integrand = sympify_expression('''
+                                                      SW(x0) * (A + B*x0 + C*x0**2*x1 + E*x0**3 + F*x0**4 + D*x1 - A - D*x1 - B*x0) +
+                                                      (1 - SW(x0)) * (2*C*x1 * x0**2/2 + 6*E * x0**3/6)
+                                                  ''') * sympify_expression( str(self.exponentiated_monomial1) )
+        assert (sympify_expression(I_j_after[-1]) - expected_numerical_integrand).simplify() == 0
+        assert type(I_j_after[-1]) == Product
+        assert type(I_j_after[-1].factors[0]) == Product
+
+    #@pytest.mark.active
+    def test_taylor_switch_truncation_error(self):
+        all_symbols = self.Feynman_parameter_symbols+self.regulator_symbols
+        cal_I = Polynomial([(0,0,0,0),(1,0,0,0),(2,1,0,0),(3,0,0,0),(4,0,0,0),(0,1,0,0)],[3,2,1,-1,5,7], polysymbols=all_symbols)
+        taylor_switch = lambda index: Function('SW', Polynomial.from_expression(all_symbols[index], all_symbols))
+        I_j_after = integrate_pole_part(Product(self.monomial_product1,self.regulator_poles,cal_I), 0, taylor_switch=taylor_switch)
+        remainder = sympify_expression(I_j_after[-1].factors[2])
+        x0, x1 = sp.symbols('x0 x1')
+        switch = sp.Function('SW')(x0)
+        exact = remainder.subs(switch, 1)
+        taylor = remainder.subs(switch, 0)
+
+        # close to the threshold, the relative error of the Taylor form is of order x0**2
+        def relative_error(t):
+            values = {x0: sp.Rational(t), x1: sp.Rational(1,2)}
+            return abs((taylor.subs(values) - exact.subs(values)) / exact.subs(values))
+        for threshold in ('1/100', '1/1000'):
+            t = sp.Rational(threshold)
+            assert relative_error(t) < 20 * t**2
+            assert abs(relative_error(t/2) / relative_error(t) - sp.Rational(1,4)) < sp.Rational(1,20)
+
     #@pytest.mark.active
     def test_catch_one_over_zero(self):
         minus_one = Polynomial([[0]], [-1])
@@ -0,0 +1,81 @@
+/* This file implements the cancellation of integration jobs: the
+ * coordinator sends
+ *
+ *     [0, "cancel", [token]]
+ *
+ * for a job whose result it no longer needs. The message has no
+ * reply of its own; instead the cancelled job replies with the
+ * "cancelled" error: if it has not started yet it is dropped, and
+ * if it is running it is aborted between two blocks of lattice
+ * points. Jobs that finish before the cancellation arrives reply
+ * as usual.
+ *
+ * Integration jobs are started in the order of their tokens, so
+ * cancellations of jobs that have already finished can be told
+ * apart and forgotten.
+ */
+
+#include <pthread.h>
+#include <atomic>
+#include <set>
+
+// Number of lattice points between two checks for cancellation.
+#define CANCEL_BLOCK (1 << 16)
+
+static struct {
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    std::set<uint64_t> tokens; // cancelled jobs that have not started yet
+    uint64_t started = 0; // the largest token of a started job
+    uint64_t running = 0; // the token of the running job, or 0
+    std::atomic<bool> abort{false};
+} C;
+
+// Apply the cancellation if the line is a "cancel" command,
+// return true if it was.
+static bool
+cancel_command(const char *line)
+{
+    uint64_t token = 0, target = 0;
+    if (sscanf(line, "[%" SCNu64 ",\"cancel\",[%" SCNu64 "]]", &token, &target) != 2) return false;
+    pthread_mutex_lock(&C.lock);
+    if (target != 0 && target == C.running) {
+        C.abort = true;
+    } else if (target > C.started) {
+        C.tokens.insert(target);
+    }
+    pthread_mutex_unlock(&C.lock);
+    return true;
+}
+
+// Mark the job as running, return false if it was cancelled.
+static bool
+cancel_begin(uint64_t token)
+{
+    pthread_mutex_lock(&C.lock);
+    if (token > C.started) C.started = token;
+    bool cancelled = C.tokens.erase(token) != 0;
+    C.running = cancelled ? 0 : token;
+    C.abort = false;
+    pthread_mutex_unlock(&C.lock);
+    return !cancelled;
+}
+
+static void
+cancel_end()
+{
+    pthread_mutex_lock(&C.lock);
+    C.running = 0;
+    pthread_mutex_unlock(&C.lock);
+}
+
+static inline bool
+cancel_requested()
+{
+    return C.abort.load(std::memory_order_relaxed);
+}
+
+static void
+print_cancelled(uint64_t token)
+{
+    printf("@[%" PRIu64 ",null,\"cancelled\"]\n", token);
+}
@@ -10,8 +10,12 @@
 #include <string.h>
 #include <time.h>
 #include <unistd.h>
+#include <deque>
 #include <vector>
 
+#include "stage.h"
+#include "cancel.h"
+
 #include <ginac/ginac.h>
 #include <ginac/parser.h>
 #include <streambuf>
@@ -70,6 +74,8 @@ typedef int (*FpolycheckF)(
     const real_t * deformp
 );
 
+#include "nanpoint.h"
+
 struct Family {
     uint64_t dimension;
     real_t realp[MAXDIM];
@@ -124,6 +130,7 @@ struct IntegrateCmd {
     uint64_t genvec[MAXDIM];
     real_t shift[MAXDIM];
     real_t deformp[MAXDIM];
+    uint64_t ndeformp;
 };
 
 // Global data
@@ -132,7 +139,6 @@ static std::vector<Family> families;
 static std::vector<Kernel> kernels;
 static char *input_line = NULL;
 static char *input_p = NULL;
-static size_t input_linesize = 0;
 
 #define input_getchar() (*input_p++)
 #define input_peekchar() (*input_p)
@@ -267,16 +273,39 @@ cmd_integrate(uint64_t token, IntegrateCmd &c)
         printf("@[%" PRIu64 ",null,\"kernel %" PRIu64 " was not loaded\"]\n", token, c.kernelidx);
         return 0;
     }
+    if (!cancel_begin(token)) {
+        print_cancelled(token);
+        return 0;
+    }
     const Kernel &ker = kernels[c.kernelidx];
     const Family &fam = families[ker.familyidx];
     complex_t result = {};
+    int r = 0;
+    bool cancelled = false;
+    uint64_t b1 = c.i1, b2 = c.i1;
     double t1 = timestamp();
-    int r = ker.fn_integrate(&result,
-        c.lattice, c.i1, c.i2, c.genvec, c.shift,
-        fam.realp, fam.complexp, c.deformp);
+    for (uint64_t i1 = c.i1; i1 < c.i2; i1 += CANCEL_BLOCK) {
+        if (unlikely(cancel_requested())) { cancelled = true; break; }
+        uint64_t i2 = c.i2 - i1 > CANCEL_BLOCK ? i1 + CANCEL_BLOCK : c.i2;
+        complex_t blockresult = {};
+        r = ker.fn_integrate(&blockresult,
+            c.lattice, i1, i2, c.genvec, c.shift,
+            fam.realp, fam.complexp, c.deformp);
+        result.re += blockresult.re;
+        result.im += blockresult.im;
+        b1 = i1; b2 = i2;
+        if (r != 0 || isnan(result.re) || isnan(result.im)) break;
+    }
     double t2 = timestamp();
-    if (unlikely((isnan(result.re) || isnan(result.im)) ^ (r != 0))) {
+    cancel_end();
+    NanJob nj = {ker.fn_integrate, fam.dimension, c.lattice, c.genvec, c.shift, fam.realp, fam.complexp, c.deformp, c.ndeformp};
+    NanPoint np;
+    if (cancelled) {
+        print_cancelled(token);
+    } else if (unlikely((isnan(result.re) || isnan(result.im)) ^ (r != 0))) {
         printf("@[%" PRIu64 ",[[NaN,NaN],%" PRIu64 ",%.4e],\"NaN != sign check error %d in %s.%s\"]\n", token, c.i2-c.i1, t2-t1, r, fam.name, ker.name);
+    } else if ((isnan(result.re) || isnan(result.im)) && nan_locate(nj, b1, b2, np)) {
+        print_nan_point(token, c.i2-c.i1, t2-t1, nj, np);
     } else if (isnan(result.re) || isnan(result.im)) {
         printf("@[%" PRIu64 ",[[NaN,NaN],%" PRIu64 ",%.4e],null]\n", token, c.i2-c.i1, t2-t1);
     } else {
@@ -363,17 +392,17 @@ parse_complex()
 }
 
 #define define_parse_X_array(name, type, parse_X) \
-    static void \
+    static size_t \
     name(type *ar, size_t maxn) \
     { \
         match_c('['); \
         int c = input_peekchar(); \
-        if (c == ']') { input_getchar(); return; } \
+        if (c == ']') { input_getchar(); return 0; } \
         for (size_t i = 0;; i++) { \
             if (unlikely(i >= maxn)) parse_fail(); \
             ar[i] = parse_X(); \
             int c = input_getchar(); \
-            if (c == ']') break; \
+            if (c == ']') return i + 1; \
             if (unlikely(c != ',')) parse_fail(); \
         } \
     }
@@ -587,7 +616,7 @@ handle_one_command()
         match_c(',');
         parse_real_array(c.shift, MAXDIM);
         match_c(',');
-        parse_real_array(c.deformp, MAXDIM);
+        c.ndeformp = parse_real_array(c.deformp, MAXDIM);
         match_str("]]\n");
         return cmd_integrate(token, c);
     }
@@ -657,6 +686,48 @@ handle_one_command()
         match_str("]]\n");
         return cmd_start(token, c);
     }
+    if (c == 'r') {
+        match_str("undir\",[]]\n");
+        cmd_rundir(token, workername, "cpu");
+        return 0;
+    }
+    if (c == 'h') {
+        char hash[MAXNAME + 1];
+        match_str("ave\",[");
+        parse_str(hash, sizeof(hash));
+        match_str("]]\n");
+        cmd_have(token, hash);
+        return 0;
+    }
+    if (c == 'u') {
+        char hash[MAXNAME + 1];
+        match_str("pload\",[");
+        parse_str(hash, sizeof(hash));
+        match_c(',');
+        uint64_t offset = parse_uint();
+        match_c(',');
+        uint64_t size = parse_uint();
+        match_c(',');
+        uint64_t total = parse_uint();
+        match_str(",\"");
+        const char *data = input_p;
+        const char *end = strchr(data, '"');
+        if (unlikely(end == NULL)) parse_fail();
+        input_p = (char*)end + 1;
+        match_str("]]\n");
+        cmd_upload(token, hash, offset, size, total, data, end - data);
+        return 0;
+    }
+    if (c == 'l') {
+        char name[MAXPATH + 1], hash[MAXNAME + 1];
+        match_str("ink\",[");
+        parse_str(name, sizeof(name));
+        match_c(',');
+        parse_str(hash, sizeof(hash));
+        match_str("]]\n");
+        cmd_link(token, name, hash);
+        return 0;
+    }
     if (c == 'e') {
         match_str("valf\",[");
         return parse_cmd_evalf(token);
@@ -674,6 +745,52 @@ fill_workername()
     snprintf(workername, sizeof(workername), "%s:%ld", host, pid);
 }
 
+// Input is read in a separate thread, so that cancellations
+// reach the job they refer to while it is running.
+
+static struct {
+    std::deque<char*> lines;
+    bool eof = false;
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+} Q;
+
+static void *
+reader_thread(void *)
+{
+    for (;;) {
+        char *line = NULL;
+        size_t size = 0;
+        if (getline(&line, &size, stdin) < 0) { free(line); break; }
+        if (cancel_command(line)) { free(line); continue; }
+        pthread_mutex_lock(&Q.lock);
+        Q.lines.push_back(line);
+        pthread_cond_signal(&Q.cond);
+        pthread_mutex_unlock(&Q.lock);
+    }
+    pthread_mutex_lock(&Q.lock);
+    Q.eof = true;
+    pthread_cond_signal(&Q.cond);
+    pthread_mutex_unlock(&Q.lock);
+    return NULL;
+}
+
+static char *
+next_line()
+{
+    char *line = NULL;
+    pthread_mutex_lock(&Q.lock);
+    while (Q.lines.empty() && !Q.eof) {
+        pthread_cond_wait(&Q.cond, &Q.lock);
+    }
+    if (!Q.lines.empty()) {
+        line = Q.lines.front();
+        Q.lines.pop_front();
+    }
+    pthread_mutex_unlock(&Q.lock);
+    return line;
+}
+
 int main() {
     fill_workername();
     setvbuf(stdin, NULL, _IOFBF, 1024*1024);
@@ -684,13 +801,20 @@ int main() {
     double lastt = 0;
     double t1 = timestamp();
     bool quit = false;
+    pthread_t reader;
+    pthread_create(&reader, NULL, &reader_thread, NULL);
     while (!quit) {
         lastt = timestamp();
-        if (getline(&input_line, &input_linesize, stdin) < 0) break;
+        input_line = next_line();
+        if (input_line == NULL) break;
         readt += timestamp() - lastt;
         input_p = input_line;
         workt += handle_one_command();
+        free(input_line);
     }
+    input_line = NULL;
+    pthread_join(reader, NULL);
+    stage_cleanup();
     double t2 = timestamp();
     if (0) {
         fprintf(stderr, "%s] Done in %.3gs: %.3g%% useful time, %.3g%% read time; work ended %.3gs ago\n",
@@ -14,6 +14,8 @@
 #include <vector>
 
 #include "minicuda.h"
+#include "stage.h"
+#include "cancel.h"
 
 #include <ginac/ginac.h>
 #include <ginac/parser.h>
@@ -78,6 +80,8 @@ typedef int (*FpolycheckF)(
     const real_t * deformp
 );
 
+#include "nanpoint.h"
+
 struct Family {
     uint64_t dimension;
     real_t realp[MAXDIM];
@@ -135,6 +139,7 @@ struct IntegrateCmd {
     uint64_t genvec[MAXDIM];
     real_t shift[MAXDIM];
     real_t deformp[MAXDIM];
+    uint64_t ndeformp;
 };
 
 struct CudaParameterData {
@@ -376,6 +381,10 @@ worker_thread(void *ps)
     for (;;) {
         IntegrateCmd c;
         obtain_integrate_cmd(c);
+        if (!cancel_begin(c.token)) {
+            print_cancelled(c.token);
+            continue;
+        }
         const Kernel &ker = G.kernels[c.kernelidx];
         const Family &fam = G.families[ker.familyidx];
         if (0) { // CPU path
@@ -399,6 +408,8 @@ worker_thread(void *ps)
             uint64_t blocksperbatch = fam.complex_result ? CUDA_BUFFER_SIZE/sizeof(complex_t) : CUDA_BUFFER_SIZE/sizeof(real_t);
             uint64_t ptperbatch = blocksperbatch * (threads*pt_per_thread);
             complex_t result = {0, 0};
+            bool cancelled = false;
+            uint64_t b1 = c.i1, b2 = c.i1;
             memcpy(s.params->genvec, c.genvec, sizeof(c.genvec));
             memcpy(s.params->shift, c.shift, sizeof(c.shift));
             memcpy(s.params->realp, fam.realp, sizeof(fam.realp));
@@ -414,6 +425,7 @@ worker_thread(void *ps)
             CUdeviceptr complexp_d = s.params_d + offsetof(CudaParameterData, complexp);
             CUdeviceptr deformp_d = s.params_d + offsetof(CudaParameterData, deformp);
             for (uint64_t i1 = c.i1; i1 < c.i2; i1 += ptperbatch) {
+                if (unlikely(cancel_requested())) { cancelled = true; break; }
                 uint64_t i2 = i1 + ptperbatch < c.i2 ? i1 + ptperbatch : c.i2;
                 uint64_t blocks = (i2 - i1 + threads*pt_per_thread - 1)/(threads*pt_per_thread);
                 void *args[] = {&s.buffer_d, &c.lattice, &i1, &i2, &genvec_d, &shift_d, &realp_d, &complexp_d, &deformp_d, NULL };
@@ -442,15 +454,26 @@ worker_thread(void *ps)
                 CU(cuStreamSynchronize, s.stream);
                 result.re += s.result->re;
                 result.im += s.result->im;
+                b1 = i1; b2 = i2;
+                if (isnan(result.re) || isnan(result.im)) break;
             }
             double t2 = timestamp();
-            if (isnan(result.re) || isnan(result.im)) {
+            // The failing point is located with the CPU version
+            // of the kernel.
+            NanJob nj = {ker.fn_integrate, fam.dimension, c.lattice, c.genvec, c.shift, fam.realp, fam.complexp, c.deformp, c.ndeformp};
+            NanPoint np;
+            if (cancelled) {
+                print_cancelled(c.token);
+            } else if ((isnan(result.re) || isnan(result.im)) && nan_locate(nj, b1, b2, np)) {
+                print_nan_point(c.token, c.i2-c.i1, t2-t1, nj, np);
+            } else if (isnan(result.re) || isnan(result.im)) {
                 printf("@[%" PRIu64 ",[[NaN,NaN],%" PRIu64 ",%.4e],null]\n", c.token, c.i2-c.i1, t2-t1);
             } else {
                 printf("@[%" PRIu64 ",[[%.16e,%.16e],%" PRIu64 ",%.4e],null]\n", c.token, result.re, result.im, c.i2-c.i1, t2-t1);
             }
             s.useful_time += t2-t1;
         }
+        cancel_end();
     }
     return NULL;
 }
@@ -579,17 +602,17 @@ parse_complex()
 }
 
 #define define_parse_X_array(name, type, parse_X) \
-    static void \
+    static size_t \
     name(type *ar, size_t maxn) \
     { \
         match_c('['); \
         int c = input_peekchar(); \
-        if (c == ']') { input_getchar(); return; } \
+        if (c == ']') { input_getchar(); return 0; } \
         for (size_t i = 0;; i++) { \
             if (unlikely(i >= maxn)) parse_fail(); \
             ar[i] = parse_X(); \
             int c = input_getchar(); \
-            if (c == ']') break; \
+            if (c == ']') return i + 1; \
             if (unlikely(c != ',')) parse_fail(); \
         } \
     }
@@ -803,7 +826,7 @@ handle_one_command()
         match_c(',');
         parse_real_array(c.shift, MAXDIM);
         match_c(',');
-        parse_real_array(c.deformp, MAXDIM);
+        c.ndeformp = parse_real_array(c.deformp, MAXDIM);
         match_str("]]\n");
         return cmd_integrate(token, c);
     }
@@ -873,6 +896,44 @@ handle_one_command()
         match_str("]]\n");
         return cmd_start(token, c);
     }
+    if (c == 'r') {
+        match_str("undir\",[]]\n");
+        return cmd_rundir(token, G.workername, "cuda");
+    }
+    if (c == 'h') {
+        char hash[MAXNAME + 1];
+        match_str("ave\",[");
+        parse_str(hash, sizeof(hash));
+        match_str("]]\n");
+        return cmd_have(token, hash);
+    }
+    if (c == 'u') {
+        char hash[MAXNAME + 1];
+        match_str("pload\",[");
+        parse_str(hash, sizeof(hash));
+        match_c(',');
+        uint64_t offset = parse_uint();
+        match_c(',');
+        uint64_t size = parse_uint();
+        match_c(',');
+        uint64_t total = parse_uint();
+        match_str(",\"");
+        const char *data = G.input_p;
+        const char *end = strchr(data, '"');
+        if (unlikely(end == NULL)) parse_fail();
+        G.input_p = (char*)end + 1;
+        match_str("]]\n");
+        return cmd_upload(token, hash, offset, size, total, data, end - data);
+    }
+    if (c == 'l') {
+        char name[MAXPATH + 1], hash[MAXNAME + 1];
+        match_str("ink\",[");
+        parse_str(name, sizeof(name));
+        match_c(',');
+        parse_str(hash, sizeof(hash));
+        match_str("]]\n");
+        return cmd_link(token, name, hash);
+    }
     if (c == 'e') {
         match_str("valf\",[");
         return parse_cmd_evalf(token);
@@ -921,9 +982,11 @@ main(int argc, char *argv[])
         lastt = timestamp();
         if (getline(&G.input_line, &G.input_linesize, stdin) < 0) break;
         readt += timestamp() - lastt;
+        if (cancel_command(G.input_line)) continue;
         G.input_p = G.input_line;
         handle_one_command();
     }
+    stage_cleanup();
     double t2 = timestamp();
     for (int i = 0; i < NTHREADS; i++)
         G.useful_time += G.threads[i].useful_time;
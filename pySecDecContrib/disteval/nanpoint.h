@@ -0,0 +1,203 @@
+/* This file implements the localisation of NaN results: when an
+ * integration job gives NaN, the worker looks for the first
+ * lattice point responsible for it, and adds a description of
+ * the point to the reply:
+ *
+ *     [[NaN, NaN], di, dt, [index, [x, ...], cause, deformp]]
+ *
+ * Here "index" is the lattice index of the point, and "x" are its
+ * coordinates before the periodizing transform. The "cause" is
+ * - "U" if the sign check of the positive polynomials failed;
+ * - "F" if the sign check of the contour deformation failed;
+ * - "overflow" if an overflow or a division by zero occurred;
+ * - "domain" if a function was evaluated outside of its domain
+ *   (e.g. the logarithm of a negative number);
+ * - "unknown" otherwise.
+ * The last three are told apart by the floating point exception
+ * flags, so they are only a hint. Finally, "deformp" are the
+ * deformation parameters, lowered in steps of 0.9 until the point
+ * is finite; only the parameters that can make the point finite
+ * on their own are lowered, if there are any. It is null if no
+ * deformation does.
+ *
+ * The point is found by bisection within the range of points in
+ * which the failure was detected, i.e. the last block of a CPU
+ * job, or the last batch of a GPU job. Each step integrates the
+ * halves of the current range, so the search costs up to three
+ * times the range. Only if neither half fails on its own (e.g.
+ * if infinities of opposite signs cancel) are the prefixes of the
+ * range bisected instead, at up to the whole range per step. If
+ * the range is larger than NAN_MAX_RANGE points, or does not fail
+ * on its own, the point is not looked for. Once found, the point
+ * is evaluated on its own: with a zero generating vector and the
+ * coordinates of the point as the shift, all lanes of the kernel
+ * see the same point.
+ */
+
+#include <fenv.h>
+
+#define NAN_MAX_RANGE (1 << 20)
+
+struct NanPoint {
+    uint64_t index;
+    real_t x[MAXDIM];
+    const char *cause;
+    bool repaired;
+    real_t deformp[MAXDIM];
+};
+
+struct NanJob {
+    IntegrateF fn;
+    uint64_t dimension;
+    uint64_t lattice;
+    const uint64_t *genvec;
+    const real_t *shift;
+    const real_t *realp;
+    const complex_t *complexp;
+    const real_t *deformp;
+    uint64_t ndeformp;
+};
+
+// Return true if the integral over [i1, i2) is NaN, or if a sign
+// check failed there.
+static bool
+nan_range_fails(const NanJob &j, uint64_t i1, uint64_t i2)
+{
+    complex_t result = {};
+    int r = j.fn(&result, j.lattice, i1, i2, j.genvec, j.shift, j.realp, j.complexp, j.deformp);
+    return r != 0 || isnan(result.re) || isnan(result.im);
+}
+
+static void
+nan_point_coordinates(const NanJob &j, uint64_t index, real_t *x)
+{
+    const real_t invlattice = 1.0/j.lattice;
+    for (uint64_t i = 0; i < j.dimension; i++) {
+        uint64_t li = (uint64_t)((unsigned __int128)j.genvec[i]*index % j.lattice);
+        x[i] = li*invlattice + j.shift[i];
+        if (x[i] >= 1) x[i] -= 1;
+    }
+}
+
+// Evaluate the integrand at the point "x"; return the sign check
+// code, and the raised floating point exceptions in "flags".
+static int
+nan_eval_point(const NanJob &j, const real_t *x, const real_t *deformp, complex_t &value, int &flags)
+{
+    static const uint64_t zero[MAXDIM] = {};
+    value = complex_t{0, 0};
+    feclearexcept(FE_ALL_EXCEPT);
+    int r = j.fn(&value, 1, 0, 1, zero, x, j.realp, j.complexp, deformp);
+    flags = fetestexcept(FE_OVERFLOW | FE_DIVBYZERO | FE_INVALID);
+    return r;
+}
+
+static bool
+nan_point_ok(const NanJob &j, const real_t *x, const real_t *deformp)
+{
+    complex_t value;
+    int flags;
+    int r = nan_eval_point(j, x, deformp, value, flags);
+    return r == 0 && isfinite(value.re) && isfinite(value.im);
+}
+
+static bool
+nan_repair(const NanJob &j, NanPoint &p)
+{
+    if (j.ndeformp == 0) return false;
+    real_t trial[MAXDIM] = {};
+    bool lower[MAXDIM] = {};
+    bool any = false;
+    for (uint64_t i = 0; i < j.ndeformp; i++) {
+        memcpy(trial, j.deformp, j.ndeformp*sizeof(real_t));
+        trial[i] = 0;
+        lower[i] = nan_point_ok(j, p.x, trial);
+        any = any || lower[i];
+    }
+    if (!any) {
+        for (uint64_t i = 0; i < j.ndeformp; i++) lower[i] = true;
+    }
+    real_t factor = 1;
+    for (int k = 0; k < 64; k++) {
+        factor *= 0.9;
+        for (uint64_t i = 0; i < j.ndeformp; i++)
+            trial[i] = lower[i] ? j.deformp[i]*factor : j.deformp[i];
+        if (nan_point_ok(j, p.x, trial)) {
+            memcpy(p.deformp, trial, j.ndeformp*sizeof(real_t));
+            return true;
+        }
+    }
+    return false;
+}
+
+// Find the first failing point of a job that was detected to fail
+// within [b1, b2); return false if the range is too large, or if
+// it does not fail on its own (e.g. if infinities from before it
+// are involved).
+static bool
+nan_locate(const NanJob &j, uint64_t b1, uint64_t b2, NanPoint &p)
+{
+    if (b2 - b1 > NAN_MAX_RANGE || !nan_range_fails(j, b1, b2)) return false;
+    // The kernels evaluate four points at once, starting from the
+    // first index, and a NaN in any of them spoils the sum; the
+    // ranges are split at multiples of four from b1, so that the
+    // same groups of points are evaluated.
+    uint64_t lo = b1, hi = b2;
+    while (hi - lo > 4) {
+        uint64_t mid = lo + (hi - lo + 4)/8*4;
+        if (nan_range_fails(j, lo, mid)) hi = mid;
+        else if (nan_range_fails(j, mid, hi)) lo = mid;
+        else break;
+    }
+    // Neither half fails on its own: find the shortest prefix of
+    // [lo, hi) that fails.
+    uint64_t start = lo;
+    while (hi - start > 4) {
+        uint64_t mid = start + (hi - start + 4)/8*4;
+        if (nan_range_fails(j, lo, mid)) hi = mid; else start = mid;
+    }
+    p = NanPoint{};
+    p.index = start;
+    p.cause = "unknown";
+    nan_point_coordinates(j, start, p.x);
+    for (uint64_t index = start; index < start + 4; index++) {
+        real_t x[MAXDIM] = {};
+        nan_point_coordinates(j, index, x);
+        complex_t value;
+        int flags;
+        int r = nan_eval_point(j, x, j.deformp, value, flags);
+        if (r == 0 && isfinite(value.re) && isfinite(value.im)) continue;
+        p.index = index;
+        memcpy(p.x, x, sizeof(x));
+        p.cause =
+            r == 1 ? "U" :
+            r == 2 ? "F" :
+            (flags & (FE_OVERFLOW | FE_DIVBYZERO)) ? "overflow" :
+            (flags & FE_INVALID) ? "domain" :
+            "unknown";
+        p.repaired = nan_repair(j, p);
+        break;
+    }
+    return true;
+}
+
+// Print the reply in one piece, so that the replies of several
+// threads do not mix.
+static void
+print_nan_point(uint64_t token, uint64_t di, double dt, const NanJob &j, const NanPoint &p)
+{
+    char buf[4096];
+    int n = snprintf(buf, sizeof(buf), "@[%" PRIu64 ",[[NaN,NaN],%" PRIu64 ",%.4e,[%" PRIu64 ",[", token, di, dt, p.index);
+    for (uint64_t i = 0; i < j.dimension; i++)
+        n += snprintf(buf + n, sizeof(buf) - n, i ? ",%.16e" : "%.16e", p.x[i]);
+    n += snprintf(buf + n, sizeof(buf) - n, "],\"%s\",", p.cause);
+    if (p.repaired) {
+        for (uint64_t i = 0; i < j.ndeformp; i++)
+            n += snprintf(buf + n, sizeof(buf) - n, i ? ",%.16e" : "[%.16e", p.deformp[i]);
+        n += snprintf(buf + n, sizeof(buf) - n, "]");
+    } else {
+        n += snprintf(buf + n, sizeof(buf) - n, "null");
+    }
+    snprintf(buf + n, sizeof(buf) - n, "]],null]\n");
+    fputs(buf, stdout);
+}
@@ -0,0 +1,242 @@
+/* This file implements file staging for the disteval workers:
+ * the coordinator can upload the family libraries and the data
+ * files over the RPC channel, so that workers do not need a
+ * shared filesystem with the integration package.
+ *
+ * Uploaded files are kept in a content-addressed cache on each
+ * node ($PYSECDEC_CACHE_DIR, $XDG_CACHE_HOME/pysecdec, or
+ * ~/.cache/pysecdec), named by their SHA-256 hash as computed
+ * by the coordinator, so that repeated runs transfer nothing.
+ * Each worker gets a private run directory in which the files
+ * are linked under their original names; it is removed when the
+ * worker exits.
+ *
+ * Commands:
+ * - ["rundir", []] -> [workername, kind, rundir, cachedir], where
+ *   "kind" is "cpu" or "cuda"
+ * - ["have", [hash]] -> true if the file is already cached
+ * - ["upload", [hash, offset, size, total, data]] appends one
+ *   chunk of "size" bytes, zlib-compressed and base64-encoded,
+ *   to the file; the file enters the cache once "total" bytes
+ *   have arrived.
+ * - ["link", [name, hash]] links the cached file as "name"
+ *   into the run directory.
+ */
+
+#include <sys/stat.h>
+#include <zlib.h>
+#include <string>
+
+static struct {
+    std::string cachedir;
+    std::string rundir;
+    std::vector<std::string> created; // links and directories in the run directory
+    FILE *part;
+    std::string partpath;
+    std::string parthash;
+    uint64_t partsize;
+} S;
+
+static void
+print_json_str(const char *s)
+{
+    putchar('"');
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') putchar('\\');
+        if ((unsigned char)*s < 0x20) { printf("\\u%04x", *s); continue; }
+        putchar(*s);
+    }
+    putchar('"');
+}
+
+static bool
+stage_mkdirs(const std::string &path)
+{
+    for (size_t i = 1; i <= path.size(); i++) {
+        if (i == path.size() || path[i] == '/') {
+            std::string dir = path.substr(0, i);
+            if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) return false;
+        }
+    }
+    return true;
+}
+
+static bool
+stage_valid_hash(const char *hash)
+{
+    size_t n = 0;
+    for (; hash[n]; n++) {
+        if (!(('0' <= hash[n] && hash[n] <= '9') || ('a' <= hash[n] && hash[n] <= 'f'))) return false;
+    }
+    return n == 64;
+}
+
+// Relative paths only, and without ".." components.
+static bool
+stage_valid_name(const char *name)
+{
+    if (name[0] == 0 || name[0] == '/') return false;
+    for (const char *p = name; *p; ) {
+        const char *e = strchr(p, '/');
+        size_t n = e ? (size_t)(e - p) : strlen(p);
+        if (n == 0 || (n == 2 && p[0] == '.' && p[1] == '.')) return false;
+        p += n + (e ? 1 : 0);
+    }
+    return true;
+}
+
+static void
+cmd_rundir(uint64_t token, const char *workername, const char *kind)
+{
+    const char *dir = getenv("PYSECDEC_CACHE_DIR");
+    if (dir != NULL && dir[0] != 0) {
+        S.cachedir = dir;
+    } else if ((dir = getenv("XDG_CACHE_HOME")) != NULL && dir[0] != 0) {
+        S.cachedir = std::string(dir) + "/pysecdec";
+    } else if ((dir = getenv("HOME")) != NULL && dir[0] != 0) {
+        S.cachedir = std::string(dir) + "/.cache/pysecdec";
+    } else {
+        S.cachedir = "/tmp/pysecdec-cache-" + std::to_string(getuid());
+    }
+    S.cachedir += "/disteval";
+    std::string name = workername;
+    for (char &ch : name) if (ch == ':' || ch == '/') ch = '_';
+    S.rundir = S.cachedir + "/run/" + name + "-" + kind;
+    if (!stage_mkdirs(S.rundir)) {
+        printf("@[%" PRIu64 ",null,\"failed to create '%s': %s\"]\n", token, S.rundir.c_str(), strerror(errno));
+        S.rundir.clear();
+        return;
+    }
+    printf("@[%" PRIu64 ",[", token);
+    print_json_str(workername);
+    putchar(',');
+    print_json_str(kind);
+    putchar(',');
+    print_json_str(S.rundir.c_str());
+    putchar(',');
+    print_json_str(S.cachedir.c_str());
+    printf("],null]\n");
+}
+
+static void
+cmd_have(uint64_t token, const char *hash)
+{
+    if (S.cachedir.empty() || !stage_valid_hash(hash)) {
+        printf("@[%" PRIu64 ",null,\"bad staging request for '%s'\"]\n", token, hash);
+        return;
+    }
+    struct stat st;
+    bool have = stat((S.cachedir + "/" + hash).c_str(), &st) == 0;
+    printf("@[%" PRIu64 ",%s,null]\n", token, have ? "true" : "false");
+}
+
+static size_t
+base64_decode(const char *src, size_t n, unsigned char *dst)
+{
+    static signed char table[256];
+    if (table['B'] == 0) {
+        for (int i = 0; i < 256; i++) table[i] = -1;
+        const char *alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        for (int i = 0; i < 64; i++) table[(unsigned char)alphabet[i]] = i;
+    }
+    size_t len = 0;
+    uint32_t acc = 0;
+    int bits = 0;
+    for (size_t i = 0; i < n; i++) {
+        int v = table[(unsigned char)src[i]];
+        if (v < 0) continue; // padding
+        acc = (acc << 6) | v;
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            dst[len++] = (acc >> bits) & 0xFF;
+        }
+    }
+    return len;
+}
+
+static void
+cmd_upload(uint64_t token, const char *hash, uint64_t offset, uint64_t size, uint64_t total, const char *data, size_t datalen)
+{
+    if (S.cachedir.empty() || !stage_valid_hash(hash)) {
+        printf("@[%" PRIu64 ",null,\"bad staging request for '%s'\"]\n", token, hash);
+        return;
+    }
+    if (offset == 0) {
+        if (S.part != NULL) { fclose(S.part); unlink(S.partpath.c_str()); }
+        S.parthash = hash;
+        S.partpath = S.cachedir + "/" + hash + ".part-" + std::to_string(getpid());
+        S.part = fopen(S.partpath.c_str(), "wb");
+        S.partsize = 0;
+        if (S.part == NULL) {
+            printf("@[%" PRIu64 ",null,\"failed to create '%s': %s\"]\n", token, S.partpath.c_str(), strerror(errno));
+            return;
+        }
+    }
+    if (S.part == NULL || S.parthash != hash || S.partsize != offset) {
+        printf("@[%" PRIu64 ",null,\"unexpected chunk at %" PRIu64 " of '%s'\"]\n", token, offset, hash);
+        return;
+    }
+    std::vector<unsigned char> packed(datalen*3/4 + 3);
+    packed.resize(base64_decode(data, datalen, packed.data()));
+    std::vector<unsigned char> raw(size > 0 ? size : 1);
+    uLongf rawlen = size;
+    int r = uncompress(raw.data(), &rawlen, packed.data(), packed.size());
+    if (r != Z_OK || rawlen != size) {
+        printf("@[%" PRIu64 ",null,\"corrupt chunk at %" PRIu64 " of '%s': zlib error %d\"]\n", token, offset, hash, r);
+        return;
+    }
+    if (fwrite(raw.data(), 1, size, S.part) != size) {
+        printf("@[%" PRIu64 ",null,\"failed to write '%s': %s\"]\n", token, S.partpath.c_str(), strerror(errno));
+        return;
+    }
+    S.partsize += size;
+    if (S.partsize >= total) {
+        bool ok = fclose(S.part) == 0;
+        S.part = NULL;
+        // The rename is atomic, so concurrent workers on this node never see partial files.
+        if (!ok || rename(S.partpath.c_str(), (S.cachedir + "/" + hash).c_str()) != 0) {
+            printf("@[%" PRIu64 ",null,\"failed to store '%s': %s\"]\n", token, S.partpath.c_str(), strerror(errno));
+            unlink(S.partpath.c_str());
+            return;
+        }
+    }
+    printf("@[%" PRIu64 ",null,null]\n", token);
+}
+
+static void
+cmd_link(uint64_t token, const char *name, const char *hash)
+{
+    if (S.rundir.empty() || !stage_valid_hash(hash) || !stage_valid_name(name)) {
+        printf("@[%" PRIu64 ",null,\"bad staging request for '%s'\"]\n", token, name);
+        return;
+    }
+    std::string path = S.rundir + "/" + name;
+    for (size_t i = S.rundir.size() + 1; i < path.size(); i++) {
+        if (path[i] != '/') continue;
+        std::string dir = path.substr(0, i);
+        if (mkdir(dir.c_str(), 0755) == 0) {
+            S.created.push_back(dir);
+        } else if (errno != EEXIST) {
+            printf("@[%" PRIu64 ",null,\"failed to create '%s': %s\"]\n", token, dir.c_str(), strerror(errno));
+            return;
+        }
+    }
+    unlink(path.c_str());
+    if (symlink((S.cachedir + "/" + hash).c_str(), path.c_str()) != 0) {
+        printf("@[%" PRIu64 ",null,\"failed to link '%s': %s\"]\n", token, path.c_str(), strerror(errno));
+        return;
+    }
+    S.created.push_back(path);
+    printf("@[%" PRIu64 ",null,null]\n", token);
+}
+
+static void
+stage_cleanup()
+{
+    if (S.part != NULL) { fclose(S.part); unlink(S.partpath.c_str()); }
+    for (auto it = S.created.rbegin(); it != S.created.rend(); ++it) {
+        if (unlink(it->c_str()) != 0) rmdir(it->c_str());
+    }
+    if (!S.rundir.empty()) rmdir(S.rundir.c_str());
+}
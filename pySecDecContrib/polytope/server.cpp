@@ -0,0 +1,165 @@
+/* This is a long-lived polytope engine around libnormaliz: it
+ * reads batches of requests from stdin and answers each of them
+ * on stdout, in the order of the requests, so that one process
+ * can serve all the convex hull and triangulation calls of a
+ * decomposition without spawning normaliz for each of them and
+ * without going through the filesystem.
+ *
+ * A request is a header line followed by the rows of an integer
+ * matrix:
+ *
+ *     <command> <input-type> <rows> <columns>
+ *     <row 1>
+ *     ...
+ *
+ * Commands:
+ * - "triangulate", with input type "cone" or "inequalities",
+ *   computes the triangulation (like "normaliz -T") and replies
+ *   with the generators of the triangulation (the ".tgn" file)
+ *   and the simplicial cones as zero-based row indices into it
+ *   (the ".tri" file, without the determinants).
+ * - "convert", with input type "polytope" or "inequalities",
+ *   computes the support hyperplanes (like "normaliz -s") and
+ *   replies with the extreme rays (the ".ext" file), the support
+ *   hyperplanes and the equations (the ".cst" file).
+ *
+ * A reply is either
+ *
+ *     ok <number of matrices>
+ *     <rows> <columns>
+ *     <row 1>
+ *     ...
+ *
+ * with the matrices in the normaliz file format, or
+ *
+ *     error <message>
+ *
+ * The engine exits at the end of the input.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <libnormaliz/libnormaliz.h>
+
+using namespace libnormaliz;
+
+typedef Matrix<mpz_class> IntMatrix;
+
+static void
+print_matrix(std::ostream &out, const IntMatrix &m)
+{
+    out << m.nr_of_rows() << '\n' << m.nr_of_columns() << '\n';
+    for (size_t i = 0; i < m.nr_of_rows(); i++) {
+        for (size_t j = 0; j < m.nr_of_columns(); j++) {
+            out << m[i][j] << ' ';
+        }
+        out << '\n';
+    }
+}
+
+static void
+cmd_triangulate(std::ostream &out, Cone<mpz_class> &cone)
+{
+    cone.compute(ConeProperty::Triangulation);
+    const auto &tri = cone.getTriangulation();
+    if (tri.first.empty()) {
+        out << "ok 2\n";
+        print_matrix(out, IntMatrix(0, 0));
+        print_matrix(out, IntMatrix(0, 0));
+        return;
+    }
+    size_t n = tri.first[0].key.size();
+    IntMatrix simplices(tri.first.size(), n);
+    for (size_t i = 0; i < tri.first.size(); i++) {
+        for (size_t j = 0; j < n; j++) {
+            simplices[i][j] = tri.first[i].key[j];
+        }
+    }
+    out << "ok 2\n";
+    print_matrix(out, tri.second);
+    print_matrix(out, simplices);
+}
+
+static void
+cmd_convert(std::ostream &out, Cone<mpz_class> &cone)
+{
+    cone.compute(ConeProperty::SupportHyperplanes);
+    // The same rays the command line program writes into the ".ext" file.
+    IntMatrix rays(0, cone.getEmbeddingDim());
+    if (cone.isComputed(ConeProperty::VerticesOfPolyhedron)) {
+        rays = cone.getVerticesOfPolyhedronMatrix();
+    }
+    rays.append(cone.getExtremeRaysMatrix());
+    out << "ok 3\n";
+    print_matrix(out, rays);
+    print_matrix(out, cone.getSupportHyperplanesMatrix());
+    print_matrix(out, cone.getSublattice().getEquationsMatrix());
+}
+
+// Read one request and write its reply into "out", return
+// false at the end of the input.
+static bool
+serve_request(std::istream &in, std::ostream &out)
+{
+    std::string command, type;
+    long nrows = 0, ncols = 0;
+    if (!(in >> command >> type >> nrows >> ncols)) return false;
+    if (nrows < 0 || ncols < 0) {
+        out << "error bad matrix size " << nrows << "x" << ncols << '\n';
+        return true;
+    }
+    std::vector<std::vector<mpq_class>> rows(nrows, std::vector<mpq_class>(ncols));
+    for (auto &row : rows) {
+        for (auto &x : row) {
+            mpz_class z;
+            if (!(in >> z)) {
+                out << "error truncated matrix\n";
+                return false;
+            }
+            x = z;
+        }
+    }
+    try {
+        std::map<InputType, std::vector<std::vector<mpq_class>>> input;
+        input[to_type(type)] = rows;
+        Cone<mpz_class> cone(input);
+        cone.setVerbose(false);
+        if (command == "triangulate" && (type == "cone" || type == "inequalities")) {
+            cmd_triangulate(out, cone);
+        } else if (command == "convert" && (type == "polytope" || type == "inequalities")) {
+            cmd_convert(out, cone);
+        } else {
+            out << "error unknown request '" << command << " " << type << "'\n";
+        }
+    } catch (const std::exception &e) {
+        std::string message = e.what();
+        for (char &c : message) if (c == '\n') c = ' ';
+        out << "error " << message << '\n';
+    }
+    return true;
+}
+
+int main()
+{
+    std::ios::sync_with_stdio(false);
+    setVerboseDefault(false);
+    for (;;) {
+        // Compute the reply before writing any of it, so that
+        // a failing request can not leave a partial reply behind.
+        std::ostringstream reply;
+        bool more = serve_request(std::cin, reply);
+        std::cout << reply.str();
+        // Flush when the batch is exhausted, so that the client
+        // can read the replies while it prepares the next batch.
+        if (!more || std::cin.rdbuf()->in_avail() <= 0) std::cout.flush();
+        if (!more) break;
+    }
+    return 0;
+}
@@ -7,17 +7,26 @@
 #include <iostream> // std::cerr, std::dec
 #include <iomanip> // std::fixed, std::setprecision
 #include <limits> // std::numeric_limits
+#include <map> // std::map
+#include <set> // std::set
 #include <memory> // std::shared_ptr
 #include <string> // std::to_string
 #include <stdexcept> // std::domain_error, std::logic_error, std::runtime_error
 #include <thread> // std::thread
+#include <type_traits> // std::false_type, std::true_type
 #include <utility> // std::declval, std::move
 #include <vector> // std::vector
 #include <fstream> // for writing changed deformation parameters to file
 #include <sstream> // std::ostringstream 
 #include <cstdio> // std::remove 
 #include <unistd.h> // mkdtemp
-#include <cstring> // strcpy
+#include <cstring> // strcpy, std::strerror
+#include <cerrno> // errno
+#include <complex> // std::complex
+#include <deque> // std::deque
+#include <fcntl.h> // fcntl
+#include <poll.h> // poll
+#include <sys/wait.h> // waitpid
 
 #include <secdecutil/deep_apply.hpp> // secdecutil::deep_apply
 #include <secdecutil/uncertainties.hpp> // secdecutil::UncorrelatedDeviation
@@ -47,6 +56,32 @@ namespace secdecutil {
             };
         #endif
     
+        /*
+         * Whether an integrand can be evaluated on the host, i.e. whether it is an
+         * "IntegrandContainer"; see "Integral::evaluate_integrand".
+         */
+        template<typename integrand_t> struct is_host_integrand : std::false_type {};
+        template<typename T, typename Args, typename Pars, typename Pars_extra>
+        struct is_host_integrand<secdecutil::IntegrandContainer<T,Args,Pars,Pars_extra>> : std::true_type {};
+
+        template<typename integrand_t>
+        int host_integrand_number_of_integration_variables(const integrand_t& integrand)
+        {
+            if constexpr (is_host_integrand<integrand_t>::value)
+                return integrand.number_of_integration_variables;
+            else
+                return -1;
+        };
+
+        template<typename integrand_return_t, typename real_t, typename integrand_t>
+        integrand_return_t evaluate_host_integrand(const integrand_t& integrand, real_t const * const x, secdecutil::ResultInfo* result_info)
+        {
+            if constexpr (is_host_integrand<integrand_t>::value)
+                return integrand_return_t(integrand(x, result_info));
+            else
+                throw std::logic_error("evaluate_host_integrand: the integrand can not be evaluated on the host.");
+        };
+
         template<typename integrand_return_t, typename real_t>
         class Integral
         {
@@ -54,6 +89,7 @@ namespace secdecutil {
 
                 secdecutil::UncorrelatedDeviation<integrand_return_t> integral_result;
                 real_t integration_time;
+                real_t excluded_time = 0; // time spent in "compute_impl" that does not count as "integration_time", e.g. for pilot runs
 
             private:
 
@@ -89,6 +125,17 @@ namespace secdecutil {
                         next_number_of_function_evaluations = std::max({next_number_of_function_evaluations, new_number_of_function_evaluations, number_of_function_evaluations});
                 };
 
+                /*
+                 * Take over a result computed elsewhere, e.g. by a remote worker (see "IntegralExecutor").
+                 */
+                void store_result(const secdecutil::UncorrelatedDeviation<integrand_return_t>& result, unsigned long long int new_number_of_function_evaluations, real_t time)
+                {
+                    integral_result = result;
+                    number_of_function_evaluations = new_number_of_function_evaluations;
+                    next_number_of_function_evaluations = std::max(next_number_of_function_evaluations, new_number_of_function_evaluations);
+                    integration_time = time;
+                };
+
                 /*
                  * getter functions
                  */
@@ -111,6 +158,17 @@ namespace secdecutil {
                 virtual std::vector<std::vector<real_t>> get_extra_parameters() = 0;
                 virtual void clear_errors() = 0;
 
+                /*
+                 * Evaluate the integrand at a point, e.g. to sum it with the integrands of other
+                 * integrals (see "combine_integrals"). The number of integration variables is -1
+                 * if the integrand can not be evaluated on the host.
+                 */
+                virtual int get_number_of_integration_variables() const { return -1; };
+                virtual integrand_return_t evaluate_integrand(real_t const * const x, secdecutil::ResultInfo* result_info) const
+                {
+                    throw std::logic_error("class Integral: evaluate_integrand called for " + display_name + ", whose integrand can not be evaluated on the host.");
+                };
+
                 /*
                  * Functions to compute the integral with the given "number_of_function_evaluations".
                  */
@@ -122,7 +180,8 @@ namespace secdecutil {
                         compute_impl(verbose);
                         auto end_time = std::chrono::steady_clock::now();
                         number_of_function_evaluations = next_number_of_function_evaluations;
-                        integration_time = std::chrono::duration<real_t>(end_time - start_time).count();
+                        integration_time = std::chrono::duration<real_t>(end_time - start_time).count() - excluded_time;
+                        excluded_time = 0;
                     }
                 };
         };
@@ -139,6 +198,8 @@ namespace secdecutil {
             std::vector<std::vector<real_t*>> get_parameters() override {return integrand.get_parameters();}
             std::vector<std::vector<real_t>> get_extra_parameters() override {return integrand.get_extra_parameters();}
             void clear_errors() override {integrand.clear_errors();}
+            int get_number_of_integration_variables() const override {return host_integrand_number_of_integration_variables(integrand);}
+            integrand_return_t evaluate_integrand(real_t const * const x, secdecutil::ResultInfo* result_info) const override {return evaluate_host_integrand<integrand_return_t>(integrand, x, result_info);}
 
             /*
              * constructor
@@ -194,6 +255,8 @@ namespace secdecutil {
             std::vector<std::vector<real_t*>> get_parameters() override {return integrand.get_parameters();}
             std::vector<std::vector<real_t>> get_extra_parameters() override {return integrand.get_extra_parameters();}
             void clear_errors() override {integrand.clear_errors();}
+            int get_number_of_integration_variables() const override {return host_integrand_number_of_integration_variables(integrand);}
+            integrand_return_t evaluate_integrand(real_t const * const x, secdecutil::ResultInfo* result_info) const override {return evaluate_host_integrand<integrand_return_t>(integrand, x, result_info);}
 
             /*
              * constructor
@@ -264,6 +327,8 @@ namespace secdecutil {
             std::vector<std::vector<real_t*>> get_parameters() override {return integrand.get_parameters();}
             std::vector<std::vector<real_t>> get_extra_parameters() override {return integrand.get_extra_parameters();}
             void clear_errors() override {integrand.clear_errors();}
+            int get_number_of_integration_variables() const override {return host_integrand_number_of_integration_variables(integrand);}
+            integrand_return_t evaluate_integrand(real_t const * const x, secdecutil::ResultInfo* result_info) const override {return evaluate_host_integrand<integrand_return_t>(integrand, x, result_info);}
 
             /*
              * constructor
@@ -297,6 +362,8 @@ namespace secdecutil {
             std::vector<std::vector<real_t*>> get_parameters() override {return integrand.get_parameters();}
             std::vector<std::vector<real_t>> get_extra_parameters() override {return integrand.get_extra_parameters();}
             void clear_errors() override {integrand.clear_errors();}
+            int get_number_of_integration_variables() const override {return host_integrand_number_of_integration_variables(integrand);}
+            integrand_return_t evaluate_integrand(real_t const * const x, secdecutil::ResultInfo* result_info) const override {return evaluate_host_integrand<integrand_return_t>(integrand, x, result_info);}
 
             /*
              * constructor
@@ -318,6 +385,147 @@ namespace secdecutil {
             }
         };
     
+        /*
+         * Integral that selects one of several candidate integrals of the same integrand, e.g. a
+         * "QmcIntegral" per periodizing transform (see "secdecutil::integrators::QmcTransformSelection").
+         * The first computation runs every candidate and keeps the one with the smallest error times
+         * time, later refinements only run the selected candidate.
+         */
+        template<typename integrand_return_t, typename real_t>
+        struct TransformSelectingIntegral : public Integral<integrand_return_t,real_t>
+        {
+            std::vector<std::shared_ptr<Integral<integrand_return_t,real_t>>> candidates;
+            std::vector<std::string> names;
+            size_t selected;
+            bool is_selected;
+
+            real_t get_scaleexpo() const override { return candidates.at(selected)->get_scaleexpo(); }
+
+            std::vector<std::vector<real_t*>> get_parameters() override
+            {
+                if(is_selected)
+                    return candidates.at(selected)->get_parameters();
+                std::vector<std::vector<real_t*>> parameters;
+                for(auto& candidate : candidates)
+                    for(auto& p : candidate->get_parameters())
+                        parameters.push_back(p);
+                return parameters;
+            }
+            std::vector<std::vector<real_t>> get_extra_parameters() override
+            {
+                if(is_selected)
+                    return candidates.at(selected)->get_extra_parameters();
+                std::vector<std::vector<real_t>> parameters;
+                for(auto& candidate : candidates)
+                    for(auto& p : candidate->get_extra_parameters())
+                        parameters.push_back(p);
+                return parameters;
+            }
+            void clear_errors() override
+            {
+                for(auto& candidate : candidates)
+                    candidate->clear_errors();
+            }
+
+            /*
+             * constructor
+             */
+            TransformSelectingIntegral(const std::vector<std::shared_ptr<Integral<integrand_return_t,real_t>>>& candidates, const std::vector<std::string>& names) :
+                Integral<integrand_return_t,real_t>(candidates.at(0)->get_next_number_of_function_evaluations()),
+                candidates(candidates), names(names), selected(0), is_selected(false)
+            {
+                this->display_name = candidates.at(0)->display_name;
+            };
+
+            void compute_impl(const bool verbose) override
+            {
+                unsigned long long int next_n = this->get_next_number_of_function_evaluations();
+                if(not is_selected)
+                {
+                    std::vector<real_t> errors, times;
+                    for(auto& candidate : candidates)
+                    {
+                        candidate->set_next_number_of_function_evaluations(next_n);
+                        candidate->compute(verbose);
+                        errors.push_back(secdecutil::integrators::subdivision::error_size(candidate->get_integral_result().uncertainty));
+                        times.push_back(candidate->get_integration_time());
+                    }
+                    selected = secdecutil::integrators::transform_selection::select(errors, times);
+                    is_selected = true;
+                    for(size_t i = 0; i < candidates.size(); ++i)
+                        if(i != selected)
+                            this->excluded_time += times.at(i);
+                    if(verbose)
+                        std::cerr << "integral " << this->display_name << ": selected transform " << names.at(selected) << std::endl;
+                }
+                else
+                {
+                    candidates.at(selected)->set_next_number_of_function_evaluations(next_n);
+                    candidates.at(selected)->compute(verbose);
+                }
+                const std::shared_ptr<Integral<integrand_return_t,real_t>>& best = candidates.at(selected);
+                this->integral_result = best->get_integral_result();
+                this->allow_refine = best->allow_refine;
+                this->set_next_number_of_function_evaluations(best->get_number_of_function_evaluations(), true);
+            }
+        };
+
+        /*
+         * Integral of the weighted sum of the integrands of several "parts" with the same number of
+         * integration variables (see "combine_integrals"). The "integral" integrates the summed
+         * integrand; the "parts" own the integrands and their deformation parameters.
+         */
+        template<typename integrand_return_t, typename real_t>
+        struct CombinedIntegral : public Integral<integrand_return_t,real_t>
+        {
+            std::shared_ptr<Integral<integrand_return_t,real_t>> integral;
+            std::vector<std::shared_ptr<Integral<integrand_return_t,real_t>>> parts;
+
+            real_t get_scaleexpo() const override { return integral->get_scaleexpo(); }
+
+            std::vector<std::vector<real_t*>> get_parameters() override
+            {
+                std::vector<std::vector<real_t*>> parameters;
+                for(auto& part : parts)
+                    for(auto& p : part->get_parameters())
+                        parameters.push_back(p);
+                return parameters;
+            }
+            std::vector<std::vector<real_t>> get_extra_parameters() override
+            {
+                std::vector<std::vector<real_t>> parameters;
+                for(auto& part : parts)
+                    for(auto& p : part->get_extra_parameters())
+                        parameters.push_back(p);
+                return parameters;
+            }
+            void clear_errors() override
+            {
+                integral->clear_errors();
+                for(auto& part : parts)
+                    part->clear_errors();
+            }
+
+            /*
+             * constructor
+             */
+            CombinedIntegral(const std::shared_ptr<Integral<integrand_return_t,real_t>>& integral, const std::vector<std::shared_ptr<Integral<integrand_return_t,real_t>>>& parts) :
+                Integral<integrand_return_t,real_t>(integral->get_next_number_of_function_evaluations()),
+                integral(integral), parts(parts)
+            {
+                this->display_name = integral->display_name;
+            };
+
+            void compute_impl(const bool verbose) override
+            {
+                integral->set_next_number_of_function_evaluations(this->get_next_number_of_function_evaluations());
+                integral->compute(verbose);
+                this->integral_result = integral->get_integral_result();
+                this->allow_refine = integral->allow_refine;
+                this->set_next_number_of_function_evaluations(integral->get_number_of_function_evaluations(), true);
+            }
+        };
+
         template<typename integral_t, typename coefficient_t>
         struct WeightedIntegral
         {
@@ -456,6 +664,126 @@ namespace secdecutil {
             return a;
         };
 
+        /*
+         * Combine amplitudes that were built once per candidate integrator (in the order of "names")
+         * into amplitudes of "TransformSelectingIntegral"s. The amplitudes must only differ in their
+         * integrals; integrals shared between several terms stay shared.
+         */
+        template<typename sum_t, typename amplitudes_t>
+        amplitudes_t make_transform_selecting_amplitudes(std::vector<amplitudes_t>& candidates, const std::vector<std::string>& names)
+        {
+            using weighted_integral_t = typename sum_t::value_type;
+            using integral_t = typename std::remove_reference<decltype(*std::declval<weighted_integral_t>().integral)>::type;
+            using integrand_return_t = typename std::remove_reference<decltype(std::declval<integral_t>().get_integral_result().value)>::type;
+            using real_t = typename integral_t::real_t_type;
+
+            // integrals of every candidate in the order of the terms
+            std::vector<std::vector<std::shared_ptr<integral_t>>> integrals(candidates.size());
+            for(size_t c = 0; c < candidates.size(); ++c)
+            {
+                std::function<sum_t(sum_t&)> collect =
+                    [&integrals, c] (sum_t& sum)
+                    {
+                        for(auto& term : sum)
+                            integrals.at(c).push_back(term.integral);
+                        return sum;
+                    };
+                secdecutil::deep_apply(candidates.at(c), collect);
+            }
+            for(auto& candidate_integrals : integrals)
+                if(candidate_integrals.size() != integrals.at(0).size())
+                    throw std::invalid_argument("make_transform_selecting_amplitudes: the candidate amplitudes differ in their terms.");
+
+            std::map<integral_t*,std::shared_ptr<integral_t>> selecting_integrals;
+            size_t position = 0;
+            std::function<sum_t(sum_t&)> replace =
+                [&] (sum_t& sum)
+                {
+                    sum_t new_sum = sum;
+                    for(auto& term : new_sum)
+                    {
+                        std::shared_ptr<integral_t>& selecting_integral = selecting_integrals[term.integral.get()];
+                        if(not selecting_integral)
+                        {
+                            std::vector<std::shared_ptr<integral_t>> candidate_integrals;
+                            for(auto& c : integrals)
+                                candidate_integrals.push_back(c.at(position));
+                            selecting_integral = std::make_shared<TransformSelectingIntegral<integrand_return_t,real_t>>(candidate_integrals, names);
+                        }
+                        term.integral = selecting_integral;
+                        ++position;
+                    }
+                    return new_sum;
+                };
+            return secdecutil::deep_apply(candidates.at(0), replace);
+        };
+
+        /*
+         * Replace the terms of every sum whose integrands can be evaluated on the host (see
+         * "Integral::evaluate_integrand") by one "CombinedIntegral" per number of integration
+         * variables, which integrates the weighted sum of their integrands in a single run.
+         * Cancellations between the terms, e.g. of spurious poles between the regions of an
+         * expansion by regions, then happen point by point rather than between the results.
+         * "make_integral(number_of_integration_variables, integrand)" constructs the integral of
+         * the summed integrand. Terms without a partner of the same dimension are kept as they are.
+         */
+        template<typename sum_t, typename amplitudes_t, typename make_integral_t>
+        amplitudes_t combine_integrals(amplitudes_t& amplitudes, const make_integral_t& make_integral)
+        {
+            using weighted_integral_t = typename sum_t::value_type;
+            using integral_t = typename std::remove_reference<decltype(*std::declval<weighted_integral_t>().integral)>::type;
+            using integrand_return_t = typename std::remove_reference<decltype(std::declval<integral_t>().get_integral_result().value)>::type;
+            using real_t = typename integral_t::real_t_type;
+
+            size_t number_of_combined_integrals = 0;
+            std::function<sum_t(sum_t&)> combine =
+                [&] (sum_t& sum)
+                {
+                    std::map<int,sum_t> terms_by_dimension;
+                    for(auto& term : sum)
+                    {
+                        int dimension = term.integral->get_number_of_integration_variables();
+                        if(dimension >= 0)
+                            terms_by_dimension[dimension].push_back(term);
+                    }
+                    // keep the order of the terms, a combined integral takes the place of its first part
+                    sum_t new_sum;
+                    for(auto& term : sum)
+                    {
+                        int dimension = term.integral->get_number_of_integration_variables();
+                        if(dimension < 0 or terms_by_dimension.at(dimension).size() == 1)
+                        {
+                            new_sum.push_back(term);
+                            continue;
+                        }
+                        const sum_t& terms = terms_by_dimension.at(dimension);
+                        if(term.integral != terms.at(0).integral)
+                            continue;
+                        std::vector<std::shared_ptr<integral_t>> parts;
+                        std::vector<integrand_return_t> coefficients;
+                        for(auto& part : terms)
+                        {
+                            parts.push_back(part.integral);
+                            coefficients.push_back(part.coefficient);
+                        }
+                        std::function<integrand_return_t(real_t const * const, secdecutil::ResultInfo*)> integrand =
+                            [parts, coefficients] (real_t const * const x, secdecutil::ResultInfo* result_info)
+                            {
+                                integrand_return_t result = 0;
+                                for(size_t i = 0; i < parts.size(); ++i)
+                                    result += coefficients[i] * parts[i]->evaluate_integrand(x, result_info);
+                                return result;
+                            };
+                        std::shared_ptr<integral_t> integral = make_integral(dimension, integrand);
+                        integral->display_name = "combined" + std::to_string(number_of_combined_integrals++) +
+                            "_" + std::to_string(parts.size()) + "x" + std::to_string(dimension) + "d";
+                        new_sum.push_back(weighted_integral_t(std::make_shared<CombinedIntegral<integrand_return_t,real_t>>(integral, parts)));
+                    }
+                    return new_sum;
+                };
+            return secdecutil::deep_apply(amplitudes, combine);
+        };
+
         static inline void write_map_to_file(std::map<std::string, std::vector<std::vector<double>>> map, std::string filename="changed_deformation_parameters.txt"){
             std::ofstream file;
             file.open(filename);
@@ -509,6 +837,65 @@ namespace secdecutil {
             std::cerr << prefix << std::ctime(&t);
         }
 
+        /*
+         * compute an integral, lowering its deformation parameters
+         * until the sign check passes; return whether they were lowered
+         */
+        template<typename integral_t>
+        bool compute_lowering_deformation(integral_t* integral, const bool verbose)
+        {
+            using real_t = typename integral_t::real_t_type;
+            bool failed_atleast_once = false;
+            while(true){
+                try{
+                    integral->compute(verbose);
+                    return failed_atleast_once;
+                } catch(secdecutil::sign_check_error& e){
+                    std::cerr << "Exception: " << e.what() << std::endl;
+                    integral->clear_errors();
+
+                    std::cerr << "Integral " << integral->display_name << " failed, reducing deformation parameters." << std::endl;
+                    std::vector<std::vector<real_t*>> pars = integral->get_parameters();
+                    std::vector<std::vector<real_t>> extra_pars = integral->get_extra_parameters();
+                    failed_atleast_once = true;
+                    bool changed_deformation_parameters = false;
+                    for(int k = 0; k < pars.size(); k++){
+                        for(int i = 0; i < pars[k].size(); i++){
+                            std::cerr << "par " << k << "," << i << ": " << *pars[k][i];
+                            if(*pars[k][i] > extra_pars[k][0]){
+                                *pars[k][i] *= extra_pars[k][1];
+                                if(*pars[k][i] < extra_pars[k][0]){
+                                    *pars[k][i] = extra_pars[k][0];
+                                }
+                                changed_deformation_parameters = true;
+                                std::cerr << " -> " << *pars[k][i];
+                            }
+                            if(i == pars[k].size()-1 and k == pars.size()-1)
+                                std::cerr << std::endl;
+                            else
+                                std::cerr << ", ";
+                        }
+                    }
+                    if(not changed_deformation_parameters){
+                        throw std::runtime_error("All deformation parameters at minimum already, integral still fails.");
+                    }
+                }
+            }
+        }
+
+        template<typename integrand_return_t, typename integral_t>
+        void print_integral_progress(integral_t* integral, size_t number_of_integrals, const secdecutil::UncorrelatedDeviation<integrand_return_t>& old_result, unsigned long long int old_n)
+        {
+            std::cerr << "integral " << integral->id << "/" << number_of_integrals << ": " << integral->display_name << ", time: ";
+            auto flags = std::cerr.flags();
+            std::cerr << std::fixed << std::setprecision(6) << integral->get_integration_time() << "s, ";
+            std::cerr.flags(flags);
+            print_datetime();
+            std::cerr << "res: " << old_result << " -> " << integral->get_integral_result()
+                          << ", n: " << old_n << " -> " << std::dec << integral->get_number_of_function_evaluations() << std::endl;
+            std::cerr << std::endl;
+        }
+
         /*
          * evaluate a vector of integrals
          */
@@ -529,69 +916,20 @@ namespace secdecutil {
                             old_result = integral->get_integral_result();
                         } catch (const integral_not_computed_error&) { /* ignore */ };
 
-                    bool failed_atleast_once = false;
-                    while(true){
-                        bool failed = false;
-                        try{
-                            integral->compute(verbose);
-                        } catch(secdecutil::sign_check_error& e){
-                            failed = true;
-                            std::cerr << "Exception: " << e.what() << std::endl;
-                            integral->clear_errors();
-
-                            std::cerr << "Integral " << integral->display_name << " failed, reducing deformation parameters." << std::endl;
-                            std::vector<std::vector<typename std::remove_pointer<decltype(integral)>::type::real_t_type*>> pars = integral->get_parameters();
-                            std::vector<std::vector<typename std::remove_pointer<decltype(integral)>::type::real_t_type>> extra_pars = integral->get_extra_parameters();
-                            failed_atleast_once = true;
-                            bool changed_deformation_parameters = false;
-                            for(int k = 0; k < pars.size(); k++){
-                                for(int i = 0; i < pars[k].size(); i++){
-                                    std::cerr << "par " << k << "," << i << ": " << *pars[k][i];
-                                    if(*pars[k][i] > extra_pars[k][0]){
-                                        *pars[k][i] *= extra_pars[k][1];
-                                        if(*pars[k][i] < extra_pars[k][0]){
-                                            *pars[k][i] = extra_pars[k][0];
-                                        }
-                                        changed_deformation_parameters = true;
-                                        std::cerr << " -> " << *pars[k][i];
-                                    }
-                                    if(i == pars[k].size()-1 and k == pars.size()-1)
-                                        std::cerr << std::endl;
-                                    else
-                                        std::cerr << ", ";
-                                }
+                    if(compute_lowering_deformation(integral, verbose)){
+                        std::vector<std::vector<typename integral_t::real_t_type*>> pars = integral->get_parameters();
+                        std::vector<std::vector<typename integral_t::real_t_type>> pars_data(pars.size());
+                        for(int i = 0; i < pars.size(); i++){
+                            for(auto par:pars[i]){
+                                pars_data[i].push_back(*par);
                             }
-                            if(not changed_deformation_parameters){
-                                throw std::runtime_error("All deformation parameters at minimum already, integral still fails.");
-                            }
-                        }
-                        if(not failed){
-                            if(failed_atleast_once){
-                                std::vector<std::vector<typename std::remove_pointer<decltype(integral)>::type::real_t_type*>> pars = integral->get_parameters();
-                                std::vector<std::vector<typename std::remove_pointer<decltype(integral)>::type::real_t_type>> pars_data(pars.size());
-                                for(int i = 0; i < pars.size(); i++){
-                                    for(auto par:pars[i]){
-                                        pars_data[i].push_back(*par);
-                                    }
-                                }
-                                changed_deformation_parameters_map[integral->display_name] = pars_data;
-                                //write_map_to_file(changed_deformation_parameters_map); // do not store changed lambda parameters on disk
-                            }
-                            break;
                         }
+                        changed_deformation_parameters_map[integral->display_name] = pars_data;
+                        //write_map_to_file(changed_deformation_parameters_map); // do not store changed lambda parameters on disk
                     }
 
                     if(verbose and (next_n > curr_n))
-                    {
-                        std::cerr << "integral " << integral->id << "/" << integrals.size() << ": " << integral->display_name << ", time: ";
-                        auto flags = std::cerr.flags();
-                        std::cerr << std::fixed << std::setprecision(6) << integral->get_integration_time() << "s, ";
-                        std::cerr.flags(flags);
-                        print_datetime();
-                        std::cerr << "res: " << old_result << " -> " << integral->get_integral_result()
-                                      << ", n: " << curr_n << " -> " << std::dec << integral->get_number_of_function_evaluations() << std::endl;
-                        std::cerr << std::endl;
-                    }
+                        print_integral_progress(integral, integrals.size(), old_result, curr_n);
                 };
 
             std::vector<std::thread> thread_pool(number_of_threads);
@@ -631,6 +969,331 @@ namespace secdecutil {
                 if(worker.joinable())
                     worker.join();
         }
+        /*
+         * Remote evaluation of integrals.
+         *
+         * An "IntegralExecutor" set as the "executor" of a "WeightedIntegralHandler"
+         * evaluates the integrals instead of the local threads of "evaluate_integrals".
+         * The "ProcessExecutor" sends them to worker processes that run
+         * "WeightedIntegralHandler::serve" on the same expression, one integral
+         * at a time per worker, over a line based protocol:
+         *
+         *     request: <index> <n> <number of parameters> <parameter> ...
+         *     reply:   @<index> ok <n> <time> <value> <uncertainty> <number of parameters> <parameter> ...
+         *              @<index> error <message>
+         *
+         * Here "index" is the position of the integral in the list returned by
+         * "WeightedIntegralHandler::get_integrals", "n" the requested (or, in the
+         * reply, the used) number of function evaluations, and the parameters are the
+         * deformation parameters of "Integral::get_parameters", flattened. The worker
+         * integrates with the parameters of the coordinator, and replies with the
+         * ones that it had to lower to pass the sign check. Complex values are sent
+         * as their real and imaginary part. Output lines of the worker that do not
+         * start with "@" are ignored.
+         */
+        template<typename integral_t>
+        struct IntegralExecutor
+        {
+            virtual ~IntegralExecutor() = default;
+            virtual void evaluate(const std::vector<integral_t*>& integrals, const bool verbose) = 0;
+        };
+
+        namespace remote {
+
+            template<typename T>
+            void write_value(std::ostream& stream, const T& value) { stream << ' ' << value; }
+
+            template<typename T>
+            void write_value(std::ostream& stream, const std::complex<T>& value) { stream << ' ' << value.real() << ' ' << value.imag(); }
+
+            template<typename T>
+            void read_value(std::istream& stream, T& value) { stream >> value; }
+
+            template<typename T>
+            void read_value(std::istream& stream, std::complex<T>& value)
+            {
+                T re, im;
+                stream >> re >> im;
+                value = std::complex<T>(re, im);
+            }
+
+            #ifdef SECDEC_WITH_CUDA
+                template<typename T>
+                void write_value(std::ostream& stream, const thrust::complex<T>& value) { stream << ' ' << value.real() << ' ' << value.imag(); }
+
+                template<typename T>
+                void read_value(std::istream& stream, thrust::complex<T>& value)
+                {
+                    T re, im;
+                    stream >> re >> im;
+                    value = thrust::complex<T>(re, im);
+                }
+            #endif
+
+            template<typename real_t>
+            void write_parameters(std::ostream& stream, const std::vector<std::vector<real_t*>>& parameters)
+            {
+                size_t count = 0;
+                for(const auto& group : parameters)
+                    count += group.size();
+                stream << ' ' << count;
+                for(const auto& group : parameters)
+                    for(const real_t* parameter : group)
+                        stream << ' ' << *parameter;
+            }
+
+            // Read the parameters into "parameters"; return whether any of them changed.
+            template<typename real_t>
+            bool read_parameters(std::istream& stream, const std::vector<std::vector<real_t*>>& parameters)
+            {
+                size_t count = 0, expected = 0;
+                for(const auto& group : parameters)
+                    expected += group.size();
+                stream >> count;
+                if(!stream || count != expected)
+                    throw std::runtime_error("remote integral evaluation: wrong number of deformation parameters");
+                bool changed = false;
+                for(const auto& group : parameters)
+                    for(real_t* parameter : group)
+                    {
+                        real_t value;
+                        stream >> value;
+                        changed = changed || (value != *parameter);
+                        *parameter = value;
+                    }
+                if(!stream)
+                    throw std::runtime_error("remote integral evaluation: malformed deformation parameters");
+                return changed;
+            }
+
+        };
+
+        /*
+         * Evaluate integrals in worker processes, connected by pipes or sockets.
+         */
+        template<typename integral_t>
+        class ProcessExecutor : public IntegralExecutor<integral_t>
+        {
+            using real_t = typename integral_t::real_t_type;
+            using result_t = decltype(std::declval<integral_t>().get_integral_result());
+
+            struct worker_t
+            {
+                int read_fd;
+                int write_fd;
+                pid_t pid; // -1 if not started by us
+                std::string buffer;
+                long long int job; // index of the integral in progress, -1 if idle
+            };
+
+            std::vector<worker_t> workers;
+
+            static void write_all(int fd, const std::string& data)
+            {
+                size_t done = 0;
+                while(done < data.size())
+                {
+                    ssize_t n = ::write(fd, data.data() + done, data.size() - done);
+                    if(n < 0 && errno == EINTR) continue;
+                    if(n <= 0)
+                        throw std::runtime_error(std::string("class ProcessExecutor: can not write to worker: ") + std::strerror(errno));
+                    done += n;
+                }
+            }
+
+            // Read what is available; return false on end of file.
+            static bool read_some(worker_t& worker)
+            {
+                char chunk[4096];
+                ssize_t n;
+                do {
+                    n = ::read(worker.read_fd, chunk, sizeof(chunk));
+                } while(n < 0 && errno == EINTR);
+                if(n < 0)
+                    throw std::runtime_error(std::string("class ProcessExecutor: can not read from worker: ") + std::strerror(errno));
+                worker.buffer.append(chunk, n);
+                return n > 0;
+            }
+
+            public:
+
+                ProcessExecutor() = default;
+                ProcessExecutor(const ProcessExecutor&) = delete;
+                ProcessExecutor& operator=(const ProcessExecutor&) = delete;
+
+                /*
+                 * Add a worker that reads requests from "write_fd" and replies to "read_fd".
+                 * The executor takes ownership of the file descriptors.
+                 */
+                void add_worker(int read_fd, int write_fd)
+                {
+                    workers.push_back(worker_t{read_fd, write_fd, -1, "", -1});
+                }
+
+                /*
+                 * Start a worker with "/bin/sh -c <command>", e.g. "ssh node ./worker",
+                 * and send it "setup" ahead of the first request.
+                 */
+                void add_worker(const std::string& command, const std::string& setup = "")
+                {
+                    int to_worker[2], from_worker[2];
+                    if(::pipe(to_worker) != 0)
+                        throw std::runtime_error(std::string("class ProcessExecutor: pipe failed: ") + std::strerror(errno));
+                    if(::pipe(from_worker) != 0)
+                    {
+                        ::close(to_worker[0]); ::close(to_worker[1]);
+                        throw std::runtime_error(std::string("class ProcessExecutor: pipe failed: ") + std::strerror(errno));
+                    }
+                    // the ends kept here must not leak into other workers
+                    ::fcntl(to_worker[1], F_SETFD, FD_CLOEXEC);
+                    ::fcntl(from_worker[0], F_SETFD, FD_CLOEXEC);
+                    pid_t pid = ::fork();
+                    if(pid < 0)
+                        throw std::runtime_error(std::string("class ProcessExecutor: fork failed: ") + std::strerror(errno));
+                    if(pid == 0)
+                    {
+                        ::dup2(to_worker[0], 0);
+                        ::dup2(from_worker[1], 1);
+                        ::close(to_worker[0]); ::close(to_worker[1]);
+                        ::close(from_worker[0]); ::close(from_worker[1]);
+                        ::execl("/bin/sh", "sh", "-c", command.c_str(), (char*) nullptr);
+                        ::_exit(127);
+                    }
+                    ::close(to_worker[0]);
+                    ::close(from_worker[1]);
+                    workers.push_back(worker_t{from_worker[0], to_worker[1], pid, "", -1});
+                    write_all(to_worker[1], setup);
+                }
+
+                size_t number_of_workers() const { return workers.size(); }
+
+                /*
+                 * destructor: closing the input makes the workers exit
+                 */
+                ~ProcessExecutor()
+                {
+                    for(worker_t& worker : workers)
+                    {
+                        ::close(worker.write_fd);
+                        ::close(worker.read_fd);
+                    }
+                    for(worker_t& worker : workers)
+                        if(worker.pid > 0)
+                            ::waitpid(worker.pid, nullptr, 0);
+                }
+
+                void evaluate(const std::vector<integral_t*>& integrals, const bool verbose) override
+                {
+                    if(workers.empty())
+                        throw std::logic_error("class ProcessExecutor: no workers.");
+
+                    std::deque<size_t> queue;
+                    for(size_t index = 0; index < integrals.size(); ++index)
+                        if(integrals[index]->allow_refine && integrals[index]->get_next_number_of_function_evaluations() > integrals[index]->get_number_of_function_evaluations())
+                            queue.push_back(index);
+
+                    size_t pending = 0;
+                    std::string error;
+                    while(pending > 0 || (!queue.empty() && error.empty()))
+                    {
+                        // keep every worker busy
+                        for(worker_t& worker : workers)
+                        {
+                            if(worker.job >= 0 || queue.empty() || !error.empty())
+                                continue;
+                            const size_t index = queue.front();
+                            queue.pop_front();
+                            std::ostringstream request;
+                            request.precision(std::numeric_limits<real_t>::max_digits10);
+                            request << std::scientific << index << ' ' << integrals[index]->get_next_number_of_function_evaluations();
+                            remote::write_parameters(request, integrals[index]->get_parameters());
+                            request << '\n';
+                            write_all(worker.write_fd, request.str());
+                            worker.job = index;
+                            ++pending;
+                        }
+
+                        // wait for replies
+                        std::vector<pollfd> fds;
+                        std::vector<worker_t*> busy;
+                        for(worker_t& worker : workers)
+                            if(worker.job >= 0)
+                            {
+                                fds.push_back(pollfd{worker.read_fd, POLLIN, 0});
+                                busy.push_back(&worker);
+                            }
+                        if(::poll(fds.data(), fds.size(), -1) < 0)
+                        {
+                            if(errno == EINTR) continue;
+                            throw std::runtime_error(std::string("class ProcessExecutor: poll failed: ") + std::strerror(errno));
+                        }
+
+                        for(size_t i = 0; i < fds.size(); ++i)
+                        {
+                            if(fds[i].revents == 0)
+                                continue;
+                            worker_t& worker = *busy[i];
+                            if(!read_some(worker))
+                                throw std::runtime_error("class ProcessExecutor: worker exited while computing integral " + integrals[worker.job]->display_name + ".");
+                            size_t end;
+                            while(worker.job >= 0 && (end = worker.buffer.find('\n')) != std::string::npos)
+                            {
+                                std::string line = worker.buffer.substr(0, end);
+                                worker.buffer.erase(0, end + 1);
+                                if(line.empty() || line[0] != '@')
+                                    continue;
+
+                                std::istringstream reply(line.substr(1));
+                                long long int index;
+                                std::string status;
+                                reply >> index >> status;
+                                if(!reply || index != worker.job)
+                                    throw std::runtime_error("class ProcessExecutor: unexpected reply from worker: " + line);
+                                integral_t* integral = integrals[index];
+                                worker.job = -1;
+                                --pending;
+
+                                if(status != "ok")
+                                {
+                                    std::string message;
+                                    std::getline(reply >> std::ws, message);
+                                    if(error.empty())
+                                        error = "integral " + integral->display_name + " failed on a worker: " + message;
+                                    continue;
+                                }
+
+                                const unsigned long long int curr_n = integral->get_number_of_function_evaluations();
+                                result_t old_result;
+                                if(verbose)
+                                    try {
+                                        old_result = integral->get_integral_result();
+                                    } catch (const integral_not_computed_error&) { /* ignore */ };
+
+                                unsigned long long int n;
+                                real_t time;
+                                result_t result;
+                                reply >> n >> time;
+                                remote::read_value(reply, result.value);
+                                remote::read_value(reply, result.uncertainty);
+                                if(!reply)
+                                    throw std::runtime_error("class ProcessExecutor: malformed reply from worker: " + line);
+                                if(remote::read_parameters(reply, integral->get_parameters()))
+                                    std::cerr << "Integral " << integral->display_name << ": deformation parameters reduced by the worker." << std::endl;
+                                integral->store_result(result, n, time);
+                                // the worker could not go beyond its largest lattice
+                                if(n < integral->get_next_number_of_function_evaluations())
+                                    integral->allow_refine = false;
+
+                                if(verbose)
+                                    print_integral_progress(integral, integrals.size(), old_result, curr_n);
+                            }
+                        }
+                    }
+                    if(!error.empty())
+                        throw std::runtime_error(error);
+                }
+        };
+
         template<typename integrand_return_t, typename real_t, typename coefficient_t, template<typename...> class container_t>
         class WeightedIntegralHandler
         {
@@ -703,6 +1366,7 @@ namespace secdecutil {
                 real_t wall_clock_limit;
                 size_t number_of_threads;
                 size_t reset_cuda_after;
+                std::shared_ptr<IntegralExecutor<integral_t>> executor; // evaluates the integrals instead of "number_of_threads" local threads if set
                 container_t<sum_t> expression;
                 real_t epsrel;
                 real_t epsabs;
@@ -762,12 +1426,79 @@ namespace secdecutil {
                     name_sum(this->expression, "sum");
                 };
 
+                /*
+                 * the integrals appearing in the expression, each once, in the order of
+                 * their first appearance; the order is the same in every process
+                 */
+                std::vector<integral_t*> get_integrals()
+                {
+                    std::vector<integral_t*> integrals;
+                    std::set<integral_t*> seen;
+                    std::function<void(sum_t&)> populate_integrals =
+                        [ &integrals, &seen ] (sum_t& sum)
+                        {
+                            for (term_t& term : sum.summands)
+                                if (seen.insert(term.integral.get()).second)
+                                    integrals.push_back(term.integral.get());
+                        };
+                    secdecutil::deep_apply(expression, populate_integrals);
+                    return integrals;
+                }
+
+                /*
+                 * Act as a worker of a "ProcessExecutor" running on the same expression:
+                 * compute the requested integrals until "input" ends.
+                 */
+                void serve(std::istream& input, std::ostream& output)
+                {
+                    std::vector<integral_t*> integrals = get_integrals();
+                    std::string line;
+                    while(std::getline(input, line))
+                    {
+                        if(line.empty())
+                            continue;
+                        std::istringstream request(line);
+                        std::ostringstream reply;
+                        reply.precision(std::numeric_limits<real_t>::max_digits10);
+                        reply << std::scientific;
+                        size_t index = 0;
+                        unsigned long long int n;
+                        request >> index >> n;
+                        try {
+                            if(!request || index >= integrals.size())
+                                throw std::runtime_error("malformed request: " + line);
+                            integral_t* integral = integrals[index];
+                            remote::read_parameters(request, integral->get_parameters());
+                            integral->set_next_number_of_function_evaluations(n);
+                            compute_lowering_deformation(integral, verbose);
+                            reply << '@' << index << " ok " << integral->get_number_of_function_evaluations() << ' ' << integral->get_integration_time();
+                            remote::write_value(reply, integral->get_integral_result().value);
+                            remote::write_value(reply, integral->get_integral_result().uncertainty);
+                            remote::write_parameters(reply, integral->get_parameters());
+                        } catch (const std::exception& e) {
+                            std::string message = e.what();
+                            std::replace(message.begin(), message.end(), '\n', ' ');
+                            reply.str("");
+                            reply << '@' << index << " error " << message;
+                        }
+                        output << reply.str() << std::endl;
+                    }
+                }
+
             private:
 
                 decltype(std::chrono::steady_clock::now()) start_time;
 
             protected:
 
+                void compute_integrals(std::vector<integral_t*>& integrals)
+                {
+                    if(executor)
+                        executor->evaluate(get_integrals(), verbose); // the workers know the integrals by their position in this list
+                    else
+                        evaluate_integrals<integrand_return_t>(integrals, verbose, number_of_threads, reset_cuda_after, changed_deformation_parameters_map);
+                }
+
                 /*
                  * evaluate expression
                  */
@@ -1223,7 +1954,7 @@ namespace secdecutil {
                     print_datetime("Starting calculations: ");
                     std::cerr << "computing integrals to satisfy mineval " << this->mineval << std::endl;
                 }
-                evaluate_integrals<integrand_return_t>(integrals, verbose, number_of_threads, reset_cuda_after, changed_deformation_parameters_map);
+                compute_integrals(integrals);
                 if(verbose){
                     std::cerr << "---------------------" << std::endl << std::endl;
                     auto elapsed_time = std::chrono::duration<real_t>(std::chrono::steady_clock::now() - start_time).count();
@@ -1250,7 +1981,7 @@ namespace secdecutil {
                     if(verbose)
                         std::cerr << "ensure_wall_clock_limit allows/requires further refinements: " << (repeat ? "true" : "false") << std::endl;
 
-                    evaluate_integrals<integrand_return_t>(integrals, verbose, number_of_threads, reset_cuda_after, changed_deformation_parameters_map);
+                    compute_integrals(integrals);
                     if(verbose){
                         std::cerr << "---------------------" << std::endl << std::endl;
                         auto elapsed_time = std::chrono::duration<real_t>(std::chrono::steady_clock::now() - start_time).count();
@@ -1291,7 +2022,7 @@ namespace secdecutil {
                     if(verbose)
                         std::cerr << "ensure_wall_clock_limit allows/requires further refinements: " << (repeat ? "true" : "false") << std::endl;
 
-                    evaluate_integrals<integrand_return_t>(integrals, verbose, number_of_threads, reset_cuda_after, changed_deformation_parameters_map);
+                    compute_integrals(integrals);
                     if(verbose){
                         std::cerr << "---------------------" << std::endl << std::endl;
                         print_datetime();
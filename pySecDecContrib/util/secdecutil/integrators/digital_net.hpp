@@ -0,0 +1,650 @@
+#ifndef SecDecUtil_digital_net_hpp_included
+#define SecDecUtil_digital_net_hpp_included
+
+/*
+ * This file implements a quasi-Monte Carlo integrator based on
+ * higher order digital nets, namely interlaced polynomial lattice
+ * rules in base 2 (Dick 2008, Goda & Dick 2015).
+ *
+ * A polynomial lattice rule with 2^m points is defined by a
+ * primitive polynomial p of degree m over GF(2) and one polynomial
+ * q_j per coordinate. Interlacing the digits of "order" coordinates
+ * of such a rule yields one coordinate of the interlaced rule, which
+ * integrates functions with square integrable mixed derivatives up
+ * to that order with an error of O(n^-order (log n)^(order*dim)),
+ * without any periodizing transform. The polynomials q_j are
+ * constructed component by component, minimizing a bound on the
+ * worst-case error of the interlaced rule; the construction is
+ * cached and reused for all integrals of lower dimension.
+ *
+ * Unbiased estimates and error estimates are obtained from
+ * independent random digital shifts, i.e. by xoring every point with
+ * a random bit string, as the Qmc does with random shifts.
+ */
+
+#ifdef SECDEC_WITH_CUDA
+    #include <thrust/complex.h>
+#endif
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <secdecutil/integrand_container.hpp>
+#include <secdecutil/integrators/integrator.hpp>
+#include <secdecutil/uncertainties.hpp>
+
+namespace secdecutil
+{
+    namespace integrators
+    {
+        namespace digital_net
+        {
+            template<typename T> struct remove_complex { using type = T; };
+            template<typename T> struct remove_complex<std::complex<T>> { using type = T; };
+            #ifdef SECDEC_WITH_CUDA
+                template<typename T> struct remove_complex<thrust::complex<T>> { using type = T; };
+            #endif
+
+            /*
+             * arithmetic of polynomials over GF(2), bit i is the coefficient of x^i
+             */
+
+            inline uint64_t multiply_modulo(uint64_t a, uint64_t b, uint64_t p, unsigned degree)
+            {
+                uint64_t result = 0;
+                for (; b; b >>= 1)
+                {
+                    if (b & 1)
+                        result ^= a;
+                    a <<= 1;
+                    if ((a >> degree) & 1)
+                        a ^= p;
+                }
+                return result;
+            };
+
+            inline uint64_t power_of_x_modulo(uint64_t exponent, uint64_t p, unsigned degree)
+            {
+                uint64_t result = 1, base = degree > 1 ? 2 : 2 ^ p;
+                for (; exponent; exponent >>= 1)
+                {
+                    if (exponent & 1)
+                        result = multiply_modulo(result, base, p, degree);
+                    base = multiply_modulo(base, base, p, degree);
+                }
+                return result;
+            };
+
+            // "p" is primitive if x generates the multiplicative group of GF(2)[x]/p, i.e. has order 2^degree-1
+            inline bool is_primitive(uint64_t p, unsigned degree)
+            {
+                const uint64_t order = (uint64_t(1) << degree) - 1;
+                if (power_of_x_modulo(order, p, degree) != 1)
+                    return false;
+                uint64_t remainder = order;
+                for (uint64_t factor = 2; factor*factor <= remainder; ++factor)
+                {
+                    if (remainder % factor)
+                        continue;
+                    if (power_of_x_modulo(order/factor, p, degree) == 1)
+                        return false;
+                    while (remainder % factor == 0)
+                        remainder /= factor;
+                }
+                return remainder == 1 || power_of_x_modulo(order/remainder, p, degree) != 1;
+            };
+
+            inline uint64_t primitive_polynomial(unsigned degree)
+            {
+                for (uint64_t p = (uint64_t(1) << degree) | 1; p < (uint64_t(2) << degree); p += 2)
+                    if (is_primitive(p, degree))
+                        return p;
+                throw std::logic_error("no primitive polynomial of degree " + std::to_string(degree) + " found");
+            };
+
+            // radix-2 fast Fourier transform of a sequence whose length is a power of two
+            inline void fft(std::vector<std::complex<double>>& a, bool inverse)
+            {
+                const size_t n = a.size();
+                for (size_t i = 1, j = 0; i < n; ++i)
+                {
+                    size_t bit = n >> 1;
+                    for (; j & bit; bit >>= 1)
+                        j ^= bit;
+                    j ^= bit;
+                    if (i < j)
+                        std::swap(a[i], a[j]);
+                }
+                const double pi = 3.14159265358979323846;
+                for (size_t length = 2; length <= n; length <<= 1)
+                {
+                    const double angle = 2*pi/length * (inverse ? 1 : -1);
+                    const std::complex<double> step(std::cos(angle), std::sin(angle));
+                    std::vector<std::complex<double>> twiddle(length/2);
+                    twiddle[0] = 1;
+                    for (size_t k = 1; k < length/2; ++k)
+                        twiddle[k] = (k % 64) ? twiddle[k-1]*step : std::polar(1., angle*k); // limit the accumulation of rounding errors
+                    for (size_t i = 0; i < n; i += length)
+                        for (size_t k = 0; k < length/2; ++k)
+                        {
+                            const std::complex<double> u = a[i+k], v = a[i+k+length/2]*twiddle[k];
+                            a[i+k] = u + v;
+                            a[i+k+length/2] = u - v;
+                        }
+                }
+            };
+
+            /*
+             * Interlaced polynomial lattice rule with 2^m points.
+             *
+             * With the primitive polynomial p, every nonzero polynomial
+             * k of degree < m is a power x^a modulo p. The point k has
+             * the components v_m(k q/p), and writing q = x^b, these
+             * are the first m digits of x^(a+b)/p, which are tabulated
+             * in "digits". The rule is therefore described by the
+             * exponents b of its polynomials; the point k = 0 is the
+             * origin.
+             */
+            struct Rule
+            {
+                unsigned m;
+                unsigned order;
+                unsigned dimension;
+                std::vector<uint32_t> digits; // first m digits of x^e/p, most significant bit first
+                std::vector<uint64_t> exponents; // "order" exponents per coordinate
+                uint64_t spread[256]; // bit t of a byte moved to bit order*t
+
+                uint64_t number_of_points() const
+                {
+                    return uint64_t(1) << m;
+                };
+
+                // coordinate "j" of the point x^a (a < 2^m-1), digits left aligned in 64 bits
+                uint64_t point(uint64_t a, unsigned j) const
+                {
+                    const uint64_t period = digits.size();
+                    uint64_t y = 0;
+                    for (unsigned l = 0; l < order; ++l)
+                    {
+                        uint64_t e = a + exponents[j*order + l];
+                        if (e >= period)
+                            e -= period;
+                        const uint32_t v = digits[e];
+                        uint64_t interlaced = 0;
+                        for (unsigned byte = 0; byte*8 < m; ++byte)
+                            interlaced |= spread[(v >> (8*byte)) & 255] << (order*8*byte);
+                        y |= interlaced << (order - 1 - l);
+                    }
+                    return y << (64 - order*m);
+                };
+            };
+
+            /*
+             * Component by component construction of an interlaced polynomial lattice rule.
+             *
+             * The figure of merit is the bound of Goda & Dick (2015) on the worst-case error in the
+             * weighted Walsh space of smoothness "order" (with unit product weights),
+             *
+             *   B = -1 + 2^-m sum_k prod_j [ prod_l ( 1 + 2^(order-l) phi(x_(k,j,l)) ) ],
+             *
+             * where phi(x) = sum_a 2^(-order*a) sum_(2^(a-1) <= k < 2^a) wal_k(x) only depends on
+             * the position of the first nonzero digit of x. For "order" = 1 the weight 4^-a of
+             * ordinary polynomial lattice rules is used. In terms of the exponents a and b the
+             * sum over the points is a cyclic correlation, which is computed with fast Fourier
+             * transforms in O(n log n) per component.
+             */
+            inline Rule construct_rule(unsigned m, unsigned order, unsigned dimension)
+            {
+                Rule rule;
+                rule.m = m;
+                rule.order = order;
+                rule.dimension = dimension;
+                for (unsigned byte = 0; byte < 256; ++byte)
+                {
+                    rule.spread[byte] = 0;
+                    for (unsigned t = 0; t < 8; ++t)
+                        rule.spread[byte] |= uint64_t((byte >> t) & 1) << (order*t);
+                }
+
+                const uint64_t p = primitive_polynomial(m);
+                const uint64_t period = (uint64_t(1) << m) - 1;
+
+                // the leading digit of x^e/p is the coefficient of x^(m-1) in x^e mod p,
+                // and the digits of x^(e+1)/p are those of x^e/p shifted by one
+                std::vector<uint8_t> stream(period + m);
+                uint64_t power = 1;
+                for (uint64_t e = 0; e < period; ++e)
+                {
+                    stream[e] = (power >> (m - 1)) & 1;
+                    power <<= 1;
+                    if ((power >> m) & 1)
+                        power ^= p;
+                }
+                for (uint64_t e = period; e < period + m; ++e)
+                    stream[e] = stream[e - period];
+                rule.digits.resize(period);
+                for (uint64_t e = 0; e < period; ++e)
+                {
+                    uint32_t v = 0;
+                    for (unsigned i = 0; i < m; ++i)
+                        v = (v << 1) | stream[e+i];
+                    rule.digits[e] = v;
+                }
+
+                // phi as function of the position i0 of the first nonzero digit
+                const double c = order > 1 ? std::ldexp(1., 1 - int(order)) : 0.5;
+                std::vector<double> phi(m + 1);
+                for (unsigned i0 = 1; i0 <= m; ++i0)
+                    phi[i0] = 0.5 * (c*(1 - std::pow(c, i0 - 1))/(1 - c) - std::pow(c, i0));
+                std::vector<double> h(period);
+                for (uint64_t e = 0; e < period; ++e)
+                {
+                    unsigned i0 = 1;
+                    while ( ! ((rule.digits[e] >> (m - i0)) & 1) )
+                        ++i0;
+                    h[e] = phi[i0];
+                }
+
+                uint64_t length = 1;
+                while (length < 2*period)
+                    length <<= 1;
+                std::vector<std::complex<double>> transformed_h(length, 0.);
+                for (uint64_t e = 0; e < period; ++e)
+                    transformed_h[e] = h[e];
+                fft(transformed_h, false);
+
+                std::vector<double> previous_coordinates(period, 1.), current_coordinate(period, 1.);
+                std::vector<std::complex<double>> correlation(length);
+                for (unsigned component = 0; component < order*dimension; ++component)
+                {
+                    const unsigned l = component % order + 1;
+                    const double factor = std::ldexp(1., int(order) - int(l));
+                    if (l == 1)
+                        std::fill(current_coordinate.begin(), current_coordinate.end(), 1.);
+
+                    uint64_t best = 0;
+                    if (component > 0)
+                    {
+                        // correlation[b] = sum_a w[a] h[(a+b) mod period]
+                        std::fill(correlation.begin(), correlation.end(), 0.);
+                        for (uint64_t a = 0; a < period; ++a)
+                            correlation[a] = previous_coordinates[a]*current_coordinate[a];
+                        fft(correlation, false);
+                        for (uint64_t k = 0; k < length; ++k)
+                            correlation[k] = std::conj(correlation[k])*transformed_h[k];
+                        fft(correlation, true);
+                        double best_value = correlation[0].real();
+                        for (uint64_t b = 1; b < period; ++b)
+                        {
+                            const double value = correlation[b].real() + correlation[length - period + b].real();
+                            if (value < best_value)
+                            {
+                                best_value = value;
+                                best = b;
+                            }
+                        }
+                    }
+                    rule.exponents.push_back(best);
+
+                    for (uint64_t a = 0, e = best; a < period; ++a, e = (e + 1 == period ? 0 : e + 1))
+                        current_coordinate[a] *= 1 + factor*h[e];
+                    if (l == order)
+                        for (uint64_t a = 0; a < period; ++a)
+                            previous_coordinates[a] *= current_coordinate[a];
+                }
+                return rule;
+            };
+
+            // bytes allocated by "construct_rule" for a rule with 2^m points: the digit tables, and
+            // the fast Fourier transforms of length 2^(m+1)
+            inline double construction_memory(unsigned m)
+            {
+                return std::ldexp(1 + 4 + 8 + 2*8 + 2*2*16, m);
+            };
+
+            // the largest m such that the digits of a coordinate fit into 64 bits, and the
+            // construction of the rule into "maxmemory" bytes
+            inline unsigned largest_m(unsigned order, uint64_t maxmemory)
+            {
+                unsigned m = 1;
+                while (m < 64/order && construction_memory(m + 1) <= maxmemory)
+                    ++m;
+                return m;
+            };
+
+            // Real and imaginary part are estimated separately, see "::integrators::ErrorMode::all" of the Qmc.
+            template<typename real_t>
+            real_t error_ratio(const real_t& integral, const real_t& error, double epsrel, double epsabs)
+            {
+                using std::abs;
+                return std::min(error/epsabs, error/(epsrel*abs(integral)));
+            };
+            template<typename complex_t>
+            auto complex_error_ratio(const complex_t& integral, const complex_t& error, double epsrel, double epsabs) -> decltype(integral.real())
+            {
+                return std::max(error_ratio(integral.real(), error.real(), epsrel, epsabs), error_ratio(integral.imag(), error.imag(), epsrel, epsabs));
+            };
+            template<typename real_t>
+            real_t error_ratio(const std::complex<real_t>& integral, const std::complex<real_t>& error, double epsrel, double epsabs)
+            {
+                return complex_error_ratio(integral, error, epsrel, epsabs);
+            };
+
+            template<typename real_t>
+            real_t standard_error(const std::vector<real_t>& estimates, const real_t& mean)
+            {
+                using std::sqrt;
+                real_t variance = 0;
+                for (const real_t& estimate : estimates)
+                    variance += (estimate - mean)*(estimate - mean);
+                return sqrt(variance/(estimates.size()*(estimates.size() - 1)));
+            };
+            template<typename complex_t>
+            complex_t complex_standard_error(const std::vector<complex_t>& estimates, const complex_t& mean)
+            {
+                using real_t = decltype(mean.real());
+                std::vector<real_t> re, im;
+                for (const complex_t& estimate : estimates)
+                {
+                    re.push_back(estimate.real());
+                    im.push_back(estimate.imag());
+                }
+                return complex_t(standard_error(re, mean.real()), standard_error(im, mean.imag()));
+            };
+            template<typename real_t>
+            std::complex<real_t> standard_error(const std::vector<std::complex<real_t>>& estimates, const std::complex<real_t>& mean)
+            {
+                return complex_standard_error(estimates, mean);
+            };
+
+            #ifdef SECDEC_WITH_CUDA
+                template<typename real_t>
+                real_t error_ratio(const thrust::complex<real_t>& integral, const thrust::complex<real_t>& error, double epsrel, double epsabs)
+                {
+                    return complex_error_ratio(integral, error, epsrel, epsabs);
+                };
+                template<typename real_t>
+                thrust::complex<real_t> standard_error(const std::vector<thrust::complex<real_t>>& estimates, const thrust::complex<real_t>& mean)
+                {
+                    return complex_standard_error(estimates, mean);
+                };
+            #endif
+
+            // rules already constructed, shared between copies of an integrator
+            struct RuleCache
+            {
+                std::mutex mutex;
+                std::map<std::pair<unsigned,unsigned>,std::shared_ptr<const Rule>> rules; // (m, order) -> rule of the highest dimension so far
+
+                std::shared_ptr<const Rule> get(unsigned m, unsigned order, unsigned dimension)
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        const std::shared_ptr<const Rule>& rule = rules[{m, order}];
+                        // the construction is component by component, so rules of lower dimension are contained
+                        if ( rule && rule->dimension >= dimension )
+                            return rule;
+                    }
+                    // construct without holding the lock, so that the other integrators are not blocked
+                    std::shared_ptr<const Rule> constructed = std::make_shared<const Rule>(construct_rule(m, order, dimension));
+                    std::lock_guard<std::mutex> lock(mutex);
+                    std::shared_ptr<const Rule>& rule = rules[{m, order}];
+                    if ( ! rule || rule->dimension < constructed->dimension )
+                        rule = constructed;
+                    return rule;
+                };
+            };
+
+            /*
+             * The integration algorithm, shared by the real and complex versions of "DigitalNet".
+             */
+            template<typename return_t, typename real_t>
+            struct DigitalNetBase
+            {
+                double epsrel = 1e-2;
+                double epsabs = 1e-7;
+                uint64_t maxeval = 1000000;
+                uint64_t minn = 8192; // minimal number of points, rounded up to the next power of two
+                uint64_t minm = 32; // number of random digital shifts
+                unsigned order = 2; // interlacing factor, the expected order of convergence
+                uint64_t maxmemory = uint64_t(1) << 31; // bytes that the construction of a rule may use, which limits its size
+                unsigned cputhreads = std::thread::hardware_concurrency();
+                unsigned verbosity = 0;
+                std::mt19937_64 randomgenerator{std::random_device{}()};
+                std::reference_wrapper<std::ostream> logger = std::cerr;
+
+            protected:
+                std::shared_ptr<RuleCache> rules = std::make_shared<RuleCache>();
+
+                // estimate the integral with every digital shift, distributing blocks of points over the cpu threads
+                template<typename container_t>
+                std::vector<return_t> sample(const container_t& integrand_container, const Rule& rule, const std::vector<uint64_t>& shifts, unsigned dimension) const
+                {
+                    const uint64_t period = rule.digits.size();
+                    const uint64_t block_size = 4096;
+                    const uint64_t blocks = (period + block_size - 1)/block_size;
+                    const uint64_t number_of_shifts = shifts.size()/dimension;
+                    const uint64_t number_of_work_packages = number_of_shifts*blocks;
+                    std::vector<return_t> partial_sums(number_of_work_packages, return_t(0));
+                    std::atomic<uint64_t> next_work_package(0);
+                    std::exception_ptr exception = nullptr;
+                    std::mutex exception_mutex;
+
+                    auto worker = [&] ()
+                    {
+                        try
+                        {
+                            std::vector<real_t> x(dimension);
+                            for (uint64_t package = next_work_package++; package < number_of_work_packages; package = next_work_package++)
+                            {
+                                const uint64_t shift = package / blocks, block = package % blocks;
+                                const uint64_t* shift_bits = &shifts[shift*dimension];
+                                return_t sum(0);
+                                if (block == 0)
+                                {
+                                    // the origin
+                                    for (unsigned j = 0; j < dimension; ++j)
+                                        x[j] = static_cast<real_t>(std::ldexp(static_cast<double>(shift_bits[j] >> 11), -53));
+                                    sum += integrand_container(x.data());
+                                }
+                                for (uint64_t a = block*block_size; a < std::min(period, (block + 1)*block_size); ++a)
+                                {
+                                    for (unsigned j = 0; j < dimension; ++j)
+                                        x[j] = static_cast<real_t>(std::ldexp(static_cast<double>((rule.point(a,j) ^ shift_bits[j]) >> 11), -53));
+                                    sum += integrand_container(x.data());
+                                }
+                                partial_sums[package] = sum;
+                            }
+                        }
+                        catch (...)
+                        {
+                            std::lock_guard<std::mutex> lock(exception_mutex);
+                            exception = std::current_exception();
+                            next_work_package = number_of_work_packages;
+                        }
+                    };
+
+                    const unsigned number_of_threads = std::max(1u, std::min<unsigned>(cputhreads, number_of_work_packages));
+                    if (number_of_threads == 1)
+                    {
+                        worker();
+                    }
+                    else
+                    {
+                        std::vector<std::thread> threads;
+                        for (unsigned i = 0; i < number_of_threads; ++i)
+                            threads.emplace_back(worker);
+                        for (std::thread& thread : threads)
+                            thread.join();
+                    }
+                    if (exception)
+                        std::rethrow_exception(exception);
+
+                    std::vector<return_t> estimates(number_of_shifts, return_t(0));
+                    for (uint64_t package = 0; package < number_of_work_packages; ++package)
+                        estimates[package / blocks] += partial_sums[package];
+                    for (return_t& estimate : estimates)
+                        estimate /= static_cast<real_t>(rule.number_of_points());
+                    return estimates;
+                };
+
+            public:
+
+                template<typename container_t>
+                secdecutil::UncorrelatedDeviation<return_t> integrate_container(const container_t& integrand_container)
+                {
+                    using std::log2;
+
+                    if (order < 1)
+                        throw std::domain_error("DigitalNet: order must be at least 1.");
+                    if (minm < 2)
+                        throw std::domain_error("DigitalNet: minm must be at least 2 to estimate the error.");
+
+                    const unsigned dimension = std::max(1, static_cast<int>(integrand_container.number_of_integration_variables));
+                    const unsigned maxm = largest_m(order, maxmemory);
+                    unsigned m = 1;
+                    while (m < maxm && (uint64_t(1) << m) < minn)
+                        ++m;
+                    uint64_t number_of_shifts = minm;
+
+                    uint64_t evaluations = 0;
+                    return_t integral(0), error(0);
+                    real_t previous_error_ratio = 0;
+                    uint64_t previous_n = 0;
+                    while (true)
+                    {
+                        std::shared_ptr<const Rule> rule = rules->get(m, order, dimension);
+                        std::vector<uint64_t> shifts(number_of_shifts*dimension);
+                        for (uint64_t& shift : shifts)
+                            shift = randomgenerator();
+
+                        const std::vector<return_t> estimates = sample(integrand_container, *rule, shifts, dimension);
+                        integral = return_t(0);
+                        for (const return_t& estimate : estimates)
+                            integral += estimate;
+                        integral /= static_cast<real_t>(number_of_shifts);
+                        error = standard_error(estimates, integral);
+                        evaluations += rule->number_of_points()*number_of_shifts;
+
+                        const real_t ratio = error_ratio(integral, error, epsrel, epsabs);
+                        if (verbosity > 0)
+                            logger.get() << "DigitalNet: n = 2^" << m << ", shifts = " << number_of_shifts << ", integral = " << integral
+                                         << ", error = " << error << ", evaluations = " << evaluations << std::endl;
+                        if ( ! (ratio > 1) || evaluations >= maxeval )
+                            break;
+
+                        // expected convergence rate: measured between the last two iterations, at most "order"
+                        double rate = 1;
+                        if (previous_n)
+                        {
+                            rate = log2(previous_error_ratio/ratio) / log2(double(rule->number_of_points())/previous_n);
+                            rate = std::max(0.5, std::min(double(order), std::isfinite(rate) ? rate : 0.5));
+                        }
+                        previous_error_ratio = ratio;
+                        previous_n = rule->number_of_points();
+
+                        unsigned next_m = m;
+                        uint64_t next_shifts = number_of_shifts;
+                        if (m == maxm)
+                        {
+                            next_shifts *= 2; // the error falls like 1/sqrt(shifts) beyond the largest rule
+                        }
+                        else
+                        {
+                            next_m = m + 1;
+                            const double wanted = std::ldexp(std::pow(double(ratio), 1/rate), m);
+                            while (next_m < maxm && std::ldexp(1., next_m) < wanted && evaluations + (uint64_t(2) << next_m)*number_of_shifts <= maxeval)
+                                ++next_m;
+                        }
+
+                        // like the Qmc, use fewer shifts if the next round does not fit into "maxeval"; stop if
+                        // fewer than two shifts fit, or if the largest rule would not get more shifts than now
+                        const uint64_t remaining_shifts = (maxeval - evaluations) >> next_m;
+                        if (next_shifts > remaining_shifts)
+                        {
+                            next_shifts = remaining_shifts;
+                            if (next_shifts < 2 || (next_m == m && next_shifts <= number_of_shifts))
+                            {
+                                if (verbosity > 0)
+                                    logger.get() << "DigitalNet: maxeval reached" << std::endl;
+                                break;
+                            }
+                            if (verbosity > 0)
+                                logger.get() << "DigitalNet: requested number of function evaluations greater than maxeval, reducing shifts" << std::endl;
+                        }
+                        m = next_m;
+                        number_of_shifts = next_shifts;
+                    }
+
+                    integrand_container.process_errors();
+                    return secdecutil::UncorrelatedDeviation<return_t>{integral, error};
+                };
+
+                DigitalNetBase() = default;
+                DigitalNetBase(const DigitalNetBase&) = default;
+            };
+        };
+
+        /*
+         * Integrator interface
+         */
+
+        template<typename return_t, typename container_t = secdecutil::IntegrandContainer<return_t, typename digital_net::remove_complex<return_t>::type const * const>>
+        struct DigitalNet : Integrator<return_t,return_t,container_t>, public digital_net::DigitalNetBase<return_t,return_t>
+        {
+        protected:
+            std::function<secdecutil::UncorrelatedDeviation<return_t>(const container_t&)> get_integrate() override
+            {
+                return [this] (const container_t& integrand_container) { return this->integrate_container(integrand_container); };
+            };
+
+        public:
+            using Integrator<return_t,return_t,container_t>::integrate;
+            static constexpr bool cuda_compliant_integrator = false;
+
+            DigitalNet() = default;
+            DigitalNet(const DigitalNet& original) : Integrator<return_t,return_t,container_t>(), digital_net::DigitalNetBase<return_t,return_t>(original) {};
+        };
+
+        #define COMPLEX_DIGITAL_NET(complex_template) \
+        template<typename return_t, typename container_t> \
+        struct DigitalNet<complex_template<return_t>,container_t> : Integrator<complex_template<return_t>,return_t,container_t>, \
+            public digital_net::DigitalNetBase<complex_template<return_t>,return_t> \
+        { \
+        protected: \
+            std::function<secdecutil::UncorrelatedDeviation<complex_template<return_t>>(const container_t&)> get_together_integrate() override \
+            { \
+                return [this] (const container_t& integrand_container) { return this->integrate_container(integrand_container); }; \
+            }; \
+        public: \
+            using Integrator<complex_template<return_t>,return_t,container_t>::integrate; \
+            static constexpr bool cuda_compliant_integrator = false; \
+            DigitalNet() { this->together = true; }; \
+            DigitalNet(const DigitalNet& original) : \
+                Integrator<complex_template<return_t>,return_t,container_t>(), \
+                digital_net::DigitalNetBase<complex_template<return_t>,return_t>(original) \
+                { this->together = true; }; \
+        };
+
+        COMPLEX_DIGITAL_NET(std::complex)
+        #ifdef SECDEC_WITH_CUDA
+            COMPLEX_DIGITAL_NET(thrust::complex)
+        #endif
+        #undef COMPLEX_DIGITAL_NET
+
+    };
+}
+
+#endif
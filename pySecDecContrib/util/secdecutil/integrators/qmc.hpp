@@ -4,9 +4,22 @@
 #ifdef SECDEC_WITH_CUDA
     #include <thrust/complex.h>
 #endif
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <complex>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <random>
 #include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 #include <qmc.hpp>
 #include <secdecutil/integrand_container.hpp>
 #include <secdecutil/uncertainties.hpp>
@@ -20,18 +33,346 @@ namespace secdecutil
 
         template<typename,typename,U> using void_template = void;
 
-        template<typename functor_t>
+        template<typename T> struct remove_complex { using type = T; };
+        template<typename T> struct remove_complex<std::complex<T>> { using type = T; };
+        #ifdef SECDEC_WITH_CUDA
+            template<typename T> struct remove_complex<thrust::complex<T>> { using type = T; };
+        #endif
+
+        /*
+         * adaptive domain subdivision
+         */
+
+        // Options of the runtime domain subdivision, shared by all Qmc specializations.
+        // Subdivision is disabled if ``subdivisiondepth`` is zero.
+        struct QmcSubdivision
+        {
+            U subdivisiondepth = 0; // maximal number of nested splits of the integration domain
+            U subdivisionminn = 8191; // size of the pilot lattice used to decide on a split
+            double subdivisionthreshold = 0.8; // split only if the predicted cost drops below this fraction
+        };
+
+        template<typename functor_t, typename real_t, U maxdim>
         struct QmcContainer : functor_t
         {
             QmcContainer(const functor_t& functor) : functor_t(functor) {};
             const unsigned number_of_integration_variables = functor_t::number_of_integration_variables >= 1 ? functor_t::number_of_integration_variables : 1; // ensure dim >= 1
+
+            // Restriction to the box mapped onto the unit hypercube, see ``subdivision::integrate``: variable
+            // ``split_variable[k]`` is restricted to [split_lower[k], split_lower[k] + split_width[k]).
+            // Keeping the box in this type avoids instantiating the Qmc a second time for subdivided integrands,
+            // and storing only the split variables keeps the copies made for every integration (and sent to
+            // the GPU) independent of ``maxdim``.
+            static constexpr unsigned maxsplits = 8;
+            unsigned splits = 0;
+            real_t jacobian = 1;
+            unsigned split_variable[maxsplits];
+            real_t split_lower[maxsplits];
+            real_t split_width[maxsplits];
+
+            // whether ``refine`` can split variable ``dimension``
+            bool can_refine(unsigned dimension) const
+            {
+                return splits < maxsplits || std::find(split_variable, split_variable + splits, dimension) != split_variable + splits;
+            };
+
+            // the part of this box with variable ``dimension`` (in local coordinates) in [begin, end)
+            QmcContainer refine(unsigned dimension, real_t begin, real_t end) const
+            {
+                QmcContainer piece(*this);
+                const unsigned k = std::find(piece.split_variable, piece.split_variable + piece.splits, dimension) - piece.split_variable;
+                if (k == piece.splits)
+                {
+                    if (k == maxsplits)
+                        throw std::length_error("QmcContainer: too many split variables.");
+                    piece.split_variable[k] = dimension;
+                    piece.split_lower[k] = 0;
+                    piece.split_width[k] = 1;
+                    ++piece.splits;
+                }
+                piece.split_lower[k] += piece.split_width[k] * begin;
+                piece.split_width[k] *= end - begin;
+                piece.jacobian *= end - begin;
+                return piece;
+            };
+
+            using functor_t::operator();
+            #ifdef __CUDACC__
+                __host__ __device__
+            #endif
+            auto operator()(real_t const * const x) const -> decltype(std::declval<const functor_t&>()(x))
+            {
+                if (splits == 0)
+                    return functor_t::operator()(x);
+                real_t y[maxdim];
+                for (unsigned i = 0; i < number_of_integration_variables; ++i)
+                    y[i] = x[i];
+                for (unsigned k = 0; k < splits; ++k)
+                    y[split_variable[k]] = split_lower[k] + split_width[k] * x[split_variable[k]];
+                return jacobian * functor_t::operator()(y);
+            };
         };
 
-        template<typename T> struct remove_complex { using type = T; };
-        template<typename T> struct remove_complex<std::complex<T>> { using type = T; };
-        #ifdef SECDEC_WITH_CUDA
-            template<typename T> struct remove_complex<thrust::complex<T>> { using type = T; };
-        #endif
+        namespace subdivision
+        {
+            // absolute error goal implied by ``epsrel`` and ``epsabs`` for an integral of size ``mean``,
+            // and the size of an error to compare with it
+            template<typename real_t>
+            real_t error_goal(const real_t& mean, real_t epsrel, real_t epsabs, ::integrators::ErrorMode)
+            {
+                using std::abs;
+                return std::max(epsabs, epsrel*abs(mean));
+            };
+            template<typename real_t>
+            real_t error_size(const real_t& error)
+            {
+                return error;
+            };
+
+            // errors of independent pieces add in quadrature
+            template<typename real_t>
+            real_t add_errors(const real_t& a, const real_t& b)
+            {
+                using std::sqrt;
+                return sqrt(a*a + b*b);
+            };
+
+            // complex numbers: real and imaginary part have separate errors, see ``::integrators::ErrorMode``
+            template<typename complex_t, typename real_t>
+            real_t complex_error_goal(const complex_t& mean, real_t epsrel, real_t epsabs, ::integrators::ErrorMode errormode)
+            {
+                using std::abs;
+                real_t re = abs(mean.real()), im = abs(mean.imag());
+                return std::max(epsabs, epsrel*(errormode == ::integrators::ErrorMode::largest ? std::max(re,im) : std::min(re,im)));
+            };
+            template<typename complex_t>
+            complex_t add_complex_errors(const complex_t& a, const complex_t& b)
+            {
+                using std::sqrt;
+                return complex_t(sqrt(a.real()*a.real() + b.real()*b.real()), sqrt(a.imag()*a.imag() + b.imag()*b.imag()));
+            };
+            template<typename real_t>
+            real_t error_goal(const std::complex<real_t>& mean, real_t epsrel, real_t epsabs, ::integrators::ErrorMode errormode)
+            {
+                return complex_error_goal(mean, epsrel, epsabs, errormode);
+            };
+            template<typename real_t>
+            real_t error_size(const std::complex<real_t>& error)
+            {
+                return std::max(error.real(), error.imag());
+            };
+            template<typename real_t>
+            std::complex<real_t> add_errors(const std::complex<real_t>& a, const std::complex<real_t>& b)
+            {
+                return add_complex_errors(a, b);
+            };
+            #ifdef SECDEC_WITH_CUDA
+                template<typename real_t>
+                real_t error_goal(const thrust::complex<real_t>& mean, real_t epsrel, real_t epsabs, ::integrators::ErrorMode errormode)
+                {
+                    return complex_error_goal(mean, epsrel, epsabs, errormode);
+                };
+                template<typename real_t>
+                real_t error_size(const thrust::complex<real_t>& error)
+                {
+                    return std::max(error.real(), error.imag());
+                };
+                template<typename real_t>
+                thrust::complex<real_t> add_errors(const thrust::complex<real_t>& a, const thrust::complex<real_t>& b)
+                {
+                    return add_complex_errors(a, b);
+                };
+            #endif
+
+            /*
+             * Integrate ``box`` with ``integrator``, splitting it in two if that is predicted to be cheaper.
+             *
+             * A first iteration of the Qmc on the whole box gives the error E of a lattice with n
+             * points from the spread of the random shifts. If E already meets the error goal, that
+             * result is returned as is. Otherwise a single randomly shifted pilot lattice of
+             * ``subdivisionminn`` points is evaluated. For every variable and every candidate cut the
+             * pilot points are divided into the two pieces and the standard deviation sigma_i of each
+             * piece (in its own unit hypercube) is estimated. The error of a piece at n points is
+             * predicted as E*sigma_i/sigma, and assuming errors fall like 1/n, the cost to reach the error
+             * goal eps_i is n*max(1, E*sigma_i/(sigma*eps_i)). The error goal is distributed over the
+             * pieces such that the total cost is minimal, eps_i ~ sigma_i^(1/3). The cut with the lowest
+             * total cost wins; it is applied only if it undercuts ``subdivisionthreshold`` times the
+             * predicted cost of the whole box. Each piece is then integrated with its own lattices
+             * (and subdivided further up to ``subdivisiondepth``) and the results are added.
+             */
+            template<typename return_t, typename real_t, typename qmc_t, typename functor_t, U maxdim>
+            ::integrators::result<return_t> integrate(qmc_t& integrator, QmcContainer<functor_t,real_t,maxdim>& box, const QmcSubdivision& options, U depth)
+            {
+                using std::sqrt;
+                using std::norm;
+
+                if (depth == 0)
+                    return integrator.integrate(box);
+
+                // one iteration on the whole box, ``maxeval = 1`` stops the Qmc after the first lattice
+                qmc_t first_iteration(integrator);
+                first_iteration.maxeval = 1;
+                first_iteration.verbosity = 0;
+                first_iteration.randomgenerator.seed(integrator.randomgenerator());
+                const ::integrators::result<return_t> first = first_iteration.integrate(box);
+                const real_t goal = error_goal(first.integral, static_cast<real_t>(integrator.epsrel), static_cast<real_t>(integrator.epsabs), integrator.errormode);
+                const real_t first_error = error_size(first.error);
+                if (first_error <= goal)
+                    return first;
+
+                qmc_t pilot(integrator);
+                pilot.evaluateminn = options.subdivisionminn;
+                pilot.verbosity = 0;
+                pilot.randomgenerator.seed(integrator.randomgenerator());
+                const ::integrators::samples<return_t,real_t> samples = pilot.evaluate(box);
+
+                // Without a split, the whole box is integrated as usual. The first iteration and the pilot
+                // lattice cannot be continued by the Qmc, so their evaluations are counted and taken from
+                // its budget; if nothing is left, the first iteration is the result.
+                const U spent_evaluations = first.evaluations + samples.n;
+                auto integrate_whole = [&] ()
+                {
+                    ::integrators::result<return_t> result = first;
+                    if (integrator.maxeval > spent_evaluations)
+                    {
+                        qmc_t whole(integrator);
+                        whole.maxeval = integrator.maxeval - spent_evaluations;
+                        whole.randomgenerator.seed(integrator.randomgenerator());
+                        result = whole.integrate(box);
+                        result.evaluations += spent_evaluations;
+                    }
+                    else
+                    {
+                        result.evaluations = spent_evaluations;
+                    }
+                    return result;
+                };
+
+                // finer cuts towards the boundaries, where integrable singularities live
+                constexpr unsigned nbins = 12;
+                constexpr U minimal_points_per_piece = 16;
+                const real_t edges[nbins+1] = {0., 1./64., 1./32., 1./16., 1./8., 1./4., 1./2., 3./4., 7./8., 15./16., 31./32., 63./64., 1.};
+
+                const unsigned dimension = box.number_of_integration_variables;
+                std::vector<U> count(dimension*nbins, 0);
+                std::vector<return_t> sum(dimension*nbins, return_t(0));
+                std::vector<real_t> sum_of_squares(dimension*nbins, 0);
+                return_t total_sum(0);
+                real_t total_sum_of_squares(0);
+                for (U i = 0; i < samples.n; ++i)
+                {
+                    const return_t& value = samples.r[i];
+                    const real_t square = norm(value);
+                    if ( ! std::isfinite(square) )
+                        return integrate_whole(); // leave the treatment of bad points to the integrator
+                    total_sum += value;
+                    total_sum_of_squares += square;
+                    for (unsigned j = 0; j < dimension; ++j)
+                    {
+                        const real_t x = samples.get_x(i,j);
+                        const unsigned bin = std::upper_bound(edges + 1, edges + nbins, x) - (edges + 1);
+                        count[j*nbins + bin] += 1;
+                        sum[j*nbins + bin] += value;
+                        sum_of_squares[j*nbins + bin] += square;
+                    }
+                }
+
+                // standard deviation of the integrand restricted to a piece of relative width ``width``
+                auto piece_sigma = [] (U points, const return_t& s, real_t s2, real_t width)
+                {
+                    const real_t variance = s2/points - norm(s/static_cast<real_t>(points));
+                    return width * sqrt(std::max(variance, real_t(0)));
+                };
+                const real_t sigma = piece_sigma(samples.n, total_sum, total_sum_of_squares, 1);
+                if ( ! (sigma > 0) )
+                    return integrate_whole();
+
+                // predicted number of evaluations to reach ``piece_goal`` for a piece of standard deviation ``piece_sigma``
+                const real_t first_evaluations = first.evaluations;
+                auto piece_cost = [first_evaluations, first_error, sigma] (real_t piece_sigma, real_t piece_goal)
+                {
+                    return first_evaluations * std::max(real_t(1), first_error*piece_sigma/(sigma*piece_goal));
+                };
+                const real_t unsplit_cost = piece_cost(sigma, goal);
+
+                real_t best_cost = options.subdivisionthreshold * unsplit_cost;
+                unsigned best_variable = dimension, best_cut = 0;
+                real_t best_sigma[2] = {0,0}, best_goal[2] = {0,0};
+                for (unsigned j = 0; j < dimension; ++j)
+                {
+                    if ( ! box.can_refine(j) )
+                        continue;
+                    U left_count = 0;
+                    return_t left_sum(0);
+                    real_t left_sum_of_squares(0);
+                    for (unsigned k = 1; k < nbins; ++k)
+                    {
+                        left_count += count[j*nbins + k-1];
+                        left_sum += sum[j*nbins + k-1];
+                        left_sum_of_squares += sum_of_squares[j*nbins + k-1];
+                        const U right_count = samples.n - left_count;
+                        if (left_count < minimal_points_per_piece || right_count < minimal_points_per_piece)
+                            continue;
+                        const real_t piece_sigmas[2] = {
+                            piece_sigma(left_count, left_sum, left_sum_of_squares, edges[k]),
+                            piece_sigma(right_count, total_sum - left_sum, total_sum_of_squares - left_sum_of_squares, 1 - edges[k])
+                        };
+                        const real_t cbrt_sigma[2] = { std::cbrt(piece_sigmas[0]), std::cbrt(piece_sigmas[1]) };
+                        const real_t normalization = sqrt(cbrt_sigma[0]*cbrt_sigma[0] + cbrt_sigma[1]*cbrt_sigma[1]);
+                        if (normalization == 0)
+                            continue;
+                        const real_t piece_goals[2] = { goal*cbrt_sigma[0]/normalization, goal*cbrt_sigma[1]/normalization };
+                        const real_t cost = piece_cost(piece_sigmas[0], piece_goals[0]) + piece_cost(piece_sigmas[1], piece_goals[1]);
+                        if (cost < best_cost)
+                        {
+                            best_cost = cost;
+                            best_variable = j;
+                            best_cut = k;
+                            for (int p = 0; p < 2; ++p)
+                            {
+                                best_sigma[p] = piece_sigmas[p];
+                                best_goal[p] = piece_goals[p];
+                            }
+                        }
+                    }
+                }
+
+                if (best_variable == dimension)
+                {
+                    if (integrator.verbosity > 0)
+                        integrator.logger << "qmc subdivision: no split lowers the predicted cost" << std::endl;
+                    return integrate_whole();
+                }
+
+                if (integrator.verbosity > 0)
+                    integrator.logger << "qmc subdivision: splitting variable " << best_variable << " at " << edges[best_cut]
+                                      << ", predicted cost ratio " << best_cost/unsplit_cost << std::endl;
+
+                // distribute the remaining evaluations like the predicted costs
+                const U remaining_evaluations = integrator.maxeval > spent_evaluations ? integrator.maxeval - spent_evaluations : 0;
+                const real_t cost_share = std::pow(best_sigma[0], real_t(2)/3) / (std::pow(best_sigma[0], real_t(2)/3) + std::pow(best_sigma[1], real_t(2)/3));
+
+                const real_t begin[2] = {0, edges[best_cut]}, end[2] = {edges[best_cut], 1};
+                ::integrators::result<return_t> total{return_t(0), return_t(0), 0, 0, 0, spent_evaluations};
+                for (int p = 0; p < 2; ++p)
+                {
+                    QmcContainer<functor_t,real_t,maxdim> piece_box = box.refine(best_variable, begin[p], end[p]);
+                    qmc_t piece(integrator);
+                    piece.epsrel = 0;
+                    piece.epsabs = best_goal[p];
+                    piece.maxeval = std::max(U(1), static_cast<U>((p == 0 ? cost_share : 1 - cost_share) * remaining_evaluations));
+                    piece.randomgenerator.seed(integrator.randomgenerator());
+                    const ::integrators::result<return_t> piece_result = subdivision::integrate<return_t,real_t>(piece, piece_box, options, depth - 1);
+                    total.integral += piece_result.integral;
+                    total.error = add_errors(total.error, piece_result.error);
+                    total.n = std::max(total.n, piece_result.n);
+                    total.m = std::max(total.m, piece_result.m);
+                    total.iterations += piece_result.iterations;
+                    total.evaluations += piece_result.evaluations;
+                }
+                return total;
+            };
+        };
 
         // base template
         template<
@@ -39,7 +380,7 @@ namespace secdecutil
                     typename container_t = secdecutil::IntegrandContainer<return_t, typename remove_complex<return_t>::type const * const>,
                     template<typename,typename,U> class fitfunction_t = void_template
                 >
-        struct Qmc : Integrator<return_t,return_t,container_t>, public ::integrators::Qmc<return_t,return_t,maxdim,transform_t,fitfunction_t>
+        struct Qmc : Integrator<return_t,return_t,container_t>, public ::integrators::Qmc<return_t,return_t,maxdim,transform_t,fitfunction_t>, public QmcSubdivision
         {
         protected:
 
@@ -75,10 +416,10 @@ namespace secdecutil
             };
 
             template<typename original_container_t>
-            Qmc( const Qmc<return_t,maxdim,transform_t,original_container_t,fitfunction_t>& original) : Integrator<return_t,return_t,container_t>(), ::integrators::Qmc<return_t,return_t,maxdim,transform_t,fitfunction_t>(original)
+            Qmc( const Qmc<return_t,maxdim,transform_t,original_container_t,fitfunction_t>& original) : Integrator<return_t,return_t,container_t>(), ::integrators::Qmc<return_t,return_t,maxdim,transform_t,fitfunction_t>(original), QmcSubdivision(original)
             {};
 
-            Qmc( const Qmc<return_t,maxdim,transform_t,container_t,fitfunction_t>& original) : Integrator<return_t,return_t,container_t>(), ::integrators::Qmc<return_t,return_t,maxdim,transform_t,fitfunction_t>(original)
+            Qmc( const Qmc<return_t,maxdim,transform_t,container_t,fitfunction_t>& original) : Integrator<return_t,return_t,container_t>(), ::integrators::Qmc<return_t,return_t,maxdim,transform_t,fitfunction_t>(original), QmcSubdivision(original)
             {};
         };
         template<typename return_t, U maxdim, template<typename,typename,U> class transform_t, typename container_t, template<typename,typename,U> class fitfunction_t>
@@ -86,8 +427,11 @@ namespace secdecutil
         {
             std::function<secdecutil::UncorrelatedDeviation<return_t>(const container_t&)> integrate_function = [this] (const container_t& integrand_container)
             {
-                QmcContainer<container_t> qmc_integrand_container(integrand_container);
-                ::integrators::result<return_t> result = ::integrators::Qmc<return_t,return_t,maxdim,transform_t,fitfunction_t>::integrate(qmc_integrand_container);
+                QmcContainer<container_t,return_t,maxdim> qmc_integrand_container(integrand_container);
+                ::integrators::result<return_t> result = subdivision::integrate<return_t,return_t>
+                (
+                    static_cast<::integrators::Qmc<return_t,return_t,maxdim,transform_t,fitfunction_t>&>(*this), qmc_integrand_container, *this, this->subdivisiondepth
+                );
                 integrand_container.process_errors();
                 return secdecutil::UncorrelatedDeviation<return_t> { result.integral, result.error };
             };
@@ -96,7 +440,7 @@ namespace secdecutil
 
         // default fitfunction
         template<typename return_t, U maxdim, template<typename,typename,U> class transform_t, typename container_t>
-        struct Qmc<return_t,maxdim,transform_t,container_t> : Integrator<return_t,return_t,container_t>, public ::integrators::Qmc<return_t,return_t,maxdim,transform_t>
+        struct Qmc<return_t,maxdim,transform_t,container_t> : Integrator<return_t,return_t,container_t>, public ::integrators::Qmc<return_t,return_t,maxdim,transform_t>, public QmcSubdivision
         {
         protected:
 
@@ -132,10 +476,10 @@ namespace secdecutil
             };
 
             template<typename original_container_t>
-            Qmc( const Qmc<return_t,maxdim,transform_t,original_container_t>& original) : Integrator<return_t,return_t,container_t>(), ::integrators::Qmc<return_t,return_t,maxdim,transform_t>(original)
+            Qmc( const Qmc<return_t,maxdim,transform_t,original_container_t>& original) : Integrator<return_t,return_t,container_t>(), ::integrators::Qmc<return_t,return_t,maxdim,transform_t>(original), QmcSubdivision(original)
             {};
 
-            Qmc( const Qmc<return_t,maxdim,transform_t,container_t>& original) : Integrator<return_t,return_t,container_t>(), ::integrators::Qmc<return_t,return_t,maxdim,transform_t>(original)
+            Qmc( const Qmc<return_t,maxdim,transform_t,container_t>& original) : Integrator<return_t,return_t,container_t>(), ::integrators::Qmc<return_t,return_t,maxdim,transform_t>(original), QmcSubdivision(original)
             {};
 
         };
@@ -144,8 +488,11 @@ namespace secdecutil
         {
             std::function<secdecutil::UncorrelatedDeviation<return_t>(const container_t&)> integrate_function = [this] (const container_t& integrand_container)
             {
-                QmcContainer<container_t> qmc_integrand_container(integrand_container);
-                ::integrators::result<return_t> result = ::integrators::Qmc<return_t,return_t,maxdim,transform_t>::integrate(qmc_integrand_container);
+                QmcContainer<container_t,return_t,maxdim> qmc_integrand_container(integrand_container);
+                ::integrators::result<return_t> result = subdivision::integrate<return_t,return_t>
+                (
+                    static_cast<::integrators::Qmc<return_t,return_t,maxdim,transform_t>&>(*this), qmc_integrand_container, *this, this->subdivisiondepth
+                );
                 integrand_container.process_errors();
                 return secdecutil::UncorrelatedDeviation<return_t> { result.integral, result.error };
             };
@@ -190,11 +537,13 @@ namespace secdecutil
                 template<typename original_container_t> \
                 Qmc( const Qmc<complex_template<return_t>,maxdim,transform_t,original_container_t,fitfunction_t>& original) : \
                     Integrator<complex_template<return_t>,return_t,container_t>(), \
-                    ::integrators::Qmc<complex_template<return_t>,return_t,maxdim,transform_t,fitfunction_t>(original) \
+                    ::integrators::Qmc<complex_template<return_t>,return_t,maxdim,transform_t,fitfunction_t>(original), \
+                    QmcSubdivision(original) \
                     { this->together = true; }; \
                 Qmc( const Qmc<complex_template<return_t>,maxdim,transform_t,container_t,fitfunction_t>& original) : \
                     Integrator<complex_template<return_t>,return_t,container_t>(), \
-                    ::integrators::Qmc<complex_template<return_t>,return_t,maxdim,transform_t,fitfunction_t>(original) \
+                    ::integrators::Qmc<complex_template<return_t>,return_t,maxdim,transform_t,fitfunction_t>(original), \
+                    QmcSubdivision(original) \
                     { this->together = true; };
 
         #define COMPLEX_QMC_BODY_WITHOUT_FITFUNCTION(complex_template) \
@@ -230,11 +579,13 @@ namespace secdecutil
                 template<typename original_container_t> \
                 Qmc( const Qmc<complex_template<return_t>,maxdim,transform_t,original_container_t>& original) : \
                     Integrator<complex_template<return_t>,return_t,container_t>(), \
-                    ::integrators::Qmc<complex_template<return_t>,return_t,maxdim,transform_t>(original) \
+                    ::integrators::Qmc<complex_template<return_t>,return_t,maxdim,transform_t>(original), \
+                    QmcSubdivision(original) \
                     { this->together = true; }; \
                 Qmc( const Qmc<complex_template<return_t>,maxdim,transform_t,container_t>& original) : \
                     Integrator<complex_template<return_t>,return_t,container_t>(), \
-                    ::integrators::Qmc<complex_template<return_t>,return_t,maxdim,transform_t>(original) \
+                    ::integrators::Qmc<complex_template<return_t>,return_t,maxdim,transform_t>(original), \
+                    QmcSubdivision(original) \
                     { this->together = true; };
 
         #define COMPLEX_QMC_GET_TOGETHER_INTEGRATE_WITH_FITFUNCTION(complex_template) \
@@ -244,8 +595,11 @@ namespace secdecutil
             { \
                 std::function<secdecutil::UncorrelatedDeviation<complex_template<return_t>>(const container_t&)> integrate_function = [this] (const container_t& integrand_container) \
                 { \
-                    QmcContainer<container_t> qmc_integrand_container(integrand_container); \
-                    ::integrators::result<complex_template<return_t>> result = ::integrators::Qmc<complex_template<return_t>,return_t,maxdim,transform_t,fitfunction_t>::integrate(qmc_integrand_container); \
+                    QmcContainer<container_t,return_t,maxdim> qmc_integrand_container(integrand_container); \
+                    ::integrators::result<complex_template<return_t>> result = subdivision::integrate<complex_template<return_t>,return_t> \
+                    ( \
+                        static_cast<::integrators::Qmc<complex_template<return_t>,return_t,maxdim,transform_t,fitfunction_t>&>(*this), qmc_integrand_container, *this, this->subdivisiondepth \
+                    ); \
                     integrand_container.process_errors(); \
                     return secdecutil::UncorrelatedDeviation<complex_template<return_t>> { result.integral, result.error }; \
                 }; \
@@ -258,8 +612,11 @@ namespace secdecutil
             { \
                 std::function<secdecutil::UncorrelatedDeviation<complex_template<return_t>>(const container_t&)> integrate_function = [this] (const container_t& integrand_container) \
                 { \
-                    QmcContainer<container_t> qmc_integrand_container(integrand_container); \
-                    ::integrators::result<complex_template<return_t>> result = ::integrators::Qmc<complex_template<return_t>,return_t,maxdim,transform_t>::integrate(qmc_integrand_container); \
+                    QmcContainer<container_t,return_t,maxdim> qmc_integrand_container(integrand_container); \
+                    ::integrators::result<complex_template<return_t>> result = subdivision::integrate<complex_template<return_t>,return_t> \
+                    ( \
+                        static_cast<::integrators::Qmc<complex_template<return_t>,return_t,maxdim,transform_t>&>(*this), qmc_integrand_container, *this, this->subdivisiondepth \
+                    ); \
                     integrand_container.process_errors(); \
                     return secdecutil::UncorrelatedDeviation<complex_template<return_t>> { result.integral, result.error }; \
                 }; \
@@ -268,7 +625,7 @@ namespace secdecutil
 
         template<typename return_t, U maxdim, template<typename,typename,U> class transform_t, typename container_t, template<typename,typename,U> class fitfunction_t>
         struct Qmc<std::complex<return_t>,maxdim,transform_t,container_t,fitfunction_t> : Integrator<std::complex<return_t>,return_t,container_t>,
-            public ::integrators::Qmc<std::complex<return_t>,return_t,maxdim,transform_t,fitfunction_t>
+            public ::integrators::Qmc<std::complex<return_t>,return_t,maxdim,transform_t,fitfunction_t>, public QmcSubdivision
         {
             COMPLEX_QMC_BODY(std::complex)
         };
@@ -276,7 +633,7 @@ namespace secdecutil
 
         template<typename return_t, U maxdim, template<typename,typename,U> class transform_t, typename container_t>
         struct Qmc<std::complex<return_t>,maxdim,transform_t,container_t> : Integrator<std::complex<return_t>,return_t,container_t>,
-            public ::integrators::Qmc<std::complex<return_t>,return_t,maxdim,transform_t>
+            public ::integrators::Qmc<std::complex<return_t>,return_t,maxdim,transform_t>, public QmcSubdivision
         {
             COMPLEX_QMC_BODY_WITHOUT_FITFUNCTION(std::complex)
         };
@@ -285,7 +642,7 @@ namespace secdecutil
         #ifdef SECDEC_WITH_CUDA
             template<typename return_t, U maxdim, template<typename,typename,U> class transform_t, typename container_t, template<typename,typename,U> class fitfunction_t>
             struct Qmc<thrust::complex<return_t>,maxdim,transform_t,container_t,fitfunction_t> : Integrator<thrust::complex<return_t>,return_t,container_t>,
-                public ::integrators::Qmc<thrust::complex<return_t>,return_t,maxdim,transform_t,fitfunction_t>
+                public ::integrators::Qmc<thrust::complex<return_t>,return_t,maxdim,transform_t,fitfunction_t>, public QmcSubdivision
             {
                 COMPLEX_QMC_BODY(thrust::complex)
             };
@@ -293,7 +650,7 @@ namespace secdecutil
 
             template<typename return_t, U maxdim, template<typename,typename,U> class transform_t, typename container_t>
             struct Qmc<thrust::complex<return_t>,maxdim,transform_t,container_t> : Integrator<thrust::complex<return_t>, return_t, container_t>,
-                public ::integrators::Qmc<thrust::complex<return_t>,return_t,maxdim,transform_t>
+                public ::integrators::Qmc<thrust::complex<return_t>,return_t,maxdim,transform_t>, public QmcSubdivision
             {
                 COMPLEX_QMC_BODY_WITHOUT_FITFUNCTION(thrust::complex)
             };
@@ -304,6 +661,383 @@ namespace secdecutil
         #undef COMPLEX_QMC_BODY_WITH_FITFUNCTION
         #undef COMPLEX_QMC_BODY_WITHOUT_FITFUNCTION
 
+        /*
+         * Integration of several integrands on the same lattice points
+         *
+         * "integrate_together" integrates K integrands of the same dimension (e.g. the
+         * orders of one sector, or one sector at several kinematic points) with the
+         * settings of a Qmc integrator. The lattice points, the random shifts and the
+         * weights of the periodizing transform are computed once per point for all
+         * integrands; each integrand keeps its own sums per shift, its own error
+         * estimate and its own convergence flag. The lattice grows with the largest
+         * error ratio of the integrands that have not converged yet, and integrands
+         * that have converged are no longer evaluated.
+         *
+         * The points are evaluated on "cputhreads" CPU threads. Median lattices are
+         * not constructed, and the fit function of the integrator is not applied.
+         */
+        namespace multi_integrand
+        {
+            // Stands in for the integrand of a transform: the transform maps the point
+            // in place, and returns its weight times the value 1 returned here.
+            template<typename real_t>
+            struct TransformProbe
+            {
+                U number_of_integration_variables;
+                real_t operator()(real_t* x) const { return real_t(1); };
+            };
+
+            // Add the sums over the points [begin, end) of all shifts of the "active"
+            // integrands to "sums" (shift-major, then active integrand).
+            template<typename return_t, typename real_t, typename transform_t, typename container_t>
+            void sample_range(transform_t transform, const std::vector<container_t>& integrands, const std::vector<size_t>& active,
+                              const std::vector<U>& z, const std::vector<real_t>& d, U n, U m, U begin, U end, std::vector<return_t>& sums)
+            {
+                using std::modf;
+                const U dimension = z.size();
+                std::vector<real_t> x(dimension);
+                real_t integer_part;
+                for (U k = 0; k < m; ++k)
+                {
+                    for (U i = begin; i < end; ++i)
+                    {
+                        for (U s = 0; s < dimension; ++s)
+                            x[s] = modf(::integrators::math::mul_mod<real_t,real_t>(i, z[s], n)/static_cast<real_t>(n) + d[k*dimension + s], &integer_part);
+                        const real_t weight = transform(x.data());
+                        for (size_t c = 0; c < active.size(); ++c)
+                            sums[k*active.size() + c] += weight*integrands[active[c]](x.data());
+                    }
+                }
+            };
+        };
+
+        template<
+                    typename return_t, typename real_t, U maxdim, template<typename,typename,U> class transform_t,
+                    template<typename,typename,U> class fitfunction_t, typename G, typename H, typename container_t
+                >
+        std::vector<secdecutil::UncorrelatedDeviation<return_t>> integrate_together
+        (
+            ::integrators::Qmc<return_t,real_t,maxdim,transform_t,fitfunction_t,G,H>& integrator, const std::vector<container_t>& integrands
+        )
+        {
+            using probe_t = multi_integrand::TransformProbe<real_t>;
+
+            const size_t count = integrands.size();
+            if (count == 0)
+                return {};
+            const U dimension = std::max(1, integrands.front().number_of_integration_variables);
+            for (const container_t& integrand : integrands)
+                if (static_cast<U>(std::max(1, integrand.number_of_integration_variables)) != dimension)
+                    throw std::invalid_argument("integrate_together: the integrands must have the same number of integration variables.");
+            if (dimension > maxdim)
+                throw std::invalid_argument("integrate_together: the number of integration variables is larger than maxdim.");
+            if (integrator.minm < 2)
+                throw std::domain_error("integrate_together: minm must be at least 2.");
+
+            const transform_t<probe_t,real_t,maxdim> transform(probe_t{dimension});
+            std::uniform_real_distribution<real_t> uniform(0, 1);
+            const U threads = std::max(U(1), integrator.cputhreads);
+
+            // the state of each integrand, see "::integrators::Qmc::reduce"
+            std::vector<::integrators::result<return_t>> results(count, {return_t(0), return_t(0), 0, 0, 0, 0});
+            std::vector<return_t> means(count, return_t(0)), variances(count, return_t(0));
+            std::vector<bool> converged(count, false);
+
+            U n = integrator.get_next_n(integrator.minn, false);
+            U m = integrator.minm;
+            for (;;)
+            {
+                std::vector<size_t> active;
+                for (size_t c = 0; c < count; ++c)
+                    if ( ! converged[c] && (results[c].iterations == 0 || results[c].evaluations < integrator.maxeval) )
+                        active.push_back(c);
+                if (active.empty())
+                    break;
+
+                std::vector<U> z = integrator.generatingvectors.at(n);
+                if (z.size() < dimension)
+                    throw std::domain_error("integrate_together: the generating vector has fewer dimensions than the integrands.");
+                z.resize(dimension);
+                std::vector<real_t> d(m*dimension);
+                for (real_t& shift : d)
+                    shift = uniform(integrator.randomgenerator);
+
+                std::vector<std::vector<return_t>> thread_sums(threads, std::vector<return_t>(m*active.size(), return_t(0)));
+                std::vector<std::thread> pool;
+                std::exception_ptr exception = nullptr;
+                std::mutex exception_mutex;
+                const U points_per_thread = (n + threads - 1)/threads;
+                for (U t = 0; t < threads; ++t)
+                {
+                    const U begin = std::min(n, t*points_per_thread), end = std::min(n, (t+1)*points_per_thread);
+                    pool.emplace_back([&, t, begin, end] ()
+                    {
+                        try
+                        {
+                            multi_integrand::sample_range(transform, integrands, active, z, d, n, m, begin, end, thread_sums[t]);
+                        }
+                        catch (...)
+                        {
+                            std::lock_guard<std::mutex> lock(exception_mutex);
+                            exception = std::current_exception();
+                        }
+                    });
+                }
+                for (std::thread& thread : pool)
+                    thread.join();
+                if (exception)
+                    std::rethrow_exception(exception);
+
+                // the error ratio and the number of shifts of the least converged integrand
+                real_t worst_error_ratio = 0;
+                U worst_shifts = m;
+                for (size_t a = 0; a < active.size(); ++a)
+                {
+                    const size_t c = active[a];
+                    ::integrators::result<return_t>& res = results[c];
+                    // continue the online mean and variance of the previous iteration if the lattice is the same
+                    U previous_m = 0;
+                    if (res.n == n)
+                        previous_m = res.m;
+                    else
+                        means[c] = variances[c] = return_t(0);
+                    for (U k = 0; k < m; ++k)
+                    {
+                        return_t sum(0);
+                        for (U t = 0; t < threads; ++t)
+                            sum += thread_sums[t][k*active.size() + a];
+                        const return_t delta = sum - means[c];
+                        means[c] = means[c] + delta/static_cast<return_t>(k+previous_m+1);
+                        variances[c] = ::integrators::overloads::compute_variance(means[c], variances[c], sum, delta);
+                    }
+                    const U shifts = m + previous_m;
+                    const return_t variance = variances[c]/(static_cast<return_t>(shifts-1)*static_cast<return_t>(shifts)*static_cast<return_t>(n)*static_cast<return_t>(n));
+                    res = {means[c]/static_cast<return_t>(n), ::integrators::overloads::compute_error(variance), n, shifts, res.iterations+1, res.evaluations+n*m};
+                    const real_t error_ratio = ::integrators::overloads::compute_error_ratio(res, static_cast<real_t>(integrator.epsrel), static_cast<real_t>(integrator.epsabs), integrator.errormode);
+                    if (error_ratio <= 1)
+                        converged[c] = true;
+                    else if (res.evaluations < integrator.maxeval && (std::isnan(error_ratio) ? real_t(20) : error_ratio) > worst_error_ratio)
+                    {
+                        worst_error_ratio = std::isnan(error_ratio) ? real_t(20) : error_ratio;
+                        worst_shifts = shifts;
+                    }
+                    if (integrator.verbosity > 1)
+                        integrator.logger << "integrand " << c << ": integral " << res.integral << ", error " << res.error << ", n " << n << ", m " << shifts << (converged[c] ? ", converged" : "") << std::endl;
+                }
+                if ( ! (worst_error_ratio > 1) )
+                    break;
+
+                // the same update of n and m as in "::integrators::Qmc::update", driven by the least converged integrand
+                const real_t error_ratio = std::min(worst_error_ratio, real_t(20));
+                U new_n = integrator.get_next_n(static_cast<U>(n*std::pow(error_ratio, real_t(1)/real_t(0.8))), false);
+                U new_m = integrator.minm;
+                if (new_n <= n || error_ratio*error_ratio - 1 < static_cast<real_t>(new_n)/n)
+                {
+                    // the variance decreases with the accumulated number of shifts on this lattice
+                    new_n = n;
+                    new_m = static_cast<U>(worst_shifts*error_ratio*error_ratio) + 1 - worst_shifts;
+                }
+                U spent = 0;
+                for (size_t c : active)
+                    if ( ! converged[c] )
+                        spent = std::max(spent, results[c].evaluations);
+                if (integrator.maxeval < spent + new_n*new_m)
+                    new_n = std::max(n, integrator.get_next_n((integrator.maxeval - spent)/new_m, false));
+                if (n == new_n && integrator.maxeval < spent + new_n*new_m)
+                    new_m = std::max(U(1), (integrator.maxeval - spent)/new_n);
+                n = new_n;
+                m = new_m;
+            }
+
+            std::vector<secdecutil::UncorrelatedDeviation<return_t>> integrals;
+            for (size_t c = 0; c < count; ++c)
+            {
+                integrands[c].process_errors();
+                integrals.push_back({results[c].integral, results[c].error});
+            }
+            return integrals;
+        };
+
+        /*
+         * Selection of the periodizing transform
+         *
+         * "QmcTransformSelection" holds one Qmc integrator per candidate transform
+         * and integrates each integrand with the candidate that promises the lowest
+         * cost: every candidate integrates the integrand on its first lattice only
+         * (a copy with "maxeval = 1"), and since the Qmc error falls at least like
+         * 1/n for a transform that suits the integrand, the time needed for a given
+         * accuracy is proportional to error times time of this pilot run. The
+         * candidate with the smallest product integrates to the requested accuracy.
+         * Its pilot result is returned as is if it is accurate enough already, and
+         * is otherwise averaged with the final result, weighted by the inverse
+         * variances. The pilots draw their own random shifts, so that the two results
+         * are independent.
+         *
+         * The amplitude interface uses "integrators" and "names" to select the
+         * transform once per integral and to keep it for all later refinements,
+         * see "secdecutil::amplitude::TransformSelectingIntegral".
+         */
+        namespace transform_selection
+        {
+            // index of the candidate with the smallest error times time, the first one if none is finite
+            template<typename real_t>
+            size_t select(const std::vector<real_t>& errors, const std::vector<real_t>& times)
+            {
+                size_t best = 0;
+                real_t best_cost = std::numeric_limits<real_t>::infinity();
+                for (size_t i = 0; i < errors.size(); ++i)
+                {
+                    real_t cost = errors.at(i) * times.at(i);
+                    if (cost < best_cost) // false for NaN
+                    {
+                        best = i;
+                        best_cost = cost;
+                    }
+                }
+                return best;
+            };
+
+            // inverse-variance weighted mean of two independent results of the same integral,
+            // "b" if "a" is not finite or either error is zero
+            template<typename real_t>
+            secdecutil::UncorrelatedDeviation<real_t> combine(const secdecutil::UncorrelatedDeviation<real_t>& a, const secdecutil::UncorrelatedDeviation<real_t>& b)
+            {
+                using std::isfinite;
+                using std::sqrt;
+                if (!(isfinite(a.value) && isfinite(a.uncertainty) && a.uncertainty > 0 && b.uncertainty > 0))
+                    return b;
+                const real_t wa = 1/(a.uncertainty*a.uncertainty), wb = 1/(b.uncertainty*b.uncertainty);
+                return {(wa*a.value + wb*b.value)/(wa + wb), 1/sqrt(wa + wb)};
+            };
+
+            // complex numbers: real and imaginary part are averaged separately
+            template<template<typename> class complex_template, typename real_t>
+            secdecutil::UncorrelatedDeviation<complex_template<real_t>> combine_complex(const secdecutil::UncorrelatedDeviation<complex_template<real_t>>& a, const secdecutil::UncorrelatedDeviation<complex_template<real_t>>& b)
+            {
+                using real_ud_t = secdecutil::UncorrelatedDeviation<real_t>;
+                const real_ud_t re = combine(real_ud_t(a.value.real(), a.uncertainty.real()), real_ud_t(b.value.real(), b.uncertainty.real()));
+                const real_ud_t im = combine(real_ud_t(a.value.imag(), a.uncertainty.imag()), real_ud_t(b.value.imag(), b.uncertainty.imag()));
+                return {complex_template<real_t>(re.value, im.value), complex_template<real_t>(re.uncertainty, im.uncertainty)};
+            };
+            template<typename real_t>
+            secdecutil::UncorrelatedDeviation<std::complex<real_t>> combine(const secdecutil::UncorrelatedDeviation<std::complex<real_t>>& a, const secdecutil::UncorrelatedDeviation<std::complex<real_t>>& b)
+            {
+                return combine_complex<std::complex>(a, b);
+            };
+            #ifdef SECDEC_WITH_CUDA
+                template<typename real_t>
+                secdecutil::UncorrelatedDeviation<thrust::complex<real_t>> combine(const secdecutil::UncorrelatedDeviation<thrust::complex<real_t>>& a, const secdecutil::UncorrelatedDeviation<thrust::complex<real_t>>& b)
+                {
+                    return combine_complex<thrust::complex>(a, b);
+                };
+            #endif
+        };
+
+        template<typename return_t, typename input_t, typename container_t>
+        struct QmcTransformSelectionBase
+        {
+            using integrator_t = Integrator<return_t,input_t,container_t>;
+            using real_t = typename remove_complex<return_t>::type;
+
+            std::vector<std::string> names;
+            std::vector<std::shared_ptr<integrator_t>> integrators; // the candidates
+            std::vector<std::shared_ptr<integrator_t>> pilots; // copies of the candidates that stop after the first lattice
+            std::vector<std::function<bool(const secdecutil::UncorrelatedDeviation<return_t>&)>> accurate; // whether a result meets the goal of the candidate
+            U verbosity = 0;
+
+            // take ownership of "integrator"
+            template<typename qmc_t>
+            void add_candidate(const std::string& name, qmc_t* integrator)
+            {
+                std::shared_ptr<qmc_t> pilot = std::make_shared<qmc_t>(*integrator);
+                pilot->maxeval = 1;
+                pilot->verbosity = 0;
+                pilot->subdivisiondepth = 0;
+                pilot->randomgenerator.seed(integrator->randomgenerator());
+                names.push_back(name);
+                integrators.emplace_back(integrator);
+                pilots.push_back(pilot);
+                accurate.push_back([integrator] (const secdecutil::UncorrelatedDeviation<return_t>& result)
+                {
+                    return subdivision::error_size(result.uncertainty) <= subdivision::error_goal(result.value,
+                        static_cast<real_t>(integrator->epsrel), static_cast<real_t>(integrator->epsabs), integrator->errormode);
+                });
+            };
+
+            // the pilot results are stored in "results"
+            size_t select(const container_t& integrand_container, std::vector<secdecutil::UncorrelatedDeviation<return_t>>& results)
+            {
+                if (integrators.empty())
+                    throw std::invalid_argument("QmcTransformSelection: no candidate transforms.");
+                std::vector<real_t> errors, times;
+                results.clear();
+                for (auto& pilot : pilots)
+                {
+                    auto start_time = std::chrono::steady_clock::now();
+                    results.push_back(pilot->integrate(integrand_container));
+                    auto end_time = std::chrono::steady_clock::now();
+                    errors.push_back(subdivision::error_size(results.back().uncertainty));
+                    times.push_back(std::chrono::duration<real_t>(end_time - start_time).count());
+                }
+                size_t best = transform_selection::select(errors, times);
+                if (verbosity > 0)
+                    std::cerr << "QmcTransformSelection: selected transform " << names.at(best) << std::endl;
+                return best;
+            };
+
+            size_t select(const container_t& integrand_container)
+            {
+                std::vector<secdecutil::UncorrelatedDeviation<return_t>> results;
+                return select(integrand_container, results);
+            };
+
+            secdecutil::UncorrelatedDeviation<return_t> select_and_integrate(const container_t& integrand_container)
+            {
+                std::vector<secdecutil::UncorrelatedDeviation<return_t>> results;
+                const size_t best = select(integrand_container, results);
+                if (accurate.at(best)(results.at(best)))
+                    return results.at(best);
+                return transform_selection::combine(results.at(best), integrators.at(best)->integrate(integrand_container));
+            };
+        };
+
+        template<typename return_t, typename input_t, typename container_t = secdecutil::IntegrandContainer<return_t, input_t const * const>>
+        struct QmcTransformSelection : Integrator<return_t,input_t,container_t>, public QmcTransformSelectionBase<return_t,input_t,container_t>
+        {
+        protected:
+
+            std::function<secdecutil::UncorrelatedDeviation<return_t>(const container_t&)> get_integrate() override
+            {
+                return [this] (const container_t& integrand_container) { return this->select_and_integrate(integrand_container); };
+            };
+
+        public:
+
+            static constexpr bool cuda_compliant_integrator = false;
+
+        };
+
+        #define COMPLEX_QMC_TRANSFORM_SELECTION(complex_template) \
+            template<typename return_t, typename input_t, typename container_t> \
+            struct QmcTransformSelection<complex_template<return_t>,input_t,container_t> : Integrator<complex_template<return_t>,input_t,container_t>, \
+                public QmcTransformSelectionBase<complex_template<return_t>,input_t,container_t> \
+            { \
+            protected: \
+                std::function<secdecutil::UncorrelatedDeviation<complex_template<return_t>>(const container_t&)> get_together_integrate() override \
+                { \
+                    return [this] (const container_t& integrand_container) { return this->select_and_integrate(integrand_container); }; \
+                }; \
+            public: \
+                static constexpr bool cuda_compliant_integrator = false; \
+                QmcTransformSelection() { this->together = true; }; \
+            };
+
+        COMPLEX_QMC_TRANSFORM_SELECTION(std::complex)
+        #ifdef SECDEC_WITH_CUDA
+            COMPLEX_QMC_TRANSFORM_SELECTION(thrust::complex)
+        #endif
+        #undef COMPLEX_QMC_TRANSFORM_SELECTION
+
     };
 
 }
@@ -9,6 +9,7 @@
 #include <secdecutil/deep_apply.hpp> // deep_apply
 #include <secdecutil/integrators/cquad.hpp> // CQuad
 #include <secdecutil/integrators/qmc.hpp> // Qmc
+#include <secdecutil/integrators/digital_net.hpp> // DigitalNet
 #include <secdecutil/integrators/cuba.hpp> // Vegas, Suave, Divonne, Cuhre
 
 #if integral_need_complex 
@@ -154,6 +155,40 @@ extern "C"
         SET_INTEGRATOR_TOGETHER_OPTION_IF_COMPLEX();
         return integrator;
     }
+    secdecutil::Integrator<integrand_return_t,real_t> *
+    allocate_integrators_DigitalNet(
+                                        double epsrel,
+                                        double epsabs,
+                                        unsigned long long int maxeval,
+                                        unsigned long long int minn,
+                                        unsigned long long int minm,
+                                        unsigned int order,
+                                        long long int cputhreads,
+                                        unsigned long long int verbosity,
+                                        long long int seed
+                                   )
+    {
+        auto integrator = new secdecutil::integrators::DigitalNet<integrand_return_t>;
+        /* If an argument is set to 0 then use the default of the integrator */
+        if ( epsrel != 0 )
+            integrator->epsrel = epsrel;
+        if ( epsabs != 0 )
+            integrator->epsabs = epsabs;
+        if ( maxeval != 0 )
+            integrator->maxeval = maxeval;
+        if ( minn != 0 )
+            integrator->minn = minn;
+        if ( minm != 0 )
+            integrator->minm = minm;
+        if ( order != 0 )
+            integrator->order = order;
+        if ( cputhreads != -1 )
+            integrator->cputhreads = cputhreads;
+        integrator->verbosity = verbosity;
+        if ( seed != 0 )
+            integrator->randomgenerator.seed(seed);
+        return integrator;
+    }
     // qmc allocate function prototypes (implementation is done in pylink.cpp)
     #define COMMON_ALLOCATE_QMC_ARGS \
     double epsrel, \
@@ -175,7 +210,10 @@ extern "C"
     int generatingvectors_id, \
     unsigned long long int lattice_candidates, \
     bool standard_lattices, \
-    bool keep_lattices
+    bool keep_lattices, \
+    unsigned long long int subdivision_depth, \
+    unsigned long long int subdivision_minn, \
+    double subdivision_threshold
     #ifdef SECDEC_WITH_CUDA
         secdecutil::Integrator<integrand_return_t,real_t,cuda_together_integrand_t> *
         allocate_cuda_integrators_Qmc_together(
@@ -212,4 +250,122 @@ extern "C"
 
 }
 
+/*
+ * integrator allocation from a description
+ * "<allocate function without the "allocate_" prefix> <arguments>",
+ * e.g. "gsl_cquad 0.01 1e-07 100 0 0.0", as sent to the workers of
+ * "compute_integral" (see pylink_amplitude.hpp)
+ */
+namespace
+{
+    secdecutil::Integrator<integrand_return_t,real_t> * read_integrator(std::istream& description)
+    {
+        std::string name;
+        description >> name;
+        if ( name == "MultiIntegrator" )
+        {
+            int critical_dim;
+            description >> critical_dim;
+            // the MultiIntegrator refers to its integrators, keep them alive
+            secdecutil::Integrator<integrand_return_t,real_t> * low_dim_integrator = read_integrator(description);
+            secdecutil::Integrator<integrand_return_t,real_t> * high_dim_integrator = read_integrator(description);
+            if ( !low_dim_integrator || !high_dim_integrator )
+                return nullptr;
+            return allocate_MultiIntegrator(low_dim_integrator,high_dim_integrator,critical_dim);
+        }
+        if ( name == "gsl_cquad" )
+        {
+            double epsrel, epsabs, zero_border;
+            unsigned int n;
+            bool verbose;
+            description >> epsrel >> epsabs >> n >> verbose >> zero_border;
+            if ( description )
+                return allocate_gsl_cquad(epsrel,epsabs,n,verbose,zero_border);
+        }
+        if ( name == "cuba_Vegas" )
+        {
+            double epsrel, epsabs, zero_border;
+            int flags, seed;
+            long long int mineval, maxeval, nstart, nincrease, nbatch;
+            bool real_complex_together;
+            description >> epsrel >> epsabs >> flags >> seed >> mineval >> maxeval >> zero_border >> nstart >> nincrease >> nbatch >> real_complex_together;
+            if ( description )
+                return allocate_cuba_Vegas(epsrel,epsabs,flags,seed,mineval,maxeval,zero_border,nstart,nincrease,nbatch,real_complex_together);
+        }
+        if ( name == "cuba_Suave" )
+        {
+            double epsrel, epsabs, zero_border, flatness;
+            int flags, seed;
+            long long int mineval, maxeval, nnew, nmin;
+            bool real_complex_together;
+            description >> epsrel >> epsabs >> flags >> seed >> mineval >> maxeval >> zero_border >> nnew >> nmin >> flatness >> real_complex_together;
+            if ( description )
+                return allocate_cuba_Suave(epsrel,epsabs,flags,seed,mineval,maxeval,zero_border,nnew,nmin,flatness,real_complex_together);
+        }
+        if ( name == "cuba_Divonne" )
+        {
+            double epsrel, epsabs, zero_border, border, maxchisq, mindeviation;
+            int flags, seed, key1, key2, key3, maxpass;
+            long long int mineval, maxeval;
+            bool real_complex_together;
+            description >> epsrel >> epsabs >> flags >> seed >> mineval >> maxeval >> zero_border >> key1 >> key2 >> key3 >> maxpass
+                        >> border >> maxchisq >> mindeviation >> real_complex_together;
+            if ( description )
+                return allocate_cuba_Divonne(epsrel,epsabs,flags,seed,mineval,maxeval,zero_border,key1,key2,key3,maxpass,
+                                             border,maxchisq,mindeviation,real_complex_together);
+        }
+        if ( name == "cuba_Cuhre" )
+        {
+            double epsrel, epsabs, zero_border;
+            int flags, key;
+            long long int mineval, maxeval;
+            bool real_complex_together;
+            description >> epsrel >> epsabs >> flags >> mineval >> maxeval >> zero_border >> key >> real_complex_together;
+            if ( description )
+                return allocate_cuba_Cuhre(epsrel,epsabs,flags,mineval,maxeval,zero_border,key,real_complex_together);
+        }
+        if ( name == "integrators_DigitalNet" )
+        {
+            double epsrel, epsabs;
+            unsigned long long int maxeval, minn, minm, verbosity;
+            unsigned int order;
+            long long int cputhreads, seed;
+            description >> epsrel >> epsabs >> maxeval >> minn >> minm >> order >> cputhreads >> verbosity >> seed;
+            if ( description )
+                return allocate_integrators_DigitalNet(epsrel,epsabs,maxeval,minn,minm,order,cputhreads,verbosity,seed);
+        }
+        #ifndef SECDEC_WITH_CUDA
+            if ( name == "integrators_Qmc" )
+            {
+                double epsrel, epsabs, subdivision_threshold;
+                unsigned long long int maxeval, evaluateminn, minn, minm, maxnperpackage, maxmperpackage, cudablocks, cudathreadsperblock,
+                                       verbosity, lattice_candidates, subdivision_depth, subdivision_minn;
+                int errormode, transform_id, fitfunction_id, generatingvectors_id;
+                long long int cputhreads, seed;
+                bool standard_lattices, keep_lattices;
+                description >> epsrel >> epsabs >> maxeval >> errormode >> evaluateminn >> minn >> minm >> maxnperpackage >> maxmperpackage
+                            >> cputhreads >> cudablocks >> cudathreadsperblock >> verbosity >> seed >> transform_id >> fitfunction_id
+                            >> generatingvectors_id >> lattice_candidates >> standard_lattices >> keep_lattices >> subdivision_depth
+                            >> subdivision_minn >> subdivision_threshold;
+                if ( description )
+                    return allocate_integrators_Qmc(epsrel,epsabs,maxeval,errormode,evaluateminn,minn,minm,maxnperpackage,maxmperpackage,
+                                                    cputhreads,cudablocks,cudathreadsperblock,verbosity,seed,transform_id,fitfunction_id,
+                                                    generatingvectors_id,lattice_candidates,standard_lattices,keep_lattices,
+                                                    subdivision_depth,subdivision_minn,subdivision_threshold);
+            }
+        #endif
+        std::cerr << "Can not allocate the integrator \"" << name << "\" from its description." << std::endl;
+        return nullptr;
+    }
+}
+
+extern "C"
+{
+    secdecutil::Integrator<integrand_return_t,real_t> * allocate_integrator(const char * description)
+    {
+        std::istringstream stream(description);
+        return read_integrator(stream);
+    }
+}
+
 #endif
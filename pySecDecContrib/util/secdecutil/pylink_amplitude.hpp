@@ -3,12 +3,13 @@
 
 #include <iostream>
 #include <limits> // std::numeric_limits
-#include <memory> // std::unique_ptr
+#include <memory> // std::unique_ptr, std::make_shared
 #include <numeric> // std::accumulate
 #include <string>
 #include <sstream>
 #include <vector>
 
+#include <secdecutil/amplitude.hpp> // ProcessExecutor
 #include <secdecutil/deep_apply.hpp> // deep_apply
 #include <secdecutil/series.hpp> // Series
 #include <secdecutil/uncertainties.hpp> // UncorrelatedDeviation
@@ -21,6 +22,51 @@
 #define EXPAND_STRINGIFY(item) STRINGIFY(item)
 #define STRINGIFY(item) #item
 
+/*
+ * Let the workers started by the shell commands in "workers" (one per line)
+ * compute the integrals of "amplitudes". Every worker (see worker_<name>.cpp)
+ * first reads the setup below, rebuilds the same amplitudes from it and then
+ * serves the requests of the "secdecutil::amplitude::ProcessExecutor":
+ *
+ *     <description of the integrator, see "allocate_integrator">
+ *     <real parameters> <real and imaginary part of the complex parameters>
+ *     <deformation parameters maximum> <minimum> <decrease factor>
+ *     <lib_path>
+ */
+template<typename amplitudes_handler_t>
+void add_workers
+(
+    amplitudes_handler_t& amplitudes,
+    const std::string& workers,
+    const std::string& integrator_description,
+    const std::vector<real_t>& real_parameters,
+    const std::vector<complex_t>& complex_parameters,
+    const real_t deformation_parameters_maximum,
+    const real_t deformation_parameters_minimum,
+    const real_t deformation_parameters_decrease_factor,
+    const std::string& lib_path
+)
+{
+    std::stringstream setup;
+    setup.precision(std::numeric_limits<real_t>::max_digits10);
+    setup << std::scientific << integrator_description << "\n";
+    for (const real_t& parameter : real_parameters)
+        setup << parameter << " ";
+    for (const complex_t& parameter : complex_parameters)
+        setup << parameter.real() << " " << parameter.imag() << " ";
+    setup << "\n";
+    setup << deformation_parameters_maximum << " " << deformation_parameters_minimum << " " << deformation_parameters_decrease_factor << "\n";
+    setup << lib_path << "\n";
+
+    auto executor = std::make_shared<secdecutil::amplitude::ProcessExecutor<typename amplitudes_handler_t::integral_t>>();
+    std::istringstream commands(workers);
+    std::string command;
+    while (std::getline(commands, command))
+        if (!command.empty())
+            executor->add_worker(command, setup.str());
+    amplitudes.executor = executor;
+}
+
 extern "C"
 {
     /*
@@ -88,7 +134,9 @@ extern "C"
         const size_t reset_cuda_after,
         const bool verbose,
         const int errormode_enum,
-        const char *lib_path
+        const char *lib_path,
+        const char *workers, // shell commands that start a worker, one per line; empty to compute here
+        const char *integrator_description // how the workers allocate the integrator
     )
     {
         int i;
@@ -142,6 +190,12 @@ extern "C"
         if(verbose) std::cerr << "Integrating" << std::endl;
         std::vector<nested_series_t<secdecutil::UncorrelatedDeviation<integrand_return_t>>> result;
         try {
+            if(*workers)
+                add_workers
+                (
+                    amplitudes, workers, integrator_description, real_parameters, complex_parameters,
+                    deformation_parameters_maximum, deformation_parameters_minimum, deformation_parameters_decrease_factor, lib_path
+                );
             result = amplitudes.evaluate();
         } catch (std::exception& e){
             std::cerr << "Encountered an exception of type '" << typeid(e).name() << "'" << std::endl;
@@ -9,6 +9,8 @@
 #include <functional> // std::bind, std::placeholders
 #include <memory> // std::shared_ptr, std::make_shared
 #include <vector> // std::vector
+#include <unistd.h> // fork, pipe
+#include <sys/wait.h> // waitpid
 
 #ifdef SECDEC_WITH_CUDA
     #include <thrust/complex.h>
@@ -239,6 +241,178 @@ TEST_CASE( "Integration with CubaIntegral", "[Integral][CubaIntegral]" ) {
 };
 
 
+TEST_CASE( "Integration with TransformSelectingIntegral", "[Integral][TransformSelectingIntegral]" ) {
+
+    using integrand_t = secdecutil::IntegrandContainer</*integrand_return_t*/ double,/*x*/ double const * const,/*parameters*/ double>;
+    using none_integrator_t = secdecutil::integrators::Qmc</*integrand_return_t*/ double,/*maxdim*/4,integrators::transforms::None::type,integrand_t>;
+    using korobov_integrator_t = secdecutil::integrators::Qmc</*integrand_return_t*/ double,/*maxdim*/4,integrators::transforms::Korobov<3>::type,integrand_t>;
+    using integral_t = secdecutil::amplitude::Integral</*integrand_return_t*/ double,/*real_t*/ double>;
+    using none_integral_t = secdecutil::amplitude::QmcIntegral</*integrand_return_t*/ double,/*real_t*/ double, none_integrator_t, integrand_t>;
+    using korobov_integral_t = secdecutil::amplitude::QmcIntegral</*integrand_return_t*/ double,/*real_t*/ double, korobov_integrator_t, integrand_t>;
+    using sum_t = std::vector<secdecutil::amplitude::WeightedIntegral<integral_t,/*coefficient_t*/double>>;
+
+    const std::shared_ptr<none_integrator_t> none_integrator_ptr = std::make_shared<none_integrator_t>();
+    const std::shared_ptr<korobov_integrator_t> korobov_integrator_ptr = std::make_shared<korobov_integrator_t>();
+    none_integrator_ptr->randomgenerator.seed(42546);
+    korobov_integrator_ptr->randomgenerator.seed(42546);
+
+    const integrand_t simple_integrand_container = integrand_t(simple_integrand.number_of_integration_variables, [](double const * const x, secdecutil::ResultInfo * result_info){return simple_integrand(x);});
+    const integrand_t other_integrand_container = integrand_t(other_integrand.number_of_integration_variables, [](double const * const x, secdecutil::ResultInfo * result_info){return other_integrand(x);});
+
+    // the same amplitudes, once per transform
+    std::vector<std::vector<sum_t>> candidates;
+    for (int transform = 0; transform < 2; ++transform)
+    {
+        std::shared_ptr<integral_t> simple_integral_ptr, other_integral_ptr;
+        if (transform == 0) {
+            simple_integral_ptr = std::make_shared<none_integral_t>(none_integrator_ptr, simple_integrand_container);
+            other_integral_ptr = std::make_shared<none_integral_t>(none_integrator_ptr, other_integrand_container);
+        } else {
+            simple_integral_ptr = std::make_shared<korobov_integral_t>(korobov_integrator_ptr, simple_integrand_container);
+            other_integral_ptr = std::make_shared<korobov_integral_t>(korobov_integrator_ptr, other_integrand_container);
+        }
+        candidates.push_back({ sum_t{{simple_integral_ptr,2.},{other_integral_ptr,1.}}, sum_t{{simple_integral_ptr,3.}} });
+    }
+
+    std::vector<sum_t> amplitudes = secdecutil::amplitude::make_transform_selecting_amplitudes<sum_t>(candidates, {"none","korobov3"});
+
+    SECTION("integrals stay shared") {
+
+        REQUIRE( amplitudes.size() == 2 );
+        REQUIRE( amplitudes.at(0).size() == 2 );
+        REQUIRE( amplitudes.at(1).size() == 1 );
+        REQUIRE( amplitudes.at(0).at(0).integral == amplitudes.at(1).at(0).integral );
+        REQUIRE( amplitudes.at(0).at(0).integral != amplitudes.at(0).at(1).integral );
+        REQUIRE( amplitudes.at(1).at(0).coefficient == 3. );
+
+        using selecting_integral_t = secdecutil::amplitude::TransformSelectingIntegral<double,double>;
+        auto selecting_integral = std::dynamic_pointer_cast<selecting_integral_t>(amplitudes.at(0).at(0).integral);
+        REQUIRE( selecting_integral );
+        REQUIRE( selecting_integral->candidates.at(0) == candidates.at(0).at(0).at(0).integral );
+        REQUIRE( selecting_integral->candidates.at(1) == candidates.at(1).at(0).at(0).integral );
+
+    };
+
+    SECTION("compute()") {
+
+        const bool verbose = false;
+        auto integral_ptr = std::dynamic_pointer_cast<secdecutil::amplitude::TransformSelectingIntegral<double,double>>(amplitudes.at(0).at(0).integral);
+
+        integral_ptr->set_next_number_of_function_evaluations(10000);
+        integral_ptr->compute(verbose);
+
+        // the periodizing transform wins by orders of magnitude in the error
+        REQUIRE( integral_ptr->selected == 1 );
+        const unsigned long long int first_n = integral_ptr->get_number_of_function_evaluations();
+        REQUIRE( first_n >= 10000 );
+        REQUIRE( integral_ptr->get_integration_time() >= 0. );
+        REQUIRE_THAT(integral_ptr->get_integral_result().value, Catch::Matchers::WithinAbs(1./24., 1e-7));
+
+        // refinements only run the selected candidate
+        integral_ptr->set_next_number_of_function_evaluations(2*first_n);
+        integral_ptr->compute(verbose);
+        REQUIRE( integral_ptr->get_number_of_function_evaluations() > first_n );
+        REQUIRE( integral_ptr->candidates.at(1)->get_number_of_function_evaluations() == integral_ptr->get_number_of_function_evaluations() );
+        REQUIRE( integral_ptr->candidates.at(0)->get_number_of_function_evaluations() == first_n );
+
+    };
+
+};
+
+TEST_CASE( "Integration with CombinedIntegral", "[Integral][CombinedIntegral]" ) {
+
+    using integrand_t = secdecutil::IntegrandContainer</*integrand_return_t*/ double,/*x*/ double const * const,/*parameters*/ double>;
+    using integrator_t = secdecutil::integrators::Qmc</*integrand_return_t*/ double,/*maxdim*/4,integrators::transforms::Korobov<3>::type,integrand_t>;
+    using integral_t = secdecutil::amplitude::Integral</*integrand_return_t*/ double,/*real_t*/ double>;
+    using qmc_integral_t = secdecutil::amplitude::QmcIntegral</*integrand_return_t*/ double,/*real_t*/ double, integrator_t, integrand_t>;
+    using combined_integral_t = secdecutil::amplitude::CombinedIntegral</*integrand_return_t*/ double,/*real_t*/ double>;
+    using sum_t = std::vector<secdecutil::amplitude::WeightedIntegral<integral_t,/*coefficient_t*/double>>;
+
+    const std::shared_ptr<integrator_t> integrator_ptr = std::make_shared<integrator_t>();
+    integrator_ptr->randomgenerator.seed(42546);
+
+    // "2 * simple_integrand - partner_integrand" cancels up to "- x[0]", which integrates to -1/2
+    const integrand_t simple_integrand_container = integrand_t(simple_integrand.number_of_integration_variables, [](double const * const x, secdecutil::ResultInfo * result_info){return simple_integrand(x);});
+    const integrand_t partner_integrand_container = integrand_t
+    (
+        simple_integrand.number_of_integration_variables,
+        [](double const * const x, double const * p, secdecutil::ResultInfo * result_info){return 2. * simple_integrand(x) + p[0] * x[0];},
+        {{1.,1.,1.,1.}}
+    );
+    const integrand_t other_integrand_container = integrand_t(other_integrand.number_of_integration_variables, [](double const * const x, secdecutil::ResultInfo * result_info){return other_integrand(x);});
+
+    std::shared_ptr<integral_t> simple_integral_ptr = std::make_shared<qmc_integral_t>(integrator_ptr, simple_integrand_container);
+    std::shared_ptr<integral_t> partner_integral_ptr = std::make_shared<qmc_integral_t>(integrator_ptr, partner_integrand_container);
+    std::shared_ptr<integral_t> other_integral_ptr = std::make_shared<qmc_integral_t>(integrator_ptr, other_integrand_container);
+
+    std::vector<sum_t> sums = { sum_t{{simple_integral_ptr,2.},{other_integral_ptr,3.},{partner_integral_ptr,-1.}}, sum_t{{simple_integral_ptr,3.}} };
+
+    std::vector<int> dimensions;
+    std::vector<sum_t> amplitudes = secdecutil::amplitude::combine_integrals<sum_t>
+    (
+        sums,
+        [&integrator_ptr, &dimensions] (int number_of_integration_variables, const std::function<double(double const * const, secdecutil::ResultInfo*)>& integrand)
+        {
+            dimensions.push_back(number_of_integration_variables);
+            return std::make_shared<qmc_integral_t>(integrator_ptr, integrand_t(number_of_integration_variables, integrand));
+        }
+    );
+
+    SECTION("terms of the same dimension are combined") {
+
+        REQUIRE( dimensions == std::vector<int>{4} );
+        REQUIRE( simple_integral_ptr->get_number_of_integration_variables() == 4 );
+        REQUIRE( other_integral_ptr->get_number_of_integration_variables() == 5 );
+
+        REQUIRE( amplitudes.size() == 2 );
+        REQUIRE( amplitudes.at(0).size() == 2 );
+        auto combined_integral = std::dynamic_pointer_cast<combined_integral_t>(amplitudes.at(0).at(0).integral);
+        REQUIRE( combined_integral );
+        REQUIRE( amplitudes.at(0).at(0).coefficient == 1. );
+        REQUIRE( amplitudes.at(0).at(1).integral == other_integral_ptr );
+        REQUIRE( amplitudes.at(0).at(1).coefficient == 3. );
+        REQUIRE( combined_integral->parts == std::vector<std::shared_ptr<integral_t>>{simple_integral_ptr,partner_integral_ptr} );
+
+        // a single term is kept as it is
+        REQUIRE( amplitudes.at(1).size() == 1 );
+        REQUIRE( amplitudes.at(1).at(0).integral == simple_integral_ptr );
+        REQUIRE( amplitudes.at(1).at(0).coefficient == 3. );
+
+    };
+
+    SECTION("parameters of the parts") {
+
+        auto combined_integral = std::dynamic_pointer_cast<combined_integral_t>(amplitudes.at(0).at(0).integral);
+        std::vector<std::vector<double*>> parameters = combined_integral->get_parameters();
+        REQUIRE( parameters.size() == 1 );
+        REQUIRE( parameters.at(0).size() == 4 );
+
+        // changing the parameters through the combined integral changes the integrand of the part
+        *parameters.at(0).at(0) = 3.;
+        const double x[4] = {0.5,1.,1.,1.};
+        REQUIRE_THAT( partner_integral_ptr->evaluate_integrand(x, nullptr), Catch::Matchers::WithinAbs(2. * 0.5 + 3. * 0.5, 1e-15) );
+
+    };
+
+    SECTION("compute()") {
+
+        const bool verbose = false;
+        auto integral_ptr = amplitudes.at(0).at(0).integral;
+
+        integral_ptr->set_next_number_of_function_evaluations(10000);
+        integral_ptr->compute(verbose);
+
+        REQUIRE( integral_ptr->get_number_of_function_evaluations() >= 10000 );
+        REQUIRE_THAT(integral_ptr->get_integral_result().value, Catch::Matchers::WithinAbs(-0.5, 1e-7));
+        REQUIRE( integral_ptr->get_integral_result().uncertainty < 1e-7 );
+
+        // the parts themselves are not integrated
+        REQUIRE_THROWS_AS( simple_integral_ptr->get_integral_result(), secdecutil::amplitude::integral_not_computed_error );
+
+    };
+
+};
+
 TEST_CASE( "Operator overloads of WeightedIntegral", "[WeightedIntegral]" ) {
     
     using integrand_t = secdecutil::IntegrandContainer</*integrand_return_t*/ double,/*x*/ double const * const,/*parameters*/ double>;
@@ -466,6 +640,99 @@ TEST_CASE( "Optimized integration with WeightedIntegralHandler", "[WeightedInteg
 
     };
 
+    SECTION("computing the amplitude with worker processes") {
+
+        using sum_handler_t = secdecutil::amplitude::WeightedIntegralHandler</*integrand_return_t*/ double, /*real_t*/ double, /*coefficient_t*/ double, /*container_t*/ std::vector>;
+        using executor_t = secdecutil::amplitude::ProcessExecutor<integral_t>;
+        using qmc5_integrator_t = secdecutil::integrators::Qmc</*integrand_return_t*/ double,/*maxdim*/5,integrators::transforms::Korobov<6>::type,integrand_t>;
+        using qmc5_integral_t = secdecutil::amplitude::QmcIntegral</*integrand_return_t*/ double,/*real_t*/ double, qmc5_integrator_t, integrand_t>;
+
+        // The forked workers would share the state files of Cuba, use only Qmc here.
+        const std::shared_ptr<qmc5_integrator_t> qmc5_integrator_ptr = std::make_shared<qmc5_integrator_t>();
+        qmc5_integrator_ptr->randomgenerator.seed(42546);
+        std::shared_ptr<integral_t> simple_qmc_integral_ptr = std::make_shared<qmc5_integral_t>(qmc5_integrator_ptr, simple_integrand_container);
+        std::shared_ptr<integral_t> other_qmc_integral_ptr = std::make_shared<qmc5_integral_t>(qmc5_integrator_ptr, other_integrand_container);
+        std::vector<weighted_integral_sum_t> qmc_integral_sums
+            {
+                weighted_integral_sum_t{{simple_qmc_integral_ptr, 2.5}},
+                weighted_integral_sum_t{{simple_qmc_integral_ptr,12.5}} + weighted_integral_sum_t{{other_qmc_integral_ptr,1.2}},
+                weighted_integral_sum_t{{simple_qmc_integral_ptr,12.5}} + weighted_integral_sum_t{{other_qmc_integral_ptr,1.2}} + weighted_integral_sum_t{{other_qmc_integral_ptr,-1.2}}
+            };
+
+        double epsrel = 1e-8;
+
+        sum_handler_t sum_handler
+        (
+            qmc_integral_sums,
+            epsrel,
+            1e-20, // epsabs
+            1e6, // maxeval
+            1e2, // mineval
+            50., // maxincreasefac
+            1e-4, // min_epsrel
+            1e-7, // min_epsabs
+            1e-15, // max_epsrel
+            1e-18 // max_epsabs
+        );
+
+        // the workers are forked copies of this process serving the same expression
+        std::shared_ptr<executor_t> executor = std::make_shared<executor_t>();
+        std::vector<int> parent_fds;
+        std::vector<pid_t> pids;
+        for(int i = 0; i < 2; ++i)
+        {
+            int to_worker[2], from_worker[2];
+            REQUIRE( pipe(to_worker) == 0 );
+            REQUIRE( pipe(from_worker) == 0 );
+            pid_t pid = fork();
+            REQUIRE( pid >= 0 );
+            if(pid == 0)
+            {
+                for(int fd : parent_fds)
+                    close(fd);
+                dup2(to_worker[0], 0);
+                dup2(from_worker[1], 1);
+                close(to_worker[0]); close(to_worker[1]);
+                close(from_worker[0]); close(from_worker[1]);
+                sum_handler.serve(std::cin, std::cout);
+                _exit(0);
+            }
+            close(to_worker[0]);
+            close(from_worker[1]);
+            parent_fds.push_back(from_worker[0]);
+            parent_fds.push_back(to_worker[1]);
+            pids.push_back(pid);
+            executor->add_worker(from_worker[0], to_worker[1]);
+        }
+        REQUIRE( executor->number_of_workers() == 2 );
+
+        sum_handler.executor = executor;
+        sum_handler.verbose = true;
+        auto sum_results = sum_handler.evaluate();
+
+        for(size_t i = 0; i < sum_handler.expression.size(); ++i)
+        {
+            std::cout << "sum_results[" << i << "] = " << sum_results.at(i) << std::endl;
+            REQUIRE_THAT( sum_results.at(i).value, Catch::Matchers::WithinAbs(integral_sum_solutions.at(i), 3.*epsrel*std::abs(integral_sum_solutions.at(i))) );
+        }
+
+        // the integrals of the coordinator were not computed locally, but the results are stored
+        for(integral_t* integral : sum_handler.get_integrals())
+            REQUIRE( integral->get_number_of_function_evaluations() > 0 );
+
+        // closing the connections ends the workers
+        sum_handler.executor.reset();
+        executor.reset();
+        for(pid_t pid : pids)
+        {
+            int status;
+            REQUIRE( waitpid(pid, &status, 0) == pid );
+            REQUIRE( WIFEXITED(status) );
+            REQUIRE( WEXITSTATUS(status) == 0 );
+        }
+
+    };
+
     SECTION("amplitude precision with Vegas, together=false") {
         using integrand_t = secdecutil::IntegrandContainer</*integrand_return_t*/ complex_t,/*x*/ double const * const,/*parameters*/ double>;
         using integral_t = secdecutil::amplitude::Integral</*integrand_return_t*/ complex_t,/*real_t*/ double>;
@@ -0,0 +1,181 @@
+#include "catch_amalgamated.hpp"
+using Catch::Approx;
+
+#include "../secdecutil/integrand_container.hpp"
+#include "../secdecutil/integrators/integrator.hpp"
+#include "../secdecutil/integrators/digital_net.hpp"
+#include "../secdecutil/uncertainties.hpp"
+
+#include <complex>
+#ifdef SECDEC_WITH_CUDA
+    #include <thrust/complex.h>
+    template <typename ...T> using complex_template = thrust::complex<T...>;
+#else
+    template <typename ...T> using complex_template = std::complex<T...>;
+#endif
+#include <atomic>
+#include <cmath>
+#include <set>
+
+TEST_CASE( "Test primitive polynomials", "[DigitalNet]" ) {
+    REQUIRE( secdecutil::integrators::digital_net::primitive_polynomial(1) == 0b11 );
+    REQUIRE( secdecutil::integrators::digital_net::primitive_polynomial(3) == 0b1011 );
+    REQUIRE( secdecutil::integrators::digital_net::primitive_polynomial(4) == 0b10011 );
+    REQUIRE( secdecutil::integrators::digital_net::is_primitive(0b10011, 4) );
+    REQUIRE_FALSE( secdecutil::integrators::digital_net::is_primitive(0b11111, 4) ); // irreducible, but x has order 5
+};
+
+TEST_CASE( "Test interlaced polynomial lattice rule", "[DigitalNet]" ) {
+    const unsigned m = 10, order = 3, dimension = 4;
+    const secdecutil::integrators::digital_net::Rule rule = secdecutil::integrators::digital_net::construct_rule(m,order,dimension);
+
+    REQUIRE( rule.number_of_points() == 1024 );
+    REQUIRE( rule.exponents.size() == order*dimension );
+
+    // every interlaced component is a one dimensional polynomial lattice rule, i.e. a permutation of the 2^m digit patterns
+    for (unsigned j = 0; j < dimension; ++j)
+        for (unsigned l = 0; l < order; ++l)
+        {
+            std::set<uint64_t> digits{0};
+            for (uint64_t a = 0; a + 1 < rule.number_of_points(); ++a)
+            {
+                const uint64_t y = rule.point(a,j) >> (64 - order*m);
+                uint64_t component = 0;
+                for (unsigned i = 0; i < m; ++i)
+                    component |= ((y >> (order*i + order - 1 - l)) & 1) << i;
+                digits.insert(component);
+            }
+            REQUIRE( digits.size() == rule.number_of_points() );
+        }
+
+    // the construction is component by component
+    const secdecutil::integrators::digital_net::Rule smaller_rule = secdecutil::integrators::digital_net::construct_rule(m,order,dimension-1);
+    for (unsigned c = 0; c < order*(dimension-1); ++c)
+        REQUIRE( smaller_rule.exponents.at(c) == rule.exponents.at(c) );
+};
+
+TEST_CASE( "Test digital net rule size limit", "[DigitalNet]" ) {
+    using secdecutil::integrators::digital_net::largest_m;
+    using secdecutil::integrators::digital_net::construction_memory;
+    const uint64_t two_gigabytes = uint64_t(1) << 31;
+
+    REQUIRE( largest_m(1, two_gigabytes) == 24 );
+    REQUIRE( largest_m(2, two_gigabytes) == 24 );
+    REQUIRE( largest_m(3, two_gigabytes) == 21 ); // 64 bits hold 21 interlaced digits
+    REQUIRE( construction_memory(24) <= two_gigabytes );
+    REQUIRE( construction_memory(25) > two_gigabytes );
+    REQUIRE( largest_m(2, 1) == 1 );
+};
+
+TEST_CASE( "Test digital net integrator", "[DigitalNet]" ) {
+    constexpr int dimensionality = 4;
+    double exact = 1.;
+    for (int j = 1; j <= dimensionality; ++j)
+        exact *= 1. + 1./j;
+
+    SECTION( "real" ) {
+        const std::function<double(double const * const, secdecutil::ResultInfo*)> integrand = [] (double const * const x, secdecutil::ResultInfo* result_info)
+        {
+            double out = 1.;
+            for (int j = 0; j < dimensionality; ++j)
+                out *= 1. + x[j]*std::exp(x[j])/(j+1);
+            return out;
+        };
+        const auto integrand_container = secdecutil::IntegrandContainer<double, double const * const>(dimensionality,integrand);
+
+        for (unsigned order = 1; order <= 3; ++order)
+        {
+            secdecutil::integrators::DigitalNet<double> integrator;
+            integrator.order = order;
+            integrator.epsrel = 1e-6;
+            integrator.epsabs = 0.;
+            integrator.minn = 1024;
+            integrator.maxeval = 1e8;
+            integrator.randomgenerator.seed(42);
+            const auto result = integrator.integrate(integrand_container);
+
+            REQUIRE( result.value == Approx(exact).epsilon(1e-5) );
+            REQUIRE( result.uncertainty <= 1e-6*exact );
+        }
+    }
+
+    SECTION( "complex" ) {
+        const std::function<complex_template<double>(double const * const, secdecutil::ResultInfo*)> integrand = [] (double const * const x, secdecutil::ResultInfo* result_info)
+        {
+            double out = 1.;
+            for (int j = 0; j < dimensionality; ++j)
+                out *= 1. + x[j]*std::exp(x[j])/(j+1);
+            return complex_template<double>{out, -2*x[0]*x[1]};
+        };
+        const auto integrand_container = secdecutil::IntegrandContainer<complex_template<double>, double const * const>(dimensionality,integrand);
+
+        secdecutil::integrators::DigitalNet<complex_template<double>> integrator;
+        integrator.epsrel = 1e-6;
+        integrator.epsabs = 0.;
+        integrator.maxeval = 1e8;
+        integrator.cputhreads = 2;
+        REQUIRE( integrator.together );
+        const auto result = integrator.integrate(integrand_container);
+
+        REQUIRE( result.value.real() == Approx(exact).epsilon(1e-5) );
+        REQUIRE( result.value.imag() == Approx(-0.5).epsilon(1e-5) );
+        REQUIRE( result.uncertainty.real() <= 1e-6*exact );
+        REQUIRE( result.uncertainty.imag() <= 1e-6*0.5 );
+    }
+};
+
+TEST_CASE( "Test digital net maxeval", "[DigitalNet]" ) {
+    // the requested accuracy is out of reach, the integration stops at "maxeval"
+    std::atomic<uint64_t> calls(0);
+    const std::function<double(double const * const, secdecutil::ResultInfo*)> integrand = [&calls] (double const * const x, secdecutil::ResultInfo* result_info)
+        { ++calls; return 1./std::sqrt(x[0]) + x[1]; };
+    const auto integrand_container = secdecutil::IntegrandContainer<double, double const * const>(2,integrand);
+
+    SECTION( "default" ) {
+        secdecutil::integrators::DigitalNet<double> integrator;
+        integrator.epsrel = 1e-15;
+        integrator.randomgenerator.seed(42);
+        const auto result = integrator.integrate(integrand_container);
+
+        REQUIRE( calls <= integrator.maxeval );
+        REQUIRE( calls > integrator.maxeval/2 );
+        REQUIRE( result.value == Approx(2.5).epsilon(1e-3) );
+    }
+
+    SECTION( "largest rule" ) {
+        // beyond the largest rule, only the number of shifts grows
+        secdecutil::integrators::DigitalNet<double> integrator;
+        integrator.epsrel = 1e-15;
+        integrator.minn = 1024;
+        integrator.maxeval = 300000;
+        integrator.maxmemory = secdecutil::integrators::digital_net::construction_memory(10);
+        integrator.randomgenerator.seed(42);
+        integrator.integrate(integrand_container);
+
+        REQUIRE( calls <= integrator.maxeval );
+        REQUIRE( calls > integrator.maxeval/2 );
+    }
+};
+
+TEST_CASE( "Test digital net copy constructor", "[DigitalNet]" ) {
+    secdecutil::integrators::DigitalNet<complex_template<double>> original;
+    original.epsrel = 1e-3;
+    original.order = 3;
+    original.minm = 16;
+    const secdecutil::integrators::DigitalNet<complex_template<double>> copy = original;
+
+    REQUIRE( copy.epsrel == original.epsrel );
+    REQUIRE( copy.order == original.order );
+    REQUIRE( copy.minm == original.minm );
+    REQUIRE( copy.together );
+};
+
+TEST_CASE( "Test result_info sign check error with digital net", "[DigitalNet]" ) {
+    const std::function<double(double const * const, secdecutil::ResultInfo*)> integrand = [] (double const * const x, secdecutil::ResultInfo* result_info)
+        { result_info->return_value = secdecutil::ResultInfo::ReturnValue::sign_check_error_contour_deformation; return 0; };
+    const auto integrand_container = secdecutil::IntegrandContainer<double, double const * const>(2,integrand);
+    secdecutil::integrators::DigitalNet<double> integrator;
+
+    REQUIRE_THROWS_AS( integrator.integrate(integrand_container) , secdecutil::sign_check_error );
+    REQUIRE_THROWS_WITH( integrator.integrate(integrand_container) , Catch::Matchers::ContainsSubstring( "contour deformation" ) );
+};
@@ -13,8 +13,10 @@ using Catch::Approx;
 #else
     template <typename ...T> using complex_template = std::complex<T...>;
 #endif
+#include <atomic>
 #include <cmath>
 #include <cuba.h>
+#include <memory>
 #include <string>
 
 #ifdef SECDEC_WITH_CUDA
@@ -90,3 +92,267 @@ TEST_CASE( "Test result_info positive polynomial sign check error with qmc", "[I
     REQUIRE_THROWS_WITH( integrator.integrate(integrand_container) , Catch::Matchers::ContainsSubstring( "positive polynomial" ) );
 };
 
+
+TEST_CASE( "Test qmc with adaptive domain subdivision", "[Qmc]" ) {
+
+    using integrand_t = secdecutil::IntegrandContainer</*integrand_return_t*/ double,/*x*/ double const * const,/*parameters*/ double>;
+    using complex_integrand_t = secdecutil::IntegrandContainer</*integrand_return_t*/ complex_template<double>,/*x*/ double const * const,/*parameters*/ double>;
+
+    // integrable peak at x[0] = 0, too strong for the first lattice to reach the requested accuracy
+    const double eps = 1e-6;
+    const double target = 10.*(std::pow(1.+eps,0.1)-std::pow(eps,0.1));
+
+    const int dimensionality = 2;
+
+    SECTION( "real" ) {
+
+        const integrand_t integrand_container = secdecutil::IntegrandContainer<double, double const * const>(dimensionality,
+            [eps] (double const * const x, secdecutil::ResultInfo* result_info) { return 2.*x[1]*std::pow(x[0]+eps,-0.9); });
+        auto integrator = secdecutil::integrators::Qmc<double,dimensionality,integrators::transforms::Korobov<1>::type, integrand_t>();
+        integrator.randomgenerator.seed(42523);
+        integrator.epsrel = 1e-4;
+        integrator.maxeval = 100000000;
+        integrator.subdivisiondepth = 3;
+
+        secdecutil::UncorrelatedDeviation<double> result = integrator.integrate(integrand_container);
+        REQUIRE( result.uncertainty <= 1e-4 * target );
+        REQUIRE( result.value == Approx(target).epsilon(5e-4) );
+
+    };
+
+    SECTION( "complex" ) {
+
+        const complex_integrand_t integrand_container = secdecutil::IntegrandContainer<complex_template<double>, double const * const>(dimensionality,
+            [eps] (double const * const x, secdecutil::ResultInfo* result_info) { return complex_template<double>(1.,-3.)*2.*x[1]*std::pow(x[0]+eps,-0.9); });
+        auto integrator = secdecutil::integrators::Qmc<complex_template<double>,dimensionality,integrators::transforms::Korobov<1>::type, complex_integrand_t>();
+        integrator.randomgenerator.seed(42523);
+        integrator.epsrel = 1e-4;
+        integrator.maxeval = 100000000;
+        integrator.subdivisiondepth = 3;
+
+        secdecutil::UncorrelatedDeviation<complex_template<double>> result = integrator.integrate(integrand_container);
+        REQUIRE( result.value.real() == Approx(target).epsilon(5e-4) );
+        REQUIRE( result.value.imag() == Approx(-3.*target).epsilon(5e-4) );
+
+    };
+
+    SECTION( "no split" ) {
+
+        // the variance is spread evenly, so no split pays off; the evaluations of the first iteration
+        // are not repeated when the budget is used up
+        std::shared_ptr<std::atomic<unsigned long long>> calls = std::make_shared<std::atomic<unsigned long long>>(0);
+        const integrand_t integrand_container = secdecutil::IntegrandContainer<double, double const * const>(dimensionality,
+            [calls] (double const * const x, secdecutil::ResultInfo* result_info) { ++*calls; return std::sin(64.*x[0]) + std::sin(64.*x[1]); });
+        auto integrator = secdecutil::integrators::Qmc<double,dimensionality,integrators::transforms::Korobov<1>::type, integrand_t>();
+        integrator.randomgenerator.seed(42523);
+        integrator.epsrel = 1e-10;
+        integrator.maxeval = 1;
+
+        integrator.integrate(integrand_container);
+        const unsigned long long first_iteration = *calls;
+        *calls = 0;
+        integrator.subdivisiondepth = 3;
+        integrator.integrate(integrand_container);
+        REQUIRE( *calls > first_iteration );
+        REQUIRE( *calls - first_iteration < first_iteration );
+
+    };
+
+    SECTION( "box" ) {
+
+        using box_t = secdecutil::integrators::QmcContainer<integrand_t,double,dimensionality>;
+
+        const integrand_t integrand_container = secdecutil::IntegrandContainer<double, double const * const>(dimensionality,
+            [] (double const * const x, secdecutil::ResultInfo* result_info) { return x[1]; });
+        const box_t box(integrand_container);
+        const box_t piece = box.refine(1, 0.5, 1.).refine(1, 0., 0.5);
+        const double x[] = {0.3, 0.5};
+        REQUIRE( piece.splits == 1 );
+        REQUIRE( piece.jacobian == 0.25 );
+        REQUIRE( piece(x) == 0.25*0.625 );
+
+        // only the split variables are stored
+        REQUIRE( sizeof(secdecutil::integrators::QmcContainer<integrand_t,double,100>) == sizeof(box_t) );
+
+    };
+
+};
+
+TEST_CASE( "Test qmc transform selection", "[Qmc][QmcTransformSelection]" ) {
+
+    using integrand_t = secdecutil::IntegrandContainer</*integrand_return_t*/ double,/*x*/ double const * const,/*parameters*/ double>;
+    using complex_integrand_t = secdecutil::IntegrandContainer</*integrand_return_t*/ complex_template<double>,/*x*/ double const * const,/*parameters*/ double>;
+
+    const int dimensionality = 3;
+
+    SECTION( "select" ) {
+
+        REQUIRE( secdecutil::integrators::transform_selection::select<double>({1e-3,1e-6,1e-5},{1.,2.,0.01}) == 2 );
+        REQUIRE( secdecutil::integrators::transform_selection::select<double>({NAN,1e-6},{1.,1.}) == 1 );
+        REQUIRE( secdecutil::integrators::transform_selection::select<double>({NAN,NAN},{1.,1.}) == 0 );
+
+    };
+
+    SECTION( "combine" ) {
+
+        using secdecutil::integrators::transform_selection::combine;
+
+        using ud_t = secdecutil::UncorrelatedDeviation<double>;
+        ud_t result = combine(ud_t(1.,1.),ud_t(4.,2.));
+        REQUIRE( result.value == Approx(1.6) );
+        REQUIRE( result.uncertainty == Approx(std::sqrt(0.8)) );
+
+        result = combine(ud_t(NAN,1.),ud_t(4.,2.));
+        REQUIRE( result.value == 4. );
+        REQUIRE( result.uncertainty == 2. );
+
+        using complex_t = complex_template<double>;
+        const secdecutil::UncorrelatedDeviation<complex_t> a(complex_t(1.,5.),complex_t(1.,0.)), b(complex_t(4.,3.),complex_t(2.,1.));
+        secdecutil::UncorrelatedDeviation<complex_t> complex_result = combine(a,b);
+        REQUIRE( complex_result.value.real() == Approx(1.6) );
+        REQUIRE( complex_result.uncertainty.real() == Approx(std::sqrt(0.8)) );
+        REQUIRE( complex_result.value.imag() == 3. );
+        REQUIRE( complex_result.uncertainty.imag() == 1. );
+
+    };
+
+    SECTION( "accurate pilot" ) {
+
+        // the pilot of the selected transform is accurate enough, no further lattice is needed
+        std::shared_ptr<std::atomic<long>> calls = std::make_shared<std::atomic<long>>(0);
+        const integrand_t integrand_container = secdecutil::IntegrandContainer<double, double const * const>(dimensionality,
+            [calls] (double const * const x, secdecutil::ResultInfo* result_info) { ++*calls; return x[0]*x[1]*x[2]; });
+        secdecutil::integrators::QmcTransformSelection<double,double,integrand_t> selection;
+        auto korobov = new secdecutil::integrators::Qmc<double,dimensionality,integrators::transforms::Korobov<3>::type,integrand_t>();
+        korobov->randomgenerator.seed(42523);
+        korobov->epsrel = 1e-2;
+        selection.add_candidate("korobov3", korobov);
+
+        selection.select(integrand_container);
+        const long pilot_calls = *calls;
+        secdecutil::UncorrelatedDeviation<double> result = selection.integrate(integrand_container);
+        REQUIRE( *calls == 2*pilot_calls );
+        REQUIRE( result.value == Approx(0.125).epsilon(1e-2) );
+
+    };
+
+    SECTION( "real" ) {
+
+        // smooth but not periodic, the periodizing transform is much more efficient than none
+        const integrand_t integrand_container = secdecutil::IntegrandContainer<double, double const * const>(dimensionality,
+            [] (double const * const x, secdecutil::ResultInfo* result_info) { return x[0]*x[1]*x[2]; });
+        secdecutil::integrators::QmcTransformSelection<double,double,integrand_t> selection;
+        auto none = new secdecutil::integrators::Qmc<double,dimensionality,integrators::transforms::None::type,integrand_t>();
+        auto korobov = new secdecutil::integrators::Qmc<double,dimensionality,integrators::transforms::Korobov<3>::type,integrand_t>();
+        none->randomgenerator.seed(42523);
+        korobov->randomgenerator.seed(42523);
+        none->epsrel = korobov->epsrel = 1e-6;
+        selection.add_candidate("none", none);
+        selection.add_candidate("korobov3", korobov);
+
+        REQUIRE( selection.names == std::vector<std::string>{"none","korobov3"} );
+        REQUIRE( selection.select(integrand_container) == 1 );
+
+        secdecutil::UncorrelatedDeviation<double> result = selection.integrate(integrand_container);
+        REQUIRE( result.value == Approx(0.125).epsilon(1e-6) );
+
+    };
+
+    SECTION( "complex" ) {
+
+        const complex_integrand_t integrand_container = secdecutil::IntegrandContainer<complex_template<double>, double const * const>(dimensionality,
+            [] (double const * const x, secdecutil::ResultInfo* result_info) { return complex_template<double>(1.,-3.)*x[0]*x[1]*x[2]; });
+        secdecutil::integrators::QmcTransformSelection<complex_template<double>,double,complex_integrand_t> selection;
+        auto none = new secdecutil::integrators::Qmc<complex_template<double>,dimensionality,integrators::transforms::None::type,complex_integrand_t>();
+        auto korobov = new secdecutil::integrators::Qmc<complex_template<double>,dimensionality,integrators::transforms::Korobov<3>::type,complex_integrand_t>();
+        none->randomgenerator.seed(42523);
+        korobov->randomgenerator.seed(42523);
+        none->epsrel = korobov->epsrel = 1e-6;
+        selection.add_candidate("none", none);
+        selection.add_candidate("korobov3", korobov);
+
+        REQUIRE( selection.select(integrand_container) == 1 );
+
+        secdecutil::UncorrelatedDeviation<complex_template<double>> result = selection.integrate(integrand_container);
+        REQUIRE( result.value.real() == Approx(0.125).epsilon(1e-6) );
+        REQUIRE( result.value.imag() == Approx(-0.375).epsilon(1e-6) );
+
+    };
+
+};
+
+TEST_CASE( "Test qmc integrate_together", "[Qmc]" ) {
+
+    using integrand_t = secdecutil::IntegrandContainer</*integrand_return_t*/ double,/*x*/ double const * const,/*parameters*/ double>;
+    using complex_integrand_t = secdecutil::IntegrandContainer</*integrand_return_t*/ complex_template<double>,/*x*/ double const * const,/*parameters*/ double>;
+
+    const int dimensionality = 3;
+
+    SECTION( "real" ) {
+
+        // the integrands converge at very different lattice sizes
+        std::vector<integrand_t> integrands;
+        integrands.push_back(integrand_t(dimensionality, [] (double const * const x, secdecutil::ResultInfo* result_info) { return 1.; }));
+        integrands.push_back(integrand_t(dimensionality, [] (double const * const x, secdecutil::ResultInfo* result_info) { return x[0]*x[1]*x[2]; }));
+        integrands.push_back(integrand_t(dimensionality, [] (double const * const x, secdecutil::ResultInfo* result_info) { return 1./std::sqrt(x[0]); }));
+
+        secdecutil::integrators::Qmc<double,dimensionality,integrators::transforms::Korobov<3>::type,integrand_t> integrator;
+        integrator.randomgenerator.seed(42546);
+        integrator.epsrel = 1e-6;
+        integrator.epsabs = 1e-10;
+        integrator.maxeval = 100000000;
+
+        std::vector<secdecutil::UncorrelatedDeviation<double>> results = secdecutil::integrators::integrate_together(integrator, integrands);
+        REQUIRE( results.size() == 3 );
+        REQUIRE( results.at(0).value == Approx(1.).epsilon(1e-8) );
+        REQUIRE( results.at(1).value == Approx(0.125).epsilon(1e-5) );
+        REQUIRE( results.at(2).value == Approx(2.).epsilon(1e-5) );
+        REQUIRE( results.at(1).uncertainty <= 1e-6*0.125*1.01 );
+
+    };
+
+    SECTION( "complex" ) {
+
+        std::vector<complex_integrand_t> integrands;
+        for (int k = 1; k <= 2; ++k)
+            integrands.push_back(complex_integrand_t(dimensionality,
+                [k] (double const * const x, secdecutil::ResultInfo* result_info) { return complex_template<double>(k,-3.)*x[0]*x[1]*x[2]; }));
+
+        secdecutil::integrators::Qmc<complex_template<double>,dimensionality,integrators::transforms::Korobov<3>::type,complex_integrand_t> integrator;
+        integrator.randomgenerator.seed(42546);
+        integrator.epsrel = 1e-6;
+
+        std::vector<secdecutil::UncorrelatedDeviation<complex_template<double>>> results = secdecutil::integrators::integrate_together(integrator, integrands);
+        REQUIRE( results.at(0).value.real() == Approx(0.125).epsilon(1e-5) );
+        REQUIRE( results.at(0).value.imag() == Approx(-0.375).epsilon(1e-5) );
+        REQUIRE( results.at(1).value.real() == Approx(0.25).epsilon(1e-5) );
+        REQUIRE( results.at(1).value.imag() == Approx(-0.375).epsilon(1e-5) );
+
+    };
+
+    SECTION( "different dimensions" ) {
+
+        std::vector<integrand_t> integrands;
+        integrands.push_back(integrand_t(dimensionality, [] (double const * const x, secdecutil::ResultInfo* result_info) { return 1.; }));
+        integrands.push_back(integrand_t(dimensionality-1, [] (double const * const x, secdecutil::ResultInfo* result_info) { return 1.; }));
+
+        secdecutil::integrators::Qmc<double,dimensionality,integrators::transforms::Korobov<3>::type,integrand_t> integrator;
+        REQUIRE_THROWS_AS( secdecutil::integrators::integrate_together(integrator, integrands), std::invalid_argument );
+
+    };
+
+    SECTION( "exception in an integrand" ) {
+
+        // the exceptions thrown in the sampling threads reach the caller
+        std::vector<integrand_t> integrands;
+        integrands.push_back(integrand_t(dimensionality, [] (double const * const x, secdecutil::ResultInfo* result_info) { return 1.; }));
+        integrands.push_back(integrand_t(dimensionality, [] (double const * const x, secdecutil::ResultInfo* result_info)
+            { if (x[0] > 0.9) throw std::runtime_error("sign check error"); return x[0]; }));
+
+        secdecutil::integrators::Qmc<double,dimensionality,integrators::transforms::Korobov<3>::type,integrand_t> integrator;
+        integrator.cputhreads = 4;
+        REQUIRE_THROWS_AS( secdecutil::integrators::integrate_together(integrator, integrands), std::runtime_error );
+
+    };
+
+};